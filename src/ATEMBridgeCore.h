@@ -0,0 +1,2348 @@
+/*
+ * ATEM Bridge Core for the ESP32 ATEM Tally System
+ *
+ * The bridge logic shared by every bridge build. Each bridge sketch is a
+ * thin configuration that picks the template parameters and a tally source:
+ *
+ *   ATEMBridgeCore<MaxCameras, MaxDevices, StandbyAsPreview, LogLevel, TallySource>
+ *
+ * - MaxCameras       - Camera inputs tracked (sizes the tally state table)
+ * - MaxDevices       - Simultaneous BLE tally connections (sizes device table
+ *                      and timer wheel)
+ * - StandbyAsPreview - Show non-active cameras as PREVIEW while production
+ *                      is active
+ * - LogLevel         - BRIDGE_LOG_ERROR / INFO / DEBUG; everything above the
+ *                      chosen level (messages, diagnostic commands, BENCH)
+ *                      compiles away
+ * - TallySource      - Where tally flags come from (ATEMminSource,
+ *                      ATEMLiteSource)
+ *
+ * String and timing settings are macros; define them before including this
+ * header to override the defaults below. BRIDGE_TALLY_OTA 0 leaves out tally
+ * firmware distribution (HTTP client, OTA characteristic) for small builds.
+ * BRIDGE_CENTRAL 1 swaps the BLE roles: the bridge connects to advertising
+ * tallies (BridgeCentral.h) instead of running a GATT server.
+ */
+
+#ifndef ATEM_BRIDGE_CORE_H
+#define ATEM_BRIDGE_CORE_H
+
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLEUtils.h>
+#include <BLE2902.h>
+#include <esp_gatts_api.h>
+#include <WiFi.h>
+#include <freertos/event_groups.h>
+#include "TallyProtocol.h"
+#include "TallyClock.h"
+#include "TimerWheel.h"
+#include "SeqLock.h"
+#include "AtemHealth.h"
+#include "ReconnectBackoff.h"
+#include "AdvertisingPolicy.h"
+
+#ifndef BRIDGE_CENTRAL
+#define BRIDGE_CENTRAL 0                      // 1 = bridge is the BLE central, tallies advertise
+#endif
+#ifndef BRIDGE_TALLY_OTA
+#define BRIDGE_TALLY_OTA !BRIDGE_CENTRAL      // Distribute tally firmware over BLE (OTA commands)
+#endif
+#if BRIDGE_CENTRAL && BRIDGE_TALLY_OTA
+#error "Tally OTA needs the GATT server topology (BRIDGE_CENTRAL 0)"
+#endif
+#if BRIDGE_TALLY_OTA
+#include "TallyOtaSender.h"
+#endif
+#if BRIDGE_CENTRAL
+#include "BridgeCentral.h"
+#endif
+
+#define BRIDGE_LOG_ERROR 0                    // Errors, startup banner and SIZE/STATUS only
+#define BRIDGE_LOG_INFO 1                     // + connection/registration/tally changes, diagnostics
+#define BRIDGE_LOG_DEBUG 2                    // + per-frame logging, manual tally test, BENCH
+
+// ===============================================
+// DEFAULT CONFIGURATION
+// ===============================================
+
+#ifndef ATEM_IP
+#define ATEM_IP "192.168.1.100"             // ATEM switcher IP address on Ethernet network
+#endif
+#ifndef BLE_DEVICE_NAME
+#define BLE_DEVICE_NAME "ATEM_Bridge_BLE"   // This device's BLE name
+#endif
+#ifndef BLE_SERVICE_UUID
+#define BLE_SERVICE_UUID "12345678-1234-5678-9abc-123456789abc"
+#endif
+#ifndef BLE_CHARACTERISTIC_UUID
+#define BLE_CHARACTERISTIC_UUID "87654321-4321-8765-cba9-987654321cba"
+#endif
+#ifndef BLE_SNAPSHOT_UUID
+#define BLE_SNAPSHOT_UUID "87654321-4321-8765-cba9-987654321cbb"
+#endif
+#ifndef BLE_OTA_UUID
+#define BLE_OTA_UUID "87654321-4321-8765-cba9-987654321cbc"
+#endif
+#ifndef NETWORK_CHECK_INTERVAL
+#define NETWORK_CHECK_INTERVAL 30000        // Network connectivity check interval (ms)
+#endif
+#ifndef NETWORK_POLL_INTERVAL
+#define NETWORK_POLL_INTERVAL 500           // Address check while waiting for USB tethering (ms)
+#endif
+#ifndef NETWORK_WAIT_TIMEOUT
+#define NETWORK_WAIT_TIMEOUT 30000          // Report tethering unavailable after (ms) - polling goes on
+#endif
+#ifndef NETWORK_SETTLE_TIME
+#define NETWORK_SETTLE_TIME 2000            // Wait after a recovered network before the ATEM handshake (ms)
+#endif
+#ifndef ATEM_RECONNECT_INTERVAL
+#define ATEM_RECONNECT_INTERVAL 10000       // Longest wait between ATEM reconnection attempts (ms)
+#endif
+#ifndef ATEM_RETRY_INTERVAL
+#define ATEM_RETRY_INTERVAL 250             // Backoff base after the immediate first retry (ms)
+#endif
+#ifndef ATEM_HANDSHAKE_TIMEOUT
+#define ATEM_HANDSHAKE_TIMEOUT 500          // Handshake silence before the attempt counts as failed (ms)
+#endif
+#ifndef ATEM_HANDSHAKE_POLL_INTERVAL
+#define ATEM_HANDSHAKE_POLL_INTERVAL 2      // ATEM poll interval while the initial state dump arrives (ms)
+#endif
+#ifndef ATEM_RESUME_WINDOW
+#define ATEM_RESUME_WINDOW 5000             // Serve last known tally states as unconfirmed this long (ms)
+#endif
+#ifndef ATEM_DEGRADED_TIMEOUT
+#define ATEM_DEGRADED_TIMEOUT 400           // Switcher silence before the session counts as degraded (ms)
+#endif
+#ifndef ATEM_DEAD_TIMEOUT
+#define ATEM_DEAD_TIMEOUT 800               // Switcher silence before tallies are told NO_ATEM (ms)
+#endif
+#ifndef TALLY_CHECK_INTERVAL
+#define TALLY_CHECK_INTERVAL 25             // ATEM poll + tally diff interval (ms) - bounds cut latency
+#endif
+#ifndef HEARTBEAT_INTERVAL
+#define HEARTBEAT_INTERVAL 5000             // Default heartbeat interval if tally requests none (ms)
+#endif
+#ifndef HEARTBEAT_MIN_INTERVAL
+#define HEARTBEAT_MIN_INTERVAL 100          // Fastest heartbeat period a tally may negotiate (ms)
+#endif
+#ifndef LOOP_IDLE_TIMEOUT
+#define LOOP_IDLE_TIMEOUT 1000              // Longest main loop sleep with no events or timers (ms)
+#endif
+#ifndef NOTIFY_MAX_IN_FLIGHT
+#define NOTIFY_MAX_IN_FLIGHT 4              // Unconfirmed notifications allowed per link
+#endif
+#ifndef NOTIFY_CONFIRM_TIMEOUT
+#define NOTIFY_CONFIRM_TIMEOUT 1000         // Assume a lost confirmation after this long (ms)
+#endif
+#ifndef ADV_FAST_INTERVAL
+#define ADV_FAST_INTERVAL 20                // Advertising interval while a tally is expected back (ms)
+#endif
+#ifndef ADV_SLOW_INTERVAL
+#define ADV_SLOW_INTERVAL 500               // Advertising interval with every expected tally connected (ms)
+#endif
+#ifndef ADV_BURST_WINDOW
+#define ADV_BURST_WINDOW 30000              // Fast advertising after boot and any tally disconnect (ms)
+#endif
+#ifndef ADV_MISSING_WINDOW
+#define ADV_MISSING_WINDOW 300000           // Keep fast while a registered tally is missing, up to (ms)
+#endif
+#ifndef SHOW_DEFERRED_SLACK
+#define SHOW_DEFERRED_SLACK 10              // Show mode: run deferred work only this far ahead of the next timer (ms)
+#endif
+#ifndef SERIAL_LINE_MAX
+#define SERIAL_LINE_MAX 128                 // Longest serial command line kept
+#endif
+#ifndef CENTRAL_SCAN_INTERVAL
+#define CENTRAL_SCAN_INTERVAL 1000          // Look for missing tallies this often (ms, BRIDGE_CENTRAL)
+#endif
+#ifndef OTA_FETCH_INTERVAL
+#define OTA_FETCH_INTERVAL 10               // Image download step while OTA FETCH runs (ms)
+#endif
+#ifndef TALLY_NAME_LENGTH
+#define TALLY_NAME_LENGTH 32                // Longest tally name kept, including the terminator
+#endif
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS 10000              // Iterations per BENCH microbenchmark
+#endif
+
+// ===============================================
+// DATA STRUCTURES
+// ===============================================
+
+// BLE tally device information (fixed size - published through a SeqLock)
+typedef struct {
+    char deviceName[TALLY_NAME_LENGTH];
+    uint8_t cameraId;
+    unsigned long lastSeen;
+    bool connected;
+    bool registered;
+    BLECharacteristic* characteristic;
+    uint16_t connId;                 // BLE connection the device registered on
+    uint16_t heartbeatInterval;      // Negotiated heartbeat period (ms)
+} TallyDevice;
+
+// ===============================================
+// BRIDGE CORE
+// ===============================================
+
+template <uint8_t MaxCameras, uint8_t MaxDevices, bool StandbyAsPreview, uint8_t LogLevel, class TallySource>
+class ATEMBridgeCore {
+public:
+    explicit ATEMBridgeCore(TallySource& tallySource) : atem(tallySource) {
+        instance = this;
+        memset(currentTallyStates, 0, sizeof(currentTallyStates));
+    }
+
+    // Bring up timers, BLE and network (call from setup() after Serial.begin)
+    void begin() {
+        systemStartTime = clockMillis();
+
+        Serial.println("\n==========================================");
+        Serial.println("ESP32 ATEM Bridge v3.0");
+        Serial.printf("BLE Multi-Device + %s\n", atem.name());
+        Serial.println("USB Tethering Mode (No WiFi)");
+        Serial.println("==========================================");
+
+        // Print device information
+        Serial.printf("Bridge Device: %s\n", BLE_DEVICE_NAME);
+        Serial.printf("Max Devices: %d simultaneous connections\n", MaxDevices);
+        Serial.printf("Cameras: %d\n", MaxCameras);
+        Serial.printf("ATEM Target: %s (%s)\n", ATEM_IP, atem.name());
+        Serial.printf("Free Heap: %d bytes\n", ESP.getFreeHeap());
+
+        // Create scheduled work
+        initializeTimers();
+
+        // Initialize BLE server
+        if (!initializeBLE()) {
+            Serial.println("BLE initialization failed - stopping");
+            while(1) delay(1000);
+        }
+
+        // Wait for the USB tethering network in the background (the ATEM
+        // handshake starts once it is up)
+        Serial.println("\nInitializing USB tethering network...");
+        initializeNetwork(0);
+
+        Serial.println("\n==========================================");
+        Serial.println("ESP32 Tally Bridge Ready!");
+        Serial.println("Type HELP for available commands");
+        Serial.println("Monitoring ATEM for tally changes...");
+        Serial.println("Waiting for BLE tally devices to connect...");
+        Serial.println("==========================================\n");
+
+        timers.start(tallyCheckTimer, TALLY_CHECK_INTERVAL, TALLY_CHECK_INTERVAL);
+        timers.start(loopStatsTimer, 1000, 1000);
+        lastHeartbeat = clockMillis();
+    }
+
+    // One main loop pass (call from loop())
+    void loop() {
+        loopCount++;
+
+        // Show mode switched over the control protocol (BLE task)
+        if (showRequest != SHOW_REQUEST_NONE) {
+            setShowMode(showRequest == SHOW_REQUEST_ON, "control");
+            showRequest = SHOW_REQUEST_NONE;
+        }
+
+        // Run due scheduled work (ATEM poll and tally diff, heartbeats, network checks)
+        timers.advance();
+
+        // Handle serial commands (show mode: in the deferred budget)
+        if (!showMode) {
+            handleSerialCommands();
+        }
+
+        // Send frames queued this pass (tally changes, heartbeats, registration replies)
+        flushPendingFrames();
+
+        // Follow tally connects and disconnects with the advertising interval
+        if (!BRIDGE_CENTRAL) {
+            updateAdvertising();
+        }
+
+        // Incidental work deferred by show mode, when the tally path has slack
+        if (showMode) {
+            runDeferredWork();
+        }
+
+        // Sleep until there is work: BLE event, serial input or the next timer deadline
+        TickType_t wait = pdMS_TO_TICKS(timers.msUntilNext(LOOP_IDLE_TIMEOUT));
+        xEventGroupWaitBits(loopEvents, LOOP_EVENT_ALL, pdTRUE, pdFALSE, wait);
+    }
+
+    // Parse "TALLY_REG:1:Tally_CAM_1" with optional heartbeat period ":250",
+    // negotiated down to what the bridge can sustain
+    static bool parseRegistration(const String& message, uint8_t& cameraId, char* deviceName,
+                                  size_t nameSize, uint16_t& heartbeatInterval) {
+        return parseTallyRegistration(message.c_str(), cameraId, deviceName, nameSize, heartbeatInterval,
+                                      HEARTBEAT_MIN_INTERVAL, HEARTBEAT_INTERVAL);
+    }
+
+    // Build a tally frame (cameraId 0 = heartbeat/status message)
+    void encodeTallyMessage(TallyMessage* msg, uint8_t cameraId, const char* state) {
+        msg->cameraId = cameraId;
+        msg->timestamp = clockMillis();
+        msg->bridgeId = 1;
+
+        // Set bridge status based on ATEM connection and session health
+        msg->bridgeStatus = bridgeStatus();
+
+        strncpy(msg->state, state, sizeof(msg->state) - 1);
+        msg->state[sizeof(msg->state) - 1] = '\0';
+        msg->checksum = calculateChecksum(msg);
+    }
+
+    // ATEM tally state is authoritative: session up, tally sources received
+    // and the switcher still talking
+    bool atemLive() {
+        return atem.isConnected() && atem.getSourceCount() > 0 && !atemHealth.isDead();
+    }
+
+    // Live session lost a moment ago - the last known states are still served
+    bool atemResuming() {
+        return !atemLive() && atemLostAt != 0 && clockMillis() - atemLostAt < ATEM_RESUME_WINDOW;
+    }
+
+    // TALLY_BRIDGE_* bits for outgoing frames
+    uint8_t bridgeStatus() {
+        if (atemLive()) return TALLY_BRIDGE_ATEM;
+        if (atemResuming()) return TALLY_BRIDGE_ATEM | TALLY_BRIDGE_UNCONFIRMED;
+        return 0;
+    }
+
+    // State string of the status frame (cameraId 0)
+    const char* heartbeatState() {
+        return (bridgeStatus() & TALLY_BRIDGE_ATEM) ? "HEARTBEAT" : "NO_ATEM";
+    }
+
+    // Get current tally state for a camera with standby preview logic (main loop)
+    const char* getCurrentTallyState(uint8_t cameraId) {
+        return displayState(currentTallyStates, bridgeStatus(), cameraId);
+    }
+
+    // Same from the last published tally view - safe from the BLE task
+    const char* getPublishedTallyState(uint8_t cameraId) {
+        TallyView view = tallyView.read();
+        return displayState(view.states, view.bridgeStatus, cameraId);
+    }
+
+    // Display state of a camera given every camera's ATEM tally flags
+    static const char* displayState(const uint8_t* states, uint8_t status, uint8_t cameraId) {
+        if (cameraId < 1 || cameraId > MaxCameras) return "OFF";
+
+        // Without valid tally states, return "NO_ATEM" to indicate bridge status
+        if (!(status & TALLY_BRIDGE_ATEM)) {
+            return "NO_ATEM";
+        }
+
+        uint8_t state = states[cameraId];
+        if (state & TALLY_FLAG_PROGRAM) {
+            return "PROGRAM";  // Bit 0 = On Program/Live
+        } else if (state & TALLY_FLAG_PREVIEW) {
+            return "PREVIEW";  // Bit 1 = On Preview
+        } else {
+            // Camera is OFF - check if we should show as standby preview
+            if (StandbyAsPreview) {
+                // Check if any camera is currently in PROGRAM
+                bool anyProgramActive = false;
+                for (int cam = 1; cam <= MaxCameras; cam++) {
+                    if (states[cam] & TALLY_FLAG_PROGRAM) {
+                        anyProgramActive = true;
+                        break;
+                    }
+                }
+
+                // If production is active (any camera in PROGRAM), show non-active cameras as PREVIEW (standby)
+                if (anyProgramActive) {
+                    return "PREVIEW";  // Show as ready/standby
+                }
+            }
+            return "OFF";
+        }
+    }
+
+    // Send a camera's cached frame to a specific device (may be called from
+    // BLE callbacks)
+    void sendTallyToDevice(int deviceIndex, uint8_t cameraId) {
+        if (deviceIndex < 0 || deviceIndex >= MaxDevices) return;
+        TallyDevice device = tallyDevices[deviceIndex].read();
+        if (!device.connected) return;
+
+        queueFrame(findLink(device.connId), cameraId);
+        deferHeartbeat(deviceIndex);
+
+        if (logFrames()) {
+            TallyView view = tallyView.read();
+            Serial.printf("Sent to %s: CAM%d -> %s (ATEM:%s)\n",
+                         device.deviceName, cameraId, getPublishedTallyState(cameraId),
+                         view.bridgeStatus ? "OK" : "DISCONNECTED");
+        }
+    }
+
+    // Broadcast a camera's cached frame to all connected BLE devices
+    void broadcastTallyData(uint8_t cameraId) {
+        if (cameraId >= FrameSlots) return;
+        if (logFrames()) {
+            Serial.printf("Broadcasting: CAM%d -> %s (to %d devices)\n",
+                         cameraId, frameCache[cameraId].state, numConnectedDevices);
+        }
+
+        // Queue on every link (including tallies that have not registered yet)
+        for (int link = 0; link < MaxDevices; link++) {
+            if (links[link].active) {
+                queueFrame(link, cameraId);
+            }
+        }
+
+        int sentCount = 0;
+        for (int i = 0; i < MaxDevices; i++) {
+            TallyDevice device = tallyDevices[i].read();
+            if (device.connected && device.registered) {
+                deferHeartbeat(i);
+                sentCount++;
+            }
+        }
+
+        if (sentCount > 0) {
+            totalMessagesSent += sentCount;
+        } else if (logFrames()) {
+            Serial.println("Warning: No BLE devices connected");
+        }
+
+        lastStateChange = clockMillis();
+    }
+
+    // Check for tally state changes from the tally source
+    void checkATEMTallyStates() {
+        if (!atemLive()) {
+            return;
+        }
+
+        bool anyChanges = false;
+        uint8_t sources = atem.getSourceCount();
+
+        // First pass: Check for direct tally state changes
+        for (int cam = 1; cam <= MaxCameras; cam++) {
+            uint8_t newTallyState = 0;
+
+            // Sources use 0-based indexing, so Camera 1 = index 0, Camera 2 = index 1, etc.
+            int atemIndex = cam - 1;
+            if (atemIndex < sources) {
+                newTallyState = atem.getTallyFlags(atemIndex) & (TALLY_FLAG_PROGRAM | TALLY_FLAG_PREVIEW);
+            }
+
+            // Check if state changed for this camera
+            if (newTallyState != currentTallyStates[cam]) {
+                currentTallyStates[cam] = newTallyState;
+                anyChanges = true;
+
+                if (logEvents()) {
+                    Serial.printf("Camera %d: %s (0x%02X)\n", cam, getCurrentTallyState(cam), newTallyState);
+                }
+            }
+        }
+
+        // Second pass: re-encode and broadcast every camera's display state.
+        // With standby preview enabled a single PROGRAM change can alter
+        // every camera.
+        if (anyChanges) {
+            publishSnapshot();
+            for (int cam = 1; cam <= MaxCameras; cam++) {
+                broadcastTallyData(cam);
+            }
+            totalMessagesReceived++;
+        }
+    }
+
+private:
+    // Main loop wake-up events (set from BLE and serial callbacks)
+    static const EventBits_t LOOP_EVENT_BLE = BIT0;
+    static const EventBits_t LOOP_EVENT_SERIAL = BIT1;
+    static const EventBits_t LOOP_EVENT_ALL = BIT0 | BIT1;
+
+    // Timer jobs (timer callback argument)
+    enum {
+        JOB_TALLY_CHECK,
+        JOB_NETWORK_CHECK,
+        JOB_ATEM_RECONNECT,
+        JOB_LOOP_STATS,
+        JOB_OTA_FETCH,
+        JOB_CENTRAL_SCAN,
+        JOB_ADVERTISING,
+        JOB_HEARTBEAT            // + device index
+    };
+
+    // Pending frame slots per link: slot 0 = heartbeat, 1-MaxCameras = camera
+    static const uint8_t FrameSlots = MaxCameras + 1;
+
+    // Snapshot: status frame plus one frame per camera in one container
+    static const size_t SnapshotSize = 1 + FrameSlots * (1 + sizeof(TallyMessage));
+    static_assert(SnapshotSize <= TALLY_SNAPSHOT_MAX_LENGTH, "Too many cameras for the snapshot characteristic");
+    static_assert(MaxCameras <= 32, "Too many cameras for the advertised tally bitmaps");
+    static_assert(ATEM_DEAD_TIMEOUT > ATEM_DEGRADED_TIMEOUT, "ATEM dead timeout must exceed the degraded timeout");
+    static_assert(TALLY_ADV_STATUS_ATEM == TALLY_BRIDGE_ATEM && TALLY_ADV_STATUS_UNCONFIRMED == TALLY_BRIDGE_UNCONFIRMED,
+                  "Advertised status bits mirror the frame status bits");
+
+    // Tally flags and ATEM status as last published by the loop (read from
+    // the BLE task and serial commands)
+    struct TallyView {
+        uint8_t states[MaxCameras + 1];
+        uint8_t bridgeStatus;             // TALLY_BRIDGE_* bits
+    };
+
+    // Tally poll deviation from its period (per mode)
+    struct PollJitter {
+        unsigned long samples;
+        uint64_t total;                   // Sum of deviations (us)
+        unsigned long max;
+    };
+
+    // Encoded snapshot characteristic value
+    struct SnapshotValue {
+        uint16_t length;
+        uint8_t data[SnapshotSize];
+    };
+
+    // One BLE link: negotiated MTU, notification flow control and the slots
+    // waiting to be sent (the frames themselves are in the frame cache)
+    struct PeerLink {
+        uint16_t connId;
+        uint16_t mtu;
+        bool active;
+        volatile bool congested;          // Stack reported L2CAP congestion
+        uint8_t inFlight;                 // Notifications submitted, not yet confirmed
+        unsigned long lastSubmit;         // clockMillis() of the last submitted notification
+        uint32_t queuedSeq[FrameSlots];   // Queue order of each pending slot, 0 = empty
+    };
+
+    static const bool logInfo = (LogLevel >= BRIDGE_LOG_INFO);
+    static const bool logDebug = (LogLevel >= BRIDGE_LOG_DEBUG);
+
+    // Event and per-frame logging: the build's level, muted in show mode.
+    // Serial command output keeps using logInfo/logDebug.
+    bool logEvents() const { return logInfo && !showMode; }
+    bool logFrames() const { return logDebug && !showMode; }
+
+    // Show mode requests from the control protocol (BLE task -> loop)
+    static const int8_t SHOW_REQUEST_NONE = -1;
+    static const int8_t SHOW_REQUEST_OFF = 0;
+    static const int8_t SHOW_REQUEST_ON = 1;
+
+    // Callbacks need a plain function pointer - route them to the single instance
+    static ATEMBridgeCore* instance;
+
+    // BLE Server Callbacks
+    class ServerCallbacks : public BLEServerCallbacks {
+        void onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+            instance->onClientConnect(param->connect.conn_id);
+        }
+
+        void onDisconnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+            instance->onClientDisconnect(param->disconnect.conn_id);
+        }
+
+        void onMtuChanged(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+            instance->onClientMtuChanged(param->mtu.conn_id, param->mtu.mtu);
+        }
+    };
+
+    // BLE Characteristic Callbacks for receiving data
+    class CharacteristicCallbacks : public BLECharacteristicCallbacks {
+        void onWrite(BLECharacteristic* pCharacteristic, esp_ble_gatts_cb_param_t* param) {
+            instance->onCharacteristicWrite(pCharacteristic, param->write.conn_id);
+        }
+    };
+
+    // Snapshot reads: hand out the current snapshot as one consistent value
+    class SnapshotCallbacks : public BLECharacteristicCallbacks {
+        void onRead(BLECharacteristic* pCharacteristic) {
+            instance->onSnapshotRead(pCharacteristic);
+        }
+    };
+
+#if BRIDGE_TALLY_OTA
+    // Tally replies during a firmware update
+    class OtaCallbacks : public BLECharacteristicCallbacks {
+        void onWrite(BLECharacteristic* pCharacteristic, esp_ble_gatts_cb_param_t* param) {
+            instance->onOtaWrite(pCharacteristic, param->write.conn_id);
+        }
+    };
+#endif
+
+    // Raw GATT server events: notification confirmations and congestion
+    static void onGattsEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gattsIf,
+                             esp_ble_gatts_cb_param_t* param) {
+        instance->gattsIf = gattsIf;
+        if (event == ESP_GATTS_CONF_EVT) {
+            instance->onNotifyConfirmed(param->conf.conn_id);
+        } else if (event == ESP_GATTS_CONGEST_EVT) {
+            instance->onLinkCongestion(param->congest.conn_id, param->congest.congested);
+        }
+    }
+
+#if BRIDGE_CENTRAL
+    // Central topology: tally links dropping
+    class CentralCallbacks : public BLEClientCallbacks {
+        void onConnect(BLEClient* pClient) {}
+
+        void onDisconnect(BLEClient* pClient) {
+            instance->central.onDisconnect(pClient->getConnId());
+            instance->onClientDisconnect(pClient->getConnId());
+        }
+    };
+
+    // Raw GATT client events: write completions stand in for notification
+    // confirmations, congestion works as on the server side
+    static void onGattcEvent(esp_gattc_cb_event_t event, esp_gatt_if_t gattcIf,
+                             esp_ble_gattc_cb_param_t* param) {
+        if (event == ESP_GATTC_WRITE_CHAR_EVT) {
+            instance->onNotifyConfirmed(param->write.conn_id);
+        } else if (event == ESP_GATTC_CONGEST_EVT) {
+            instance->onLinkCongestion(param->congest.conn_id, param->congest.congested);
+        }
+    }
+#endif
+
+    static void onTimer(int job) {
+        instance->runTimer(job);
+    }
+
+    // Serial receive callback (runs on the UART event task)
+    static void onSerialReceive() {
+        instance->wakeLoop(LOOP_EVENT_SERIAL);
+    }
+
+    // ===============================================
+    // BLE FUNCTIONS
+    // ===============================================
+
+    // Wake the main loop (callbacks may have armed timers that are due sooner)
+    void wakeLoop(EventBits_t reason) {
+        if (loopEvents) {
+            xEventGroupSetBits(loopEvents, reason);
+        }
+    }
+
+    void onClientConnect(uint16_t connId) {
+        // Track the link until its MTU exchange completes (default MTU until then)
+        for (int i = 0; i < MaxDevices; i++) {
+            if (!links[i].active) {
+                portENTER_CRITICAL(&linkLock);
+                links[i].connId = connId;
+                links[i].mtu = TALLY_DEFAULT_MTU;
+                links[i].congested = false;
+                links[i].inFlight = 0;
+                memset(links[i].queuedSeq, 0, sizeof(links[i].queuedSeq));
+                links[i].active = true;
+                portEXIT_CRITICAL(&linkLock);
+                break;
+            }
+        }
+
+        numConnectedDevices++;
+        if (logEvents()) {
+            Serial.printf("BLE client connected (total: %d/%d)\n",
+                         numConnectedDevices, MaxDevices);
+        }
+
+        // The controller stopped advertising for the connection - the loop
+        // restarts it if slots are left
+        linkConnects++;
+        wakeLoop(LOOP_EVENT_BLE);
+    }
+
+    void onClientDisconnect(uint16_t connId) {
+        int link = findLink(connId);
+        if (link >= 0) {
+            portENTER_CRITICAL(&linkLock);
+            links[link].active = false;
+            portEXIT_CRITICAL(&linkLock);
+#if BRIDGE_TALLY_OTA
+            ota.onLinkDown(link);
+#endif
+        }
+
+        if (numConnectedDevices > 0) {
+            numConnectedDevices--;
+        }
+        if (logEvents()) {
+            Serial.printf("BLE client disconnected (total: %d/%d)\n",
+                         numConnectedDevices, MaxDevices);
+        }
+
+        // Mark the device on this connection as disconnected
+        for (int i = 0; i < MaxDevices; i++) {
+            TallyDevice device = tallyDevices[i].read();
+            if (device.connected && device.connId == connId) {
+                tallyDevices[i].update([connId](TallyDevice& d) {
+                    if (d.connId == connId) d.connected = false;
+                });
+                timers.stop(heartbeatTimers[i]);
+                if (logEvents()) {
+                    Serial.printf("Device %s marked as disconnected\n", device.deviceName);
+                }
+                break;
+            }
+        }
+
+        // The loop restarts advertising fast for the tally to come back
+        linkDrops++;
+        wakeLoop(LOOP_EVENT_BLE);
+    }
+
+    void onClientMtuChanged(uint16_t connId, uint16_t mtu) {
+        int link = findLink(connId);
+        if (link >= 0) {
+            portENTER_CRITICAL(&linkLock);
+            links[link].mtu = mtu;
+            portEXIT_CRITICAL(&linkLock);
+        }
+        if (logEvents()) {
+            Serial.printf("BLE client %d negotiated MTU %d\n", connId, mtu);
+        }
+    }
+
+    // The stack has taken a notification off our hands
+    void onNotifyConfirmed(uint16_t connId) {
+        int link = findLink(connId);
+        if (link < 0) return;
+
+        portENTER_CRITICAL(&linkLock);
+        if (links[link].inFlight > 0) {
+            links[link].inFlight--;
+        }
+        portEXIT_CRITICAL(&linkLock);
+
+        wakeLoop(LOOP_EVENT_BLE);
+    }
+
+    // L2CAP congestion on a link - hold notifications until it clears
+    void onLinkCongestion(uint16_t connId, bool congested) {
+        int link = findLink(connId);
+        if (link < 0) return;
+
+        links[link].congested = congested;
+        if (congested) {
+            congestionEvents++;
+        } else {
+            wakeLoop(LOOP_EVENT_BLE);
+        }
+    }
+
+    // Link index for a connection ID, -1 if unknown
+    int findLink(uint16_t connId) {
+        for (int i = 0; i < MaxDevices; i++) {
+            if (links[i].active && links[i].connId == connId) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Any frame doubles as a heartbeat - push the device's next one back a full period
+    void deferHeartbeat(int deviceIndex) {
+        uint16_t interval = tallyDevices[deviceIndex].read().heartbeatInterval;
+        timers.start(heartbeatTimers[deviceIndex], interval, interval);
+    }
+
+    // Queue a frame cache slot on a link for the next flush (may be called
+    // from BLE callbacks). The flush sends whatever the slot holds then, so an
+    // unsent frame for the same camera is superseded.
+    void queueFrame(int link, uint8_t slot) {
+        if (link < 0 || slot >= FrameSlots) return;
+
+        portENTER_CRITICAL(&linkLock);
+        if (queueTallyFrame(links[link].queuedSeq, slot, queueSeq)) {
+            framesSuperseded++;
+        }
+        portEXIT_CRITICAL(&linkLock);
+    }
+
+    bool hasPendingFrames(const PeerLink& l) {
+        for (int slot = 0; slot < FrameSlots; slot++) {
+            if (l.queuedSeq[slot] != 0) return true;
+        }
+        return false;
+    }
+
+    // Send queued frames on every link that has capacity
+    void flushPendingFrames() {
+        for (int link = 0; link < MaxDevices; link++) {
+            if (links[link].active) {
+                flushLink(link);
+            }
+        }
+    }
+
+    // Send a link's queued frames newest first, packed to its MTU, while the
+    // stack has room. Frames left behind keep being superseded until then.
+    void flushLink(int link) {
+        PeerLink& l = links[link];
+        size_t capacity = tallyNotifyCapacity(l.mtu);
+
+        while (true) {
+            TallyNotification n;
+            n.count = 0;
+
+            portENTER_CRITICAL(&linkLock);
+            // Recover if a confirmation was lost
+            if (l.inFlight > 0 && clockMillis() - l.lastSubmit > NOTIFY_CONFIRM_TIMEOUT) {
+                l.inFlight = 0;
+            }
+            bool blocked = l.congested || l.inFlight >= NOTIFY_MAX_IN_FLIGHT;
+
+            // Take pending frames newest first until the notification is full
+            if (!blocked) {
+                packTallyNotification(n, capacity, frameCache, l.queuedSeq, FrameSlots);
+            }
+            if (blocked && hasPendingFrames(l)) {
+                heldBackFlushes++;
+            }
+            if (n.count > 0) {
+                l.inFlight++;
+                l.lastSubmit = clockMillis();
+            }
+            portEXIT_CRITICAL(&linkLock);
+
+            if (n.count == 0) {
+                sendOtaMessages(link);
+                return;
+            }
+
+            if (sendToLink(l, n.data, n.length) != ESP_OK) {
+                // Stack refused it - requeue whatever was not queued again meanwhile
+                portENTER_CRITICAL(&linkLock);
+                l.inFlight--;
+                for (int i = 0; i < n.count; i++) {
+                    if (l.queuedSeq[n.slots[i]] == 0) {
+                        l.queuedSeq[n.slots[i]] = n.seqs[i];
+                    }
+                }
+                portEXIT_CRITICAL(&linkLock);
+                notifyFailures++;
+                return;
+            }
+
+            totalNotifications++;
+            totalFramesSent += n.count;
+        }
+    }
+
+    // Hand a frame or container to the stack: notification on the tally
+    // characteristic, or a write to the tally's frame characteristic when
+    // the bridge is the central
+    esp_err_t sendToLink(const PeerLink& l, const uint8_t* data, size_t length) {
+#if BRIDGE_CENTRAL
+        return central.write(l.connId, data, length);
+#else
+        return esp_ble_gatts_send_indicate(gattsIf, l.connId, pCharacteristic->getHandle(),
+                                           length, (uint8_t*)data, false);
+#endif
+    }
+
+    // Firmware update traffic uses what tally frames leave: only when the
+    // link has nothing queued, never its last in-flight slot
+    void sendOtaMessages(int link) {
+#if BRIDGE_TALLY_OTA
+        PeerLink& l = links[link];
+        uint8_t buffer[TALLY_BLE_MTU - 3];
+        size_t capacity = min((size_t)(l.mtu - 3), sizeof(buffer));
+        if (!ota.isActive() || l.mtu < TALLY_OTA_MIN_MTU) return;
+
+        while (true) {
+            portENTER_CRITICAL(&linkLock);
+            bool room = !l.congested && l.inFlight < NOTIFY_MAX_IN_FLIGHT - 1 && !hasPendingFrames(l);
+            if (room) {
+                l.inFlight++;
+                l.lastSubmit = clockMillis();
+            }
+            portEXIT_CRITICAL(&linkLock);
+            if (!room) return;
+
+            size_t length = ota.nextMessage(link, buffer, capacity);
+            esp_err_t result = ESP_FAIL;
+            if (length > 0) {
+                result = esp_ble_gatts_send_indicate(gattsIf, l.connId, pOtaCharacteristic->getHandle(),
+                                                     length, buffer, false);
+            }
+            if (result != ESP_OK) {
+                portENTER_CRITICAL(&linkLock);
+                l.inFlight--;
+                portEXIT_CRITICAL(&linkLock);
+                if (length > 0 && buffer[0] == TALLY_OTA_DATA) {
+                    TallyOtaChunk chunk;
+                    memcpy(&chunk, &buffer[1], sizeof(chunk));
+                    ota.rewind(link, chunk.offset);
+                }
+                return;
+            }
+            totalNotifications++;
+        }
+#endif
+    }
+
+#if BRIDGE_TALLY_OTA
+    // Tally reply on the OTA characteristic (BLE task)
+    void onOtaWrite(BLECharacteristic* pCharacteristic, uint16_t connId) {
+        int link = findLink(connId);
+        std::string value = pCharacteristic->getValue();
+        if (ota.onReply(link, (const uint8_t*)value.data(), value.length())) {
+            OtaLinkState state = ota.getLinkState(link);
+            if (logEvents()) {
+                Serial.printf("OTA link %d: %s\n", connId, ota.stateName(state));
+            }
+            if (ota.getFleetTime() > 0) {
+                Serial.printf("✓ Tally OTA finished: %lu updated, %lu current, %lu failed in %lu s\n",
+                             ota.getUpdated(), ota.getCurrent(), ota.getFailed(),
+                             ota.getFleetTime() / 1000);
+            }
+        }
+        wakeLoop(LOOP_EVENT_BLE);
+    }
+#endif
+
+    // OTA FETCH download step (timer, while the download runs)
+    void continueOtaFetch() {
+#if BRIDGE_TALLY_OTA
+        if (ota.fetch()) return;
+
+        timers.stop(otaFetchTimer);
+        if (ota.hasImage()) {
+            const TallyOtaImage& image = ota.getImage();
+            Serial.printf("✓ Tally image loaded: %lu bytes (%lu to send%s%s), CRC %08lX\n",
+                         (unsigned long)image.imageSize, (unsigned long)image.payloadSize,
+                         (image.flags & TALLY_OTA_FLAG_COMPRESSED) ? ", compressed" : "",
+                         (image.flags & TALLY_OTA_FLAG_DELTA) ? ", delta" : "",
+                         (unsigned long)image.imageCrc);
+        } else {
+            Serial.println("✗ Tally image download failed");
+        }
+#endif
+    }
+
+    // OTA serial commands: OTA, OTA FETCH [url], OTA START, OTA STOP
+    void handleOtaCommand(const String& command, const String& argument) {
+#if BRIDGE_TALLY_OTA
+        if (command == "OTA FETCH") {
+            String url = argument.length() > 0 ? argument : String(TALLY_OTA_URL);
+            if (!networkConnected || !ota.startFetch(url)) {
+                Serial.printf("✗ Cannot fetch tally image from %s\n", url.c_str());
+                return;
+            }
+            Serial.printf("Fetching tally image from %s...\n", url.c_str());
+            timers.start(otaFetchTimer, OTA_FETCH_INTERVAL, OTA_FETCH_INTERVAL);
+        }
+        else if (command == "OTA START") {
+            if (!ota.start()) {
+                Serial.println("✗ No tally image - use OTA FETCH first");
+                return;
+            }
+            Serial.printf("Offering tally image to %d connected tallies\n", numConnectedDevices);
+            wakeLoop(LOOP_EVENT_BLE);
+        }
+        else if (command == "OTA STOP") {
+            ota.stop();
+            Serial.println("Tally OTA stopped");
+        }
+        else {
+            const esp_partition_t* partition = ota.getPartition();
+            Serial.printf("Image store: %s\n", partition ? partition->label : "none");
+            if (ota.isFetching()) {
+                Serial.printf("Fetching: %d%%\n", ota.getFetchProgress());
+            } else if (ota.hasImage()) {
+                const TallyOtaImage& image = ota.getImage();
+                Serial.printf("Image: %lu bytes, %lu to send, flags 0x%02X, CRC %08lX\n",
+                             (unsigned long)image.imageSize, (unsigned long)image.payloadSize,
+                             image.flags, (unsigned long)image.imageCrc);
+            } else {
+                Serial.println("Image: none");
+            }
+            Serial.printf("Transfer: %s, %lu s, %lu updated, %lu current, %lu failed\n",
+                         ota.isActive() ? "active" : "stopped",
+                         (ota.getFleetTime() ? ota.getFleetTime() : ota.getElapsed()) / 1000,
+                         ota.getUpdated(), ota.getCurrent(), ota.getFailed());
+            Serial.printf("Chunks: %lu (%lu bytes), %lu rewinds\n",
+                         ota.getChunksSent(), ota.getBytesSent(), ota.getRewinds());
+            for (int i = 0; i < MaxDevices; i++) {
+                if (links[i].active) {
+                    OtaLinkState state = ota.getLinkState(i);
+                    Serial.printf("  Link %d: %s, %lu/%lu bytes\n", links[i].connId,
+                                 ota.stateName(state), (unsigned long)ota.getLinkAcked(i),
+                                 (unsigned long)ota.getImage().payloadSize);
+                }
+            }
+        }
+#else
+        Serial.println("Tally OTA not included in this build");
+#endif
+    }
+
+    void onCharacteristicWrite(BLECharacteristic* pCharacteristic, uint16_t connId) {
+        std::string rxValue = pCharacteristic->getValue();
+        if (rxValue.length() == 0) return;
+
+        // Handle device registration or a show mode switch ("BRIDGE_SHOW:1")
+        String message = String(rxValue.c_str());
+        message.trim();
+        if (message.startsWith("BRIDGE_SHOW:")) {
+            showRequest = (message.substring(12).toInt() != 0) ? SHOW_REQUEST_ON : SHOW_REQUEST_OFF;
+        } else {
+            handleRegistration(message, connId, pCharacteristic);
+        }
+
+        wakeLoop(LOOP_EVENT_BLE);
+    }
+
+    // TALLY_REG from a tally: written by it (server) or read from it (central)
+    void handleRegistration(const String& message, uint16_t connId, BLECharacteristic* characteristic) {
+        uint8_t cameraId;
+        uint16_t heartbeatInterval;
+        TallyDevice device = {};
+
+        if (!parseRegistration(message, cameraId, device.deviceName, sizeof(device.deviceName),
+                               heartbeatInterval)) return;
+
+        device.cameraId = cameraId;
+        device.lastSeen = clockMillis();
+        device.connected = true;
+        device.registered = true;
+        device.characteristic = characteristic;
+        device.connId = connId;
+        device.heartbeatInterval = heartbeatInterval;
+
+        // Take the tally's previous slot or the first free one. Registrations
+        // arrive on the BLE task (server) or the loop (central), so the claim
+        // is serialized; readers keep using the published slots meanwhile.
+        int slot = -1;
+        bool reconnected = false;
+        portENTER_CRITICAL(&registrationLock);
+        for (int i = 0; i < MaxDevices && slot < 0; i++) {
+            TallyDevice current = tallyDevices[i].read();
+            if (!current.registered || strcmp(current.deviceName, device.deviceName) == 0) {
+                slot = i;
+                reconnected = current.registered;
+                tallyDevices[i].write(device);
+            }
+        }
+        portEXIT_CRITICAL(&registrationLock);
+        if (slot < 0) return;
+
+        if (logEvents() && !reconnected) {
+            Serial.printf("✓ Registered BLE tally: %s (CAM%d) [slot %d, heartbeat %dms]\n",
+                         device.deviceName, cameraId, slot, heartbeatInterval);
+        } else if (logEvents()) {
+            Serial.printf("✓ Reconnected BLE tally: %s (CAM%d) [heartbeat %dms]\n",
+                         device.deviceName, cameraId, heartbeatInterval);
+        }
+
+        // Send current state for this camera immediately
+        sendTallyToDevice(slot, cameraId);
+#if BRIDGE_TALLY_OTA
+        ota.onLinkReady(findLink(connId));
+#endif
+    }
+
+    // Central topology: connect a tally the scan found, else keep scanning
+    // while tallies are missing (central scan timer). Connecting blocks the
+    // loop for one tally's connect and discovery.
+    void serviceCentral() {
+#if BRIDGE_CENTRAL
+        if (numConnectedDevices >= MaxDevices) return;
+        if (!central.hasCandidate()) {
+            central.startScan();
+            return;
+        }
+
+        String registration;
+        BLEClient* client = central.connectNext(&centralCallbacks, registration);
+        if (client == nullptr) {
+            if (logEvents()) {
+                Serial.println("✗ Tally connection failed");
+            }
+            return;
+        }
+
+        uint16_t connId = client->getConnId();
+        onClientConnect(connId);
+        onClientMtuChanged(connId, client->getMTU());
+        if (logEvents()) {
+            Serial.printf("✓ Connected to tally %s\n", central.getAddress(connId).c_str());
+        }
+
+        // Full sync first - there is no snapshot to read in this topology
+        int link = findLink(connId);
+        for (int slot = 0; slot < FrameSlots; slot++) {
+            queueFrame(link, slot);
+        }
+        registration.trim();
+        handleRegistration(registration, connId, nullptr);
+
+        // More tallies waiting - connect the next one on the following pass
+        if (central.hasCandidate()) {
+            timers.start(centralScanTimer, 1, CENTRAL_SCAN_INTERVAL);
+        }
+#endif
+    }
+
+    // Initialize BLE server
+    bool initializeBLE() {
+        Serial.printf("Initializing BLE server: %s\n", BLE_DEVICE_NAME);
+
+        // Initialize tally device array (before callbacks can register devices)
+        TallyDevice empty = {};
+        empty.heartbeatInterval = HEARTBEAT_INTERVAL;
+        for (int i = 0; i < MaxDevices; i++) {
+            tallyDevices[i].write(empty);
+        }
+
+        // Initialize BLE device
+        BLEDevice::init(BLE_DEVICE_NAME);
+
+        // Offer a larger ATT MTU so several frames fit one notification
+        BLEDevice::setMTU(TALLY_BLE_MTU);
+
+#if BRIDGE_CENTRAL
+        // Tallies advertise; connect to them and drive every link's timing
+        BLEDevice::setCustomGattcHandler(onGattcEvent);
+        central.begin();
+        publishSnapshot();
+        timers.start(centralScanTimer, 1, CENTRAL_SCAN_INTERVAL);
+        Serial.printf("✓ BLE central initialized - scanning for tallies (interval %.2f ms)\n",
+                     CENTRAL_CONN_INTERVAL * 1.25);
+        return true;
+#endif
+
+        // Notification confirmations and congestion for per-link flow control
+        BLEDevice::setCustomGattsHandler(onGattsEvent);
+
+        // Create BLE server
+        pServer = BLEDevice::createServer();
+        pServer->setCallbacks(new ServerCallbacks());
+
+        // Create BLE service (tallies cache its handles - bump
+        // TALLY_GATT_LAYOUT when adding, removing or reordering attributes)
+        pService = pServer->createService(BLE_SERVICE_UUID);
+
+        // Create BLE characteristic for tally data
+        pCharacteristic = pService->createCharacteristic(
+                          BLE_CHARACTERISTIC_UUID,
+                          BLECharacteristic::PROPERTY_READ |
+                          BLECharacteristic::PROPERTY_WRITE |
+                          BLECharacteristic::PROPERTY_NOTIFY
+                        );
+
+        pCharacteristic->setCallbacks(new CharacteristicCallbacks());
+        pCharacteristic->addDescriptor(new BLE2902());
+
+        // Read-only snapshot of every camera for tallies that just connected
+        pSnapshotCharacteristic = pService->createCharacteristic(
+                                  BLE_SNAPSHOT_UUID,
+                                  BLECharacteristic::PROPERTY_READ
+                                );
+        pSnapshotCharacteristic->setCallbacks(new SnapshotCallbacks());
+        publishSnapshot();
+
+#if BRIDGE_TALLY_OTA
+        // Tally firmware distribution: offer and chunks out, replies in
+        pOtaCharacteristic = pService->createCharacteristic(
+                             BLE_OTA_UUID,
+                             BLECharacteristic::PROPERTY_WRITE_NR |
+                             BLECharacteristic::PROPERTY_NOTIFY
+                           );
+        pOtaCharacteristic->setCallbacks(new OtaCallbacks());
+        pOtaCharacteristic->addDescriptor(new BLE2902());
+        ota.begin();
+#endif
+
+        // Start the service
+        pService->start();
+
+        // Start advertising (the scan response carries the tally state, set
+        // by publishSnapshot). With a scan response the library leaves the
+        // name out of the advert - tallies match the service UUID.
+        BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
+        pAdvertising->addServiceUUID(BLE_SERVICE_UUID);
+        pAdvertising->setScanResponse(true);
+        pAdvertising->setMinPreferred(0x0);
+        advertisingPolicy.begin(clockMillis());
+        updateAdvertising();
+
+        Serial.println("✓ BLE server initialized and advertising");
+        if (logEvents()) {
+            Serial.printf("Service UUID: %s\n", BLE_SERVICE_UUID);
+            Serial.printf("Characteristic UUID: %s\n", BLE_CHARACTERISTIC_UUID);
+            Serial.printf("Snapshot UUID: %s\n", BLE_SNAPSHOT_UUID);
+        }
+
+        return true;
+    }
+
+    // Publish the tally view, bring the frame cache up to date and pack the
+    // status frame and every camera into the snapshot (called on every tally
+    // or ATEM connection change)
+    void publishSnapshot() {
+        TallyView view;
+        snapshotStatus = bridgeStatus();
+        view.bridgeStatus = snapshotStatus;
+        memcpy(view.states, currentTallyStates, sizeof(view.states));
+        tallyView.write(view);
+
+        updateFrame(0, heartbeatState());
+        for (int cam = 1; cam <= MaxCameras; cam++) {
+            updateFrame(cam, getCurrentTallyState(cam));
+        }
+
+        SnapshotValue value;
+        size_t used = 0;
+        for (int slot = 0; slot < FrameSlots; slot++) {
+            packTallyFrame(value.data, used, sizeof(value.data), &frameCache[slot]);
+        }
+        value.length = used;
+        snapshot.write(value);
+
+        if (!BRIDGE_CENTRAL) {
+            publishAdvertisement();
+        }
+    }
+
+    // Re-encode a frame cache slot whose display state or bridge status
+    // changed (main loop). Unchanged slots keep their bytes - every link
+    // sends the same buffer.
+    void updateFrame(uint8_t slot, const char* state) {
+        if (frameStates[slot] && strcmp(frameStates[slot], state) == 0 &&
+            frameCache[slot].bridgeStatus == snapshotStatus) return;
+
+        TallyMessage msg;
+        encodeTallyMessage(&msg, slot, state);
+        portENTER_CRITICAL(&linkLock);
+        frameCache[slot] = msg;
+        portEXIT_CRITICAL(&linkLock);
+        frameStates[slot] = state;
+        framesEncoded++;
+    }
+
+    // Put the ATEM status and program/preview bitmaps in the scan response so
+    // a scanning tally knows its state before it connects. The sequence moves
+    // only when the content changes.
+    void publishAdvertisement() {
+        TallyAdvertisement adv = {};
+        adv.companyId = TALLY_ADV_COMPANY_ID;
+        adv.version = TALLY_ADV_VERSION;
+        adv.status = snapshotStatus; // TALLY_ADV_STATUS_* bits match TALLY_BRIDGE_*
+        adv.gatt = TALLY_GATT_LAYOUT | (BRIDGE_TALLY_OTA ? TALLY_GATT_OTA : 0);
+        for (int cam = 1; cam <= MaxCameras; cam++) {
+            const char* state = getCurrentTallyState(cam);
+            if (strcmp(state, "PROGRAM") == 0) {
+                adv.program |= 1UL << (cam - 1);
+            } else if (strcmp(state, "PREVIEW") == 0) {
+                adv.preview |= 1UL << (cam - 1);
+            }
+        }
+
+        if (advertUpdates > 0 && adv.status == advertisement.status &&
+            adv.program == advertisement.program && adv.preview == advertisement.preview) {
+            return;
+        }
+        adv.sequence = advertisement.sequence + 1;
+        advertisement = adv;
+        advertUpdates++;
+
+        BLEAdvertisementData scanResponse;
+        scanResponse.setManufacturerData(std::string((const char*)&advertisement, sizeof(advertisement)));
+        BLEDevice::getAdvertising()->setScanResponseData(scanResponse);
+    }
+
+    // A registered tally is not connected
+    bool knownTallyMissing() {
+        for (int i = 0; i < MaxDevices; i++) {
+            TallyDevice device = tallyDevices[i].read();
+            if (device.registered && !device.connected) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Apply the advertising policy (main loop). Advertising restarts whenever
+    // the mode changes or a link came or went - the controller stops it on
+    // every connection.
+    void updateAdvertising() {
+        unsigned long now = clockMillis();
+        uint32_t connects = linkConnects;
+        uint32_t drops = linkDrops;
+        bool linksChanged = (connects != seenLinkConnects || drops != seenLinkDrops);
+        if (drops != seenLinkDrops) {
+            advertisingPolicy.onDisconnect(now);
+        }
+        seenLinkConnects = connects;
+        seenLinkDrops = drops;
+
+        bool missing = knownTallyMissing();
+        AdvertisingMode mode = advertisingPolicy.select(now, numConnectedDevices < MaxDevices, missing);
+        if (mode == advertisingPolicy.getMode() && !linksChanged) {
+            return;
+        }
+
+        if (logEvents() && mode != advertisingPolicy.getMode()) {
+            Serial.printf("Advertising: %s -> %s\n", advertisingPolicy.getModeName(),
+                         mode == ADV_FAST ? "FAST" : (mode == ADV_SLOW ? "SLOW" : "OFF"));
+        }
+        advertisingPolicy.onApplied(mode, now);
+
+        BLEDevice::stopAdvertising();
+        if (mode != ADV_OFF) {
+            // Advertising intervals are in 0.625 ms units
+            uint16_t units = (mode == ADV_FAST ? ADV_FAST_INTERVAL : ADV_SLOW_INTERVAL) * 8 / 5;
+            BLEAdvertising* pAdvertising = BLEDevice::getAdvertising();
+            pAdvertising->setMinInterval(units);
+            pAdvertising->setMaxInterval(units);
+            BLEDevice::startAdvertising();
+        }
+
+        // Re-evaluate when the burst or missing window closes
+        unsigned long wait = advertisingPolicy.msUntilChange(now, missing);
+        if (wait > 0) {
+            timers.start(advertisingTimer, wait);
+        }
+    }
+
+    // Snapshot read (BLE task) - the value is set here from a consistent copy
+    // of the published snapshot. Long reads continue from it.
+    void onSnapshotRead(BLECharacteristic* pCharacteristic) {
+        SnapshotValue value = snapshot.read();
+        pCharacteristic->setValue(value.data, value.length);
+        snapshotReads++;
+    }
+
+    // Send heartbeat signal to one tally device (heartbeat timer, runs at the
+    // device's negotiated period)
+    void sendHeartbeatSignal(int deviceIndex) {
+        TallyDevice device = tallyDevices[deviceIndex].read();
+        if (!device.connected || !device.registered) {
+            return;
+        }
+
+        unsigned long now = clockMillis();
+
+        // Heartbeats may run several times a second - log at the default interval only
+        if (logFrames() && now - lastHeartbeat >= HEARTBEAT_INTERVAL) {
+            Serial.printf("Sending heartbeat signal to %d devices (ATEM:%s)\n",
+                         numConnectedDevices, atemLive() ? "OK" : (atemResuming() ? "RESUMING" : "DISCONNECTED"));
+            lastHeartbeat = now;
+        }
+
+        // The status frame is prebuilt - only its timestamp moves
+        portENTER_CRITICAL(&linkLock);
+        frameCache[0].timestamp = now;
+        portEXIT_CRITICAL(&linkLock);
+        queueFrame(findLink(device.connId), 0);
+    }
+
+    // ===============================================
+    // NETWORK FUNCTIONS (USB Tethering)
+    // ===============================================
+
+    // Start waiting for the USB tethering network interface. The network
+    // check timer polls for an address and, settleTime after it appears,
+    // starts the ATEM handshake - nothing here waits on the loop task.
+    void initializeNetwork(unsigned long settleTime) {
+        // Initialize WiFi in station mode for network stack (but no WiFi used)
+        WiFi.mode(WIFI_STA);
+        WiFi.disconnect();
+
+        if (logEvents()) {
+            Serial.println("Waiting for USB tethering network interface...");
+        }
+
+        networkConnected = false;
+        networkState = NETWORK_WAITING;
+        networkSince = clockMillis();
+        networkSettleTime = settleTime;
+        networkPolls = 0;
+        timers.start(networkCheckTimer, NETWORK_POLL_INTERVAL);
+    }
+
+    // True once USB tethering has given the interface an address
+    bool hasNetworkAddress() {
+        return WiFi.localIP().toString() != "0.0.0.0";
+    }
+
+    // Check network connectivity status
+    bool checkNetworkConnectivity() {
+        // Check if we still have a valid IP address
+        networkConnected = hasNetworkAddress();
+        return networkConnected;
+    }
+
+    // Network state machine (network check timer, re-armed for the next step)
+    void checkNetwork() {
+        switch (networkState) {
+            case NETWORK_WAITING:
+                if (hasNetworkAddress()) {
+                    Serial.printf("\n✓ USB Tethering Network Connected!\n");
+                    Serial.printf("  IP Address: %s\n", WiFi.localIP().toString().c_str());
+                    if (logEvents()) {
+                        Serial.printf("  Gateway: %s\n", WiFi.gatewayIP().toString().c_str());
+                        Serial.printf("  DNS: %s\n", WiFi.dnsIP().toString().c_str());
+                    }
+                    // Let a recovered network stabilize before the handshake
+                    networkState = NETWORK_SETTLING;
+                    timers.start(networkCheckTimer, networkSettleTime);
+                    return;
+                }
+
+                networkPolls++;
+                if (clockMillis() - networkSince < NETWORK_WAIT_TIMEOUT) {
+                    if (logEvents()) {
+                        Serial.print(".");
+                        if (networkPolls % 20 == 0) {
+                            Serial.printf(" [%lu s]\n", (clockMillis() - networkSince) / 1000);
+                        }
+                    }
+                } else if (networkPolls == NETWORK_WAIT_TIMEOUT / NETWORK_POLL_INTERVAL) {
+                    Serial.println("\n✗ USB tethering network not available!");
+                    Serial.println("  Ensure USB tethering is enabled on PC");
+                    Serial.println("  Check USB cable connection");
+                }
+                timers.start(networkCheckTimer, NETWORK_POLL_INTERVAL);
+                return;
+
+            case NETWORK_SETTLING:
+                networkState = NETWORK_UP;
+                if (checkNetworkConnectivity()) {
+                    connectToATEM();
+                }
+                break;
+
+            case NETWORK_UP:
+                if (!checkNetworkConnectivity()) {
+                    Serial.println("USB tethering network lost - attempting reconnection...");
+                    initializeNetwork(NETWORK_SETTLE_TIME);
+                    return;
+                }
+                break;
+        }
+        timers.start(networkCheckTimer, NETWORK_CHECK_INTERVAL);
+    }
+
+    // ===============================================
+    // ATEM FUNCTIONS
+    // ===============================================
+
+    // Connect to ATEM switcher through the tally source
+    bool connectToATEM() {
+        if (!networkConnected) {
+            Serial.println("Cannot connect to ATEM: No network connection");
+            return false;
+        }
+
+        if (logEvents()) {
+            Serial.printf("Connecting to ATEM switcher at %s using %s\n", ATEM_IP, atem.name());
+        }
+
+        // Parse IP address string to IPAddress object
+        IPAddress atemIP;
+        if (!atemIP.fromString(ATEM_IP)) {
+            Serial.println("✗ Invalid ATEM IP address format");
+            return false;
+        }
+
+        // The handshake completes in handleATEM() as the switcher answers
+        atemSessionUp = false;
+        atemHandshaking = true;
+        atemConnectAt = clockMillis();
+        atemLastRx = atemConnectAt;
+        if (atem.connect(atemIP)) {
+            if (logEvents()) {
+                Serial.println("ATEM handshake started");
+            }
+            return true;
+        }
+        atemHandshaking = false;
+
+        Serial.println("✗ Failed to connect to ATEM switcher");
+        if (logEvents()) {
+            Serial.println("  Check ATEM IP address and network connectivity");
+            Serial.println("  Ensure ATEM is powered on and connected to network");
+        }
+        return false;
+    }
+
+    // Main ATEM communication handler (tally check timer). Sources own their
+    // sockets and expose no receive hook, so packets are drained here and
+    // diffed straight away - cut latency is bounded by TALLY_CHECK_INTERVAL.
+    void handleATEM() {
+        samplePollJitter();
+        if (!networkConnected) return;
+
+        atem.poll();
+        checkATEMHealth();
+        bool live = atemLive();
+
+        // Diff before announcing a resumed session so its first broadcast
+        // already carries the switcher's fresh states
+        if (live) {
+            checkATEMTallyStates();
+        }
+        if (live != atemWasLive) {
+            onATEMLiveChanged(live);
+        }
+
+        // Tallies hear every status change (live, unconfirmed, NO_ATEM) now,
+        // not at their next heartbeat
+        if (bridgeStatus() != atemStatus) {
+            onATEMStatusChanged();
+        }
+
+        // Poll fast while a handshake streams the initial state dump - the
+        // UDP receive queue is short and drops what is not drained
+        bool handshaking = !live && atemHandshaking && clockMillis() - atemLastRx < ATEM_HANDSHAKE_TIMEOUT;
+        if (handshaking != atemFastPoll) {
+            atemFastPoll = handshaking;
+            unsigned long interval = handshaking ? ATEM_HANDSHAKE_POLL_INTERVAL : TALLY_CHECK_INTERVAL;
+            timers.start(tallyCheckTimer, interval, interval);
+            pollInterval = interval;
+            lastPollMicros = 0;
+        }
+
+        if (!live && !timers.isPending(atemReconnectTimer)) {
+            // Session lost or dead - retry straight away, then back off
+            timers.start(atemReconnectTimer, 0);
+        }
+    }
+
+    // Sample the source's packet count and re-evaluate session health. The
+    // library keeps reporting connected for seconds after a switcher power
+    // cycle; silence on the session is caught within ATEM_DEAD_TIMEOUT.
+    void checkATEMHealth() {
+        unsigned long now = clockMillis();
+        unsigned long packets = atem.getPacketCount();
+        bool received = (packets != atemPackets);
+        atemPackets = packets;
+        if (received) {
+            atemLastRx = now;
+        }
+
+        if (!atem.isConnected()) {
+            atemSessionUp = false;
+            return;
+        }
+        if (!atemSessionUp) {
+            atemSessionUp = true;
+            atemHealth.begin(now);
+        } else if (received) {
+            atemHealth.onPacket(now);
+        }
+
+        AtemHealthStatus previous = atemHealth.getStatus();
+        AtemHealthStatus health = atemHealth.update(now);
+        if (health == previous) return;
+
+        if (health == ATEM_DEAD) {
+            Serial.printf("✗ ATEM session dead - no packets for %lu ms, reconnecting\n",
+                         now - atemHealth.getLastPacket());
+        } else if (health == ATEM_DEGRADED) {
+            if (logEvents()) {
+                Serial.printf("ATEM session degraded - no packets for %lu ms\n",
+                             now - atemHealth.getLastPacket());
+            }
+        } else if (previous == ATEM_DEAD || logEvents()) {
+            Serial.println("✓ ATEM session healthy again");
+        }
+    }
+
+    // The session became authoritative or stopped being so
+    void onATEMLiveChanged(bool live) {
+        unsigned long now = clockMillis();
+        atemWasLive = live;
+
+        if (!live) {
+            // Keep serving the last known states, marked unconfirmed, while
+            // the session comes back
+            atemLostAt = now;
+            Serial.println("ATEM session lost - tallies keep last known states (unconfirmed)");
+            return;
+        }
+
+        atemBackoff.reset();
+        timers.stop(atemReconnectTimer);
+        if (atemHandshaking) {
+            atemHandshaking = false;
+            atemHandshakeTime = now - atemConnectAt;
+        }
+        if (atemLostAt != 0) {
+            atemResumes++;
+            Serial.printf("✓ ATEM session resumed after %lu ms (handshake %lu ms)\n",
+                         now - atemLostAt, atemHandshakeTime);
+            atemLostAt = 0;
+        } else {
+            Serial.printf("✓ ATEM session up (handshake %lu ms)\n", atemHandshakeTime);
+        }
+    }
+
+    // The bridge status changed - push it with every camera's state
+    void onATEMStatusChanged() {
+        atemStatus = bridgeStatus();
+        if (atemStatus == 0 && atemLostAt != 0) {
+            Serial.println("✗ ATEM not back within the resume window - tallies show NO ATEM");
+        }
+
+        publishSnapshot();
+        for (int slot = 0; slot < FrameSlots; slot++) {
+            broadcastTallyData(slot);
+        }
+    }
+
+    // ATEM reconnection (timer). A handshake still receiving its initial
+    // state dump is left alone; a silent one is retried with backoff.
+    void reconnectATEM() {
+        if (!networkConnected || atemLive()) return;
+
+        unsigned long quiet = clockMillis() - atemLastRx;
+        if (atemHandshaking && quiet < ATEM_HANDSHAKE_TIMEOUT) {
+            timers.start(atemReconnectTimer, ATEM_HANDSHAKE_TIMEOUT - quiet);
+            return;
+        }
+
+        if (atemBackoff.getAttempts() == 0) {
+            Serial.println("ATEM connection lost - attempting reconnection...");
+        } else if (logEvents()) {
+            Serial.printf("ATEM handshake timed out - retry %d\n", atemBackoff.getAttempts());
+        }
+        connectToATEM();
+        timers.start(atemReconnectTimer, ATEM_HANDSHAKE_TIMEOUT + atemBackoff.nextDelay());
+    }
+
+    // ===============================================
+    // SYSTEM FUNCTIONS
+    // ===============================================
+
+    // Create loop events and scheduled work (before BLE starts, since callbacks
+    // arm heartbeats and wake the loop)
+    void initializeTimers() {
+        loopEvents = xEventGroupCreate();
+        Serial.onReceive(onSerialReceive);
+
+        tallyCheckTimer = timers.create(onTimer, JOB_TALLY_CHECK);
+        networkCheckTimer = timers.create(onTimer, JOB_NETWORK_CHECK);
+        atemReconnectTimer = timers.create(onTimer, JOB_ATEM_RECONNECT);
+        loopStatsTimer = timers.create(onTimer, JOB_LOOP_STATS);
+        otaFetchTimer = timers.create(onTimer, JOB_OTA_FETCH);
+        centralScanTimer = timers.create(onTimer, JOB_CENTRAL_SCAN);
+        advertisingTimer = timers.create(onTimer, JOB_ADVERTISING);
+        for (int i = 0; i < MaxDevices; i++) {
+            heartbeatTimers[i] = timers.create(onTimer, JOB_HEARTBEAT + i);
+        }
+    }
+
+    void runTimer(int job) {
+        // Show mode: incidental jobs wait for the deferred budget
+        if (showMode && (job == JOB_NETWORK_CHECK || job == JOB_OTA_FETCH)) {
+            deferredJobs |= 1UL << job;
+            return;
+        }
+        runJob(job);
+    }
+
+    void runJob(int job) {
+        switch (job) {
+            case JOB_TALLY_CHECK:
+                handleATEM();
+                break;
+            case JOB_NETWORK_CHECK:
+                checkNetwork();
+                break;
+            case JOB_ATEM_RECONNECT:
+                reconnectATEM();
+                break;
+            case JOB_LOOP_STATS:
+                // Sample main loop passes per second
+                loopsPerSecond = loopCount;
+                loopCount = 0;
+                break;
+            case JOB_OTA_FETCH:
+                continueOtaFetch();
+                break;
+            case JOB_CENTRAL_SCAN:
+                serviceCentral();
+                break;
+            case JOB_ADVERTISING:
+                updateAdvertising();
+                break;
+            default:
+                sendHeartbeatSignal(job - JOB_HEARTBEAT);
+                break;
+        }
+    }
+
+    // Enter or leave show mode (serial SHOW ON/OFF or BRIDGE_SHOW from a
+    // tally). Show mode mutes event logging and library debug output and
+    // moves network checks, OTA downloads and serial parsing to the deferred
+    // budget, so nothing incidental runs ahead of a cut.
+    void setShowMode(bool on, const char* source) {
+        if (on == showMode) return;
+
+        showMode = on;
+        atem.setVerbose(!on);
+        lastPollMicros = 0;
+        if (!on) {
+            // Catch up on whatever was deferred
+            for (int job = 0; job < JOB_HEARTBEAT; job++) {
+                if (deferredJobs & (1UL << job)) {
+                    runJob(job);
+                }
+            }
+            deferredJobs = 0;
+        }
+        Serial.printf("Show mode %s (%s)\n", on ? "ON - non-essential work deferred" : "OFF", source);
+    }
+
+    // Show mode budget: one deferred job per loop pass, only when no timer
+    // (tally poll, heartbeat) is due within SHOW_DEFERRED_SLACK
+    void runDeferredWork() {
+        bool pending = deferredJobs != 0 || Serial.available();
+        if (!pending) return;
+        if (timers.msUntilNext(SHOW_DEFERRED_SLACK) < SHOW_DEFERRED_SLACK) {
+            deferredWaits++;
+            return;
+        }
+
+        deferredRuns++;
+        if (Serial.available()) {
+            handleSerialCommands();
+            return;
+        }
+        for (int job = 0; job < JOB_HEARTBEAT; job++) {
+            if (deferredJobs & (1UL << job)) {
+                deferredJobs &= ~(1UL << job);
+                runJob(job);
+                return;
+            }
+        }
+    }
+
+    // How far each tally poll strayed from its period, kept per mode so show
+    // mode can be compared with normal operation
+    void samplePollJitter() {
+        unsigned long now = micros();
+        if (lastPollMicros != 0) {
+            long late = (long)(now - lastPollMicros) - (long)(pollInterval * 1000);
+            unsigned long jitter = (late < 0) ? -late : late;
+            PollJitter& j = pollJitter[showMode ? 1 : 0];
+            j.samples++;
+            j.total += jitter;
+            if (jitter > j.max) j.max = jitter;
+        }
+        lastPollMicros = now;
+    }
+
+    void printPollJitter(const char* mode, const PollJitter& j) {
+        Serial.printf("Poll jitter (%s): mean %lu us, max %lu us over %lu polls\n", mode,
+                     j.samples > 0 ? (unsigned long)(j.total / j.samples) : 0, j.max, j.samples);
+    }
+
+    // Collect a serial line without blocking - a partial line waits for the
+    // next pass instead of stalling the loop for the stream timeout
+    bool readSerialLine(String& line) {
+        while (Serial.available()) {
+            char c = Serial.read();
+            if (c == '\n') {
+                line = serialLine;
+                serialLine = "";
+                return true;
+            }
+            if (serialLine.length() < SERIAL_LINE_MAX) {
+                serialLine += c;
+            }
+        }
+        return false;
+    }
+
+    // Print system status
+    void printSystemStatus() {
+        Serial.println("\n==== ESP32 ATEM Bridge v3.0 Status ====");
+        Serial.printf("Uptime: %lu seconds\n", (clockMillis() - systemStartTime) / 1000);
+        Serial.printf("Network: %s", networkConnected ? "Connected" : "Disconnected");
+        if (networkConnected) {
+            Serial.printf(" (%s)", WiFi.localIP().toString().c_str());
+        }
+        Serial.println();
+
+        Serial.printf("ATEM: %s (%s)\n", atem.isConnected() ? "Connected" : "Disconnected", atem.name());
+        if (atem.isConnected()) {
+            Serial.printf("ATEM session: %s, packet gap mean %lu ms / max %lu ms\n",
+                         atemHealth.getStatusName(), atemHealth.getMeanGap(), atemHealth.getMaxGap());
+        }
+        if (atemResuming()) {
+            Serial.printf("ATEM resume: serving unconfirmed states for %lu ms, retry %d\n",
+                         clockMillis() - atemLostAt, atemBackoff.getAttempts());
+        }
+        if (atemResumes > 0) {
+            Serial.printf("ATEM resumes: %lu, last handshake %lu ms\n", atemResumes, atemHandshakeTime);
+        }
+        if (atemHealth.getDegradedEvents() > 0) {
+            Serial.printf("ATEM health: %lu degraded, %lu dead, %lu recovered without reconnect\n",
+                         atemHealth.getDegradedEvents(), atemHealth.getDeadEvents(), atemHealth.getRecoveries());
+        }
+        Serial.printf("BLE: %d/%d devices connected\n", numConnectedDevices, MaxDevices);
+
+        // List registered devices
+        int registeredCount = 0;
+        unsigned long readRetries = snapshot.getRetries() + tallyView.getRetries();
+        for (int i = 0; i < MaxDevices; i++) {
+            TallyDevice device = tallyDevices[i].read();
+            readRetries += tallyDevices[i].getRetries();
+            if (device.registered) {
+                registeredCount++;
+                Serial.printf("  %s (CAM%d) - %s\n",
+                             device.deviceName,
+                             device.cameraId,
+                             device.connected ? "Connected" : "Disconnected");
+            }
+        }
+        Serial.printf("Registered Devices: %d\n", registeredCount);
+
+        Serial.printf("Messages: %lu received, %lu sent\n", totalMessagesReceived, totalMessagesSent);
+        Serial.printf("Notifications: %lu carrying %lu frames, %lu superseded\n",
+                     totalNotifications, totalFramesSent, framesSuperseded);
+        Serial.printf("Frame cache: %lu encodes for %lu frames sent\n", framesEncoded, totalFramesSent);
+        Serial.printf("Congestion: %lu events, %lu flushes held back, %lu refused\n",
+                     congestionEvents, heldBackFlushes, notifyFailures);
+        Serial.printf("Snapshot: %u bytes, read %lu times, advertised state %lu updates\n",
+                     (unsigned)snapshot.read().length, snapshotReads, advertUpdates);
+        Serial.printf("Shared state: %lu reader retries\n", readRetries);
+        if (!BRIDGE_CENTRAL) {
+            unsigned long uptime = clockMillis() - systemStartTime;
+            Serial.printf("Advertising: %s, %lu bursts, %lu changes, fast %lu%% of uptime\n",
+                         advertisingPolicy.getModeName(), advertisingPolicy.getBursts(),
+                         advertisingPolicy.getChanges(),
+                         uptime > 0 ? (unsigned long)((uint64_t)advertisingPolicy.getFastTime(clockMillis()) * 100 / uptime) : 0);
+        }
+        Serial.printf("Main loop: %lu passes/s\n", loopsPerSecond);
+        Serial.printf("Show mode: %s, %lu deferred runs, %lu waits for slack\n",
+                     showMode ? "ON" : "OFF", deferredRuns, deferredWaits);
+        printPollJitter("normal", pollJitter[0]);
+        printPollJitter("show", pollJitter[1]);
+#if BRIDGE_TALLY_OTA
+        if (ota.isActive()) {
+            Serial.printf("Tally OTA: %lu updated, %lu current, %lu failed (%lu s)\n",
+                         ota.getUpdated(), ota.getCurrent(), ota.getFailed(), ota.getElapsed() / 1000);
+        }
+#endif
+
+        if (lastStateChange > 0) {
+            Serial.printf("Last tally change: %lu seconds ago\n",
+                         (clockMillis() - lastStateChange) / 1000);
+        }
+
+        Serial.println("=======================================\n");
+    }
+
+    // Print build configuration with flash and RAM usage (SIZE command)
+    void printSizeReport() {
+        static const char* logLevelNames[] = {"ERROR", "INFO", "DEBUG"};
+
+        Serial.println("\n==== Bridge Build Configuration ====");
+        Serial.printf("Tally source: %s\n", atem.name());
+        Serial.printf("Cameras: %d, Devices: %d, Standby preview: %s, Log level: %s\n",
+                     MaxCameras, MaxDevices, StandbyAsPreview ? "ON" : "OFF",
+                     logLevelNames[LogLevel < 3 ? LogLevel : 2]);
+        Serial.printf("Flash: sketch %lu bytes, free for OTA %lu bytes\n",
+                     (unsigned long)ESP.getSketchSize(), (unsigned long)ESP.getFreeSketchSpace());
+        Serial.printf("RAM: bridge core %u bytes, tally source %u bytes (static)\n",
+                     (unsigned)sizeof(*this), (unsigned)sizeof(TallySource));
+        Serial.printf("Heap: %lu free of %lu, minimum free %lu bytes\n",
+                     (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getHeapSize(),
+                     (unsigned long)ESP.getMinFreeHeap());
+        Serial.printf("{\"cameras\":%d,\"devices\":%d,\"standby\":%s,\"log_level\":%d,"
+                      "\"sketch_bytes\":%lu,\"core_ram\":%u,\"source_ram\":%u,\"free_heap\":%lu}\n",
+                      MaxCameras, MaxDevices, StandbyAsPreview ? "true" : "false", LogLevel,
+                      (unsigned long)ESP.getSketchSize(), (unsigned)sizeof(*this),
+                      (unsigned)sizeof(TallySource), (unsigned long)ESP.getFreeHeap());
+        Serial.println("====================================\n");
+    }
+
+    // Handle serial commands for testing and debugging
+    void handleSerialCommands() {
+        String command;
+        if (!readSerialLine(command)) return;
+        command.trim();
+        String argument = command.substring(command.lastIndexOf(' ') + 1); // Case kept (URLs)
+        command.toUpperCase();
+
+        // Manual tally commands: "CAM1:PREVIEW", "CAM2:PROGRAM", etc.
+        int colonIndex = command.indexOf(':');
+        if (logDebug && colonIndex > 0) {
+            String camStr = command.substring(0, colonIndex);
+            String stateStr = command.substring(colonIndex + 1);
+
+            if (camStr.startsWith("CAM") && camStr.length() > 3) {
+                uint8_t cameraId = camStr.substring(3).toInt();
+                if (cameraId >= 1 && cameraId <= MaxCameras) {
+                    Serial.printf("Manual test: CAM%d -> %s\n", cameraId, stateStr.c_str());
+                    TallyMessage msg;
+                    encodeTallyMessage(&msg, cameraId, stateStr.c_str());
+                    portENTER_CRITICAL(&linkLock);
+                    frameCache[cameraId] = msg;
+                    portEXIT_CRITICAL(&linkLock);
+                    frameStates[cameraId] = nullptr; // Next publish restores it
+                    broadcastTallyData(cameraId);
+                } else {
+                    Serial.printf("Error: Camera ID must be 1-%d\n", MaxCameras);
+                }
+            }
+        }
+        // System commands
+        else if (command == "STATUS") {
+            printSystemStatus();
+        }
+        else if (command == "SIZE") {
+            printSizeReport();
+        }
+        else if (command == "SHOW ON" || command == "SHOW OFF") {
+            setShowMode(command == "SHOW ON", "serial");
+        }
+        else if (logInfo && command == "NETWORK") {
+            Serial.printf("Network Status: %s\n", networkConnected ? "Connected" : "Disconnected");
+            if (networkConnected) {
+                Serial.printf("IP: %s, Gateway: %s, DNS: %s\n",
+                             WiFi.localIP().toString().c_str(),
+                             WiFi.gatewayIP().toString().c_str(),
+                             WiFi.dnsIP().toString().c_str());
+            }
+        }
+        else if (logInfo && command == "ATEM") {
+            Serial.printf("ATEM Status: %s\n", atem.isConnected() ? "Connected" : "Disconnected");
+            if (atem.isConnected()) {
+                Serial.printf("Library: %s\n", atem.name());
+                Serial.printf("Tally Sources: %d\n", atem.getSourceCount());
+                Serial.printf("Session: %s (%s), last packet %lu ms ago, %lu packets\n",
+                             atemHealth.getStatusName(), atemHealth.isArmed() ? "armed" : "arming",
+                             clockMillis() - atemHealth.getLastPacket(), atemHealth.getPackets());
+                Serial.printf("Packet gap: mean %lu ms, max %lu ms (degraded after %lu ms, dead after %lu ms)\n",
+                             atemHealth.getMeanGap(), atemHealth.getMaxGap(),
+                             atemHealth.getDegradedTimeout(), atemHealth.getDeadTimeout());
+            }
+        }
+        else if (logInfo && command == "BLE") {
+            Serial.printf("BLE Status: %d/%d devices connected\n", numConnectedDevices, MaxDevices);
+            Serial.printf("Device Name: %s\n", BLE_DEVICE_NAME);
+#if BRIDGE_CENTRAL
+            Serial.printf("Role: central, interval %.2f ms, %lu scans, %lu connects, %lu failed\n",
+                         CENTRAL_CONN_INTERVAL * 1.25, central.getScans(),
+                         central.getConnects(), central.getConnectFailures());
+#else
+            Serial.printf("Service UUID: %s\n", BLE_SERVICE_UUID);
+            Serial.printf("Advertising: %s (state seq %u, ATEM %s, program 0x%08lX, preview 0x%08lX)\n",
+                         advertisingPolicy.getModeName(),
+                         advertisement.sequence,
+                         (advertisement.status & TALLY_ADV_STATUS_ATEM) ? "OK" : "DISCONNECTED",
+                         (unsigned long)advertisement.program, (unsigned long)advertisement.preview);
+#endif
+            for (int i = 0; i < MaxDevices; i++) {
+                if (links[i].active) {
+                    Serial.printf("  Link %d: MTU %d, %d in flight%s%s\n",
+                                 links[i].connId, links[i].mtu, links[i].inFlight,
+                                 links[i].congested ? ", congested" : "",
+                                 hasPendingFrames(links[i]) ? ", frames pending" : "");
+                }
+            }
+        }
+        else if (logInfo && command == "DEVICES") {
+            Serial.println("Registered BLE Tally Devices:");
+            for (int i = 0; i < MaxDevices; i++) {
+                TallyDevice device = tallyDevices[i].read();
+                if (device.registered) {
+                    unsigned long lastSeenAge = (clockMillis() - device.lastSeen) / 1000;
+                    Serial.printf("%d. %s (CAM%d) - %s (last seen %lu sec ago, heartbeat %dms)\n",
+                                 i + 1,
+                                 device.deviceName,
+                                 device.cameraId,
+                                 device.connected ? "Connected" : "Disconnected",
+                                 lastSeenAge,
+                                 device.heartbeatInterval);
+                }
+            }
+        }
+        else if (command == "RESET") {
+            Serial.println("Restarting ESP32...");
+            delay(1000);
+            ESP.restart();
+        }
+        else if (logInfo && command == "STANDBY") {
+            Serial.printf("Standby Preview Mode: %s\n", StandbyAsPreview ? "ENABLED" : "DISABLED");
+
+            // Show current production status
+            TallyView view = tallyView.read();
+            bool anyProgramActive = false;
+            int programCamera = 0;
+            int previewCamera = 0;
+
+            for (int cam = 1; cam <= MaxCameras; cam++) {
+                if (view.states[cam] & TALLY_FLAG_PROGRAM) {
+                    anyProgramActive = true;
+                    programCamera = cam;
+                }
+                if (view.states[cam] & TALLY_FLAG_PREVIEW) {
+                    previewCamera = cam;
+                }
+            }
+
+            Serial.printf("Production Status: %s\n", anyProgramActive ? "ACTIVE" : "STANDBY");
+            if (programCamera > 0) {
+                Serial.printf("PROGRAM Camera: %d\n", programCamera);
+            }
+            if (previewCamera > 0) {
+                Serial.printf("PREVIEW Camera: %d\n", previewCamera);
+            }
+
+            if (StandbyAsPreview && anyProgramActive) {
+                Serial.println("Non-active cameras showing as PREVIEW (ready/standby)");
+            }
+        }
+        else if (command == "OTA" || command == "OTA START" || command == "OTA STOP") {
+            handleOtaCommand(command, "");
+        }
+        else if (command.startsWith("OTA FETCH")) {
+            handleOtaCommand("OTA FETCH", command.length() > 9 ? argument : String());
+        }
+        else if (logDebug && command == "BENCH") {
+            Serial.printf("Running microbenchmarks (%d iterations)...\n", BENCH_ITERATIONS);
+            runBenchmarks();
+            Serial.println("Benchmarks complete");
+        }
+        else if (command == "HELP") {
+            Serial.println("\nAvailable Commands:");
+            if (logDebug) {
+                Serial.println("CAMx:STATE  - Send test tally (e.g., CAM1:PREVIEW, CAM1:PROGRAM)");
+            }
+            Serial.println("STATUS      - Show system status");
+            Serial.println("SIZE        - Show build configuration, flash and RAM usage");
+            Serial.println("SHOW ON|OFF - Show mode: defer non-essential work while on air");
+            if (logInfo) {
+                Serial.println("NETWORK     - Show network status");
+                Serial.println("ATEM        - Show ATEM status");
+                Serial.println("BLE         - Show BLE status");
+                Serial.println("DEVICES     - List registered tally devices");
+                Serial.println("STANDBY     - Show standby preview mode status");
+            }
+            if (logDebug) {
+                Serial.println("BENCH       - Run protocol microbenchmarks (JSON lines)");
+            }
+            if (BRIDGE_TALLY_OTA) {
+                Serial.println("OTA         - Show tally firmware image and transfer progress");
+                Serial.println("OTA FETCH [url] - Download a tally image (default TALLY_OTA_URL)");
+                Serial.println("OTA START   - Push the image to all connected tallies");
+                Serial.println("OTA STOP    - Stop pushing the image");
+            }
+            Serial.println("RESET       - Restart ESP32");
+            Serial.println("HELP        - Show this help\n");
+            Serial.printf("Standby Preview Mode: %s\n", StandbyAsPreview ? "ENABLED" : "DISABLED");
+        }
+        else {
+            Serial.println("Unknown command. Type HELP for available commands.");
+        }
+    }
+
+    // ===============================================
+    // BENCHMARKS
+    // ===============================================
+
+    // Print one benchmark result as a JSON line (machine-readable, one per bench)
+    void printBenchResult(const char* name, int param, uint32_t iterations, uint32_t cycles) {
+        float cyclesPerOp = (float)cycles / iterations;
+        Serial.printf("{\"bench\":\"%s\",\"param\":%d,\"iterations\":%lu,"
+                      "\"cycles_per_op\":%.1f,\"ns_per_op\":%.1f,\"cpu_mhz\":%lu,\"atem\":%s}\n",
+                      name, param, (unsigned long)iterations, cyclesPerOp,
+                      cyclesPerOp * 1000.0f / ESP.getCpuFreqMHz(),
+                      (unsigned long)ESP.getCpuFreqMHz(),
+                      atem.isConnected() ? "true" : "false");
+    }
+
+    // Time the protocol hot paths with the CPU cycle counter (BENCH command).
+    // Logging and radio transmission are excluded - only the CPU work is timed.
+    void runBenchmarks() {
+        const uint32_t n = BENCH_ITERATIONS;
+        uint32_t start;
+        TallyMessage msg;
+        encodeTallyMessage(&msg, 1, "PROGRAM");
+
+        // calculateChecksum
+        start = ESP.getCycleCount();
+        for (uint32_t i = 0; i < n; i++) {
+            msg.cameraId = i;
+            benchSink += calculateChecksum(&msg);
+        }
+        printBenchResult("calculateChecksum", 0, n, ESP.getCycleCount() - start);
+
+        // verifyMessage (tally side: verifyTallyMessage)
+        encodeTallyMessage(&msg, 1, "PROGRAM");
+        start = ESP.getCycleCount();
+        for (uint32_t i = 0; i < n; i++) {
+            benchSink += verifyTallyMessage(&msg);
+        }
+        printBenchResult("verifyMessage", 0, n, ESP.getCycleCount() - start);
+
+        // TallyMessage encode
+        start = ESP.getCycleCount();
+        for (uint32_t i = 0; i < n; i++) {
+            encodeTallyMessage(&msg, (i % MaxCameras) + 1, (i & 1) ? "PREVIEW" : "PROGRAM");
+            benchSink += msg.checksum;
+        }
+        printBenchResult("encodeTallyMessage", 0, n, ESP.getCycleCount() - start);
+
+        // TallyMessage decode (tally side: size check, verify, extract state)
+        uint8_t wire[sizeof(TallyMessage)];
+        encodeTallyMessage(&msg, 1, "PROGRAM");
+        memcpy(wire, &msg, sizeof(wire));
+        start = ESP.getCycleCount();
+        for (uint32_t i = 0; i < n; i++) {
+            TallyMessage decoded;
+            memcpy(&decoded, wire, sizeof(decoded));
+            if (calculateChecksum(&decoded) == decoded.checksum) {
+                benchSink += decoded.cameraId + strlen(decoded.state);
+            }
+        }
+        printBenchResult("decodeTallyMessage", 0, n, ESP.getCycleCount() - start);
+
+        // getCurrentTallyState - one sweep over the first N cameras
+        const int cameraCounts[] = {1, 4, 10, MaxCameras};
+        for (int c = 0; c < 4; c++) {
+            int cameras = min(cameraCounts[c], (int)MaxCameras);
+            uint32_t sweeps = n / cameras;
+            start = ESP.getCycleCount();
+            for (uint32_t i = 0; i < sweeps; i++) {
+                for (int cam = 1; cam <= cameras; cam++) {
+                    benchSink += (uintptr_t)getCurrentTallyState(cam);
+                }
+            }
+            printBenchResult("getCurrentTallyState", cameras, sweeps, ESP.getCycleCount() - start);
+        }
+
+        // checkATEMTallyStates - steady-state diff (needs live ATEM tally data)
+        if (atem.isConnected()) {
+            checkATEMTallyStates(); // Settle any pending change first
+            uint32_t passes = n / 10;
+            start = ESP.getCycleCount();
+            for (uint32_t i = 0; i < passes; i++) {
+                checkATEMTallyStates();
+            }
+            printBenchResult("checkATEMTallyStates", MaxCameras, passes, ESP.getCycleCount() - start);
+        } else {
+            Serial.println("{\"bench\":\"checkATEMTallyStates\",\"skipped\":\"ATEM not connected\"}");
+        }
+
+        // Multi-camera cut - encode a full sweep and pack it into notifications
+        // at TALLY_BLE_MTU, setValue on a stub characteristic (no radio)
+        BLECharacteristic stub(BLEUUID((uint16_t)0xFFF1));
+        uint8_t container[TALLY_BLE_MTU - 3];
+        size_t used;
+        uint32_t sweeps = n / MaxCameras;
+        start = ESP.getCycleCount();
+        for (uint32_t i = 0; i < sweeps; i++) {
+            used = 0;
+            for (int cam = 1; cam <= MaxCameras; cam++) {
+                encodeTallyMessage(&msg, cam, "PREVIEW");
+                if (!packTallyFrame(container, used, sizeof(container), &msg)) {
+                    stub.setValue(container, used);
+                    used = 0;
+                    packTallyFrame(container, used, sizeof(container), &msg);
+                }
+            }
+            stub.setValue(container, used);
+        }
+        printBenchResult("packTallyFrames", MaxCameras, sweeps, ESP.getCycleCount() - start);
+
+        // broadcastTallyData fan-out - a cut (two cameras) queued on every link,
+        // then each link's notification packed and set on the stub (no radio)
+        uint32_t benchQueued[MaxDevices][FrameSlots] = {};
+        uint32_t benchSeq = 0;
+        TallyNotification note;
+        for (int devices = 1; devices <= MaxDevices; devices++) {
+            uint32_t cuts = n / devices;
+            start = ESP.getCycleCount();
+            for (uint32_t i = 0; i < cuts; i++) {
+                for (int d = 0; d < devices; d++) {
+                    queueTallyFrame(benchQueued[d], 1, benchSeq);
+                    queueTallyFrame(benchQueued[d], 2, benchSeq);
+                }
+                for (int d = 0; d < devices; d++) {
+                    packTallyNotification(note, sizeof(note.buffer), frameCache, benchQueued[d], FrameSlots);
+                    stub.setValue((uint8_t*)note.data, note.length);
+                }
+            }
+            printBenchResult("broadcastTallyData", devices, cuts, ESP.getCycleCount() - start);
+        }
+
+        // Tally side - split a full container back into frames
+        used = 0;
+        while (packTallyFrame(container, used, sizeof(container), &msg)) {}
+        TallyMessage unpacked[TALLY_MAX_BATCH_FRAMES];
+        start = ESP.getCycleCount();
+        for (uint32_t i = 0; i < n; i++) {
+            benchSink += unpackTallyFrames(container, used, unpacked, TALLY_MAX_BATCH_FRAMES);
+        }
+        printBenchResult("unpackTallyFrames", TALLY_MAX_BATCH_FRAMES, n, ESP.getCycleCount() - start);
+
+        // TALLY_REG parsing (onWrite)
+        const String regMessage = "TALLY_REG:1:Tally_CAM_1:250";
+        uint8_t cameraId;
+        char deviceName[TALLY_NAME_LENGTH];
+        uint16_t heartbeatInterval;
+        uint32_t parses = n / 10;
+        start = ESP.getCycleCount();
+        for (uint32_t i = 0; i < parses; i++) {
+            if (parseRegistration(regMessage, cameraId, deviceName, sizeof(deviceName), heartbeatInterval)) {
+                benchSink += cameraId + heartbeatInterval;
+            }
+        }
+        printBenchResult("parseRegistration", 0, parses, ESP.getCycleCount() - start);
+    }
+
+    // ===============================================
+    // STATE
+    // ===============================================
+
+    // Tally source (ATEM connection)
+    TallySource& atem;
+    bool networkConnected = false;
+
+    // USB tethering network (checkNetwork() state machine)
+    enum NetworkState {
+        NETWORK_WAITING,         // Polling for an interface address
+        NETWORK_SETTLING,        // Address up, ATEM handshake after the settle time
+        NETWORK_UP               // Checked every NETWORK_CHECK_INTERVAL
+    };
+    NetworkState networkState = NETWORK_WAITING;
+    unsigned long networkSince = 0;          // clockMillis() the current wait started
+    unsigned long networkSettleTime = 0;
+    unsigned long networkPolls = 0;
+
+    // ATEM session health (switcher packet inter-arrival)
+    AtemHealth atemHealth{ATEM_DEGRADED_TIMEOUT, ATEM_DEAD_TIMEOUT};
+    unsigned long atemPackets = 0;
+    unsigned long atemLastRx = 0;           // clockMillis() of the last packet sample that moved
+    bool atemSessionUp = false;
+
+    // ATEM session resume (immediate retry with backoff, unconfirmed states
+    // served meanwhile)
+    ReconnectBackoff atemBackoff{ATEM_RETRY_INTERVAL, ATEM_RECONNECT_INTERVAL};
+    bool atemWasLive = false;
+    bool atemHandshaking = false;
+    bool atemFastPoll = false;
+    uint8_t atemStatus = 0;                 // TALLY_BRIDGE_* bits last announced to tallies
+    unsigned long atemLostAt = 0;           // 0 = no session lost since the last live one
+    unsigned long atemConnectAt = 0;
+    unsigned long atemHandshakeTime = 0;
+    unsigned long atemResumes = 0;
+
+    // BLE Server
+    BLEServer* pServer = nullptr;
+    BLEService* pService = nullptr;
+    BLECharacteristic* pCharacteristic = nullptr;
+    BLECharacteristic* pSnapshotCharacteristic = nullptr;
+    BLECharacteristic* pOtaCharacteristic = nullptr;
+
+#if BRIDGE_CENTRAL
+    // Links to advertising tallies (central topology)
+    BridgeCentral<MaxDevices> central;
+    CentralCallbacks centralCallbacks;
+#endif
+
+#if BRIDGE_TALLY_OTA
+    // Tally firmware image and per-link transfers
+    TallyOtaSender<MaxDevices> ota;
+#endif
+
+    // Current snapshot (read by tallies right after subscribing) and the
+    // tally view it was built from
+    SeqLock<SnapshotValue> snapshot;
+    SeqLock<TallyView> tallyView;
+    uint8_t snapshotStatus = 0;
+
+    // Tally state in the scan response (for tallies that have not connected)
+    TallyAdvertisement advertisement = {};
+
+    // Advertising interval (fast while tallies are expected back). Link
+    // events are counted on the BLE task and applied by the loop.
+    AdvertisingPolicy advertisingPolicy{ADV_BURST_WINDOW, ADV_MISSING_WINDOW};
+    volatile uint32_t linkConnects = 0;
+    volatile uint32_t linkDrops = 0;
+    uint32_t seenLinkConnects = 0;
+    uint32_t seenLinkDrops = 0;
+    // Device table: written by registrations and disconnects on the BLE task,
+    // read lock-free by the loop
+    SeqLock<TallyDevice> tallyDevices[MaxDevices];
+    portMUX_TYPE registrationLock = portMUX_INITIALIZER_UNLOCKED;
+    int numConnectedDevices = 0;
+
+    // BLE links by connection ID
+    PeerLink links[MaxDevices] = {};
+    uint32_t queueSeq = 0;
+    esp_gatt_if_t gattsIf = 0;
+    portMUX_TYPE linkLock = portMUX_INITIALIZER_UNLOCKED;
+
+    // Encoded frame per slot (0 = status/heartbeat), rebuilt by
+    // publishSnapshot() only where the state changed. Links queue slots and
+    // flushes pack these bytes, under linkLock.
+    TallyMessage frameCache[FrameSlots] = {};
+    const char* frameStates[FrameSlots] = {}; // State each slot was encoded from
+
+    // Tally state tracking
+    uint8_t currentTallyStates[MaxCameras + 1]; // Index 1-MaxCameras, 0 unused
+    unsigned long lastStateChange = 0;
+    unsigned long lastHeartbeat = 0;
+
+    // Scheduled work (periodic checks, per-device heartbeats, reconnection)
+    TimerWheel<MaxDevices + 6> timers;
+    int8_t tallyCheckTimer = -1;
+    int8_t networkCheckTimer = -1;
+    int8_t atemReconnectTimer = -1;
+    int8_t loopStatsTimer = -1;
+    int8_t otaFetchTimer = -1;
+    int8_t centralScanTimer = -1;
+    int8_t advertisingTimer = -1;
+    int8_t heartbeatTimers[MaxDevices];
+
+    // Main loop wake-up events
+    EventGroupHandle_t loopEvents = nullptr;
+    unsigned long loopCount = 0;
+    unsigned long loopsPerSecond = 0;
+    String serialLine;                     // Serial command being received
+
+    // Show mode: incidental work deferred while on air
+    bool showMode = false;
+    volatile int8_t showRequest = SHOW_REQUEST_NONE;
+    uint32_t deferredJobs = 0;             // Timer jobs waiting (1 << job)
+    unsigned long deferredRuns = 0;
+    unsigned long deferredWaits = 0;       // Passes without slack for deferred work
+    PollJitter pollJitter[2] = {};         // Normal, show
+    unsigned long lastPollMicros = 0;
+    unsigned long pollInterval = TALLY_CHECK_INTERVAL;
+
+    // Statistics
+    unsigned long totalMessagesReceived = 0;
+    unsigned long totalMessagesSent = 0;
+    unsigned long totalNotifications = 0;
+    unsigned long totalFramesSent = 0;
+    unsigned long framesSuperseded = 0;    // Unsent frames replaced by a newer state
+    unsigned long framesEncoded = 0;       // Frame cache slots re-encoded
+    unsigned long congestionEvents = 0;    // Links reported congested by the stack
+    unsigned long heldBackFlushes = 0;     // Flushes deferred by congestion or in-flight limit
+    unsigned long notifyFailures = 0;      // Notifications the stack refused
+    unsigned long snapshotReads = 0;       // Snapshot characteristic reads
+    unsigned long advertUpdates = 0;       // Scan response updates
+    unsigned long systemStartTime = 0;
+
+    // Keeps benchmark results live so the compiler cannot drop the measured work
+    volatile uint32_t benchSink = 0;
+};
+
+template <uint8_t MaxCameras, uint8_t MaxDevices, bool StandbyAsPreview, uint8_t LogLevel, class TallySource>
+ATEMBridgeCore<MaxCameras, MaxDevices, StandbyAsPreview, LogLevel, TallySource>*
+ATEMBridgeCore<MaxCameras, MaxDevices, StandbyAsPreview, LogLevel, TallySource>::instance = nullptr;
+
+#endif // ATEM_BRIDGE_CORE_H
@@ -0,0 +1,93 @@
+/*
+ * Lightweight ATEM Tally Source for the ESP32 ATEM Tally System
+ *
+ * Tally source for ATEMBridgeCore without the ATEMmin library, for the
+ * small-flash bridge build. Scans the switcher stream for tally records
+ * (simplified - you may need to adjust the pattern for your ATEM model).
+ *
+ * Implements the same interface as ATEMminSource. Flags are reported in the
+ * ATEM convention (bit 0 = PROGRAM, bit 1 = PREVIEW) like every other source.
+ *
+ * connect() runs on the bridge's loop task, so the TCP connect is bounded by
+ * ATEM_CONNECT_TIMEOUT - a switcher that is gone must not hold heartbeats
+ * back past the tallies' link-loss window (LINK_LOSS_TIMEOUT, 750 ms).
+ */
+
+#ifndef ATEM_LITE_SOURCE_H
+#define ATEM_LITE_SOURCE_H
+
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include "TallyProtocol.h"
+
+#ifndef ATEM_PORT
+#define ATEM_PORT 9910                        // ATEM port (usually 9910)
+#endif
+#ifndef ATEM_CONNECT_TIMEOUT
+#define ATEM_CONNECT_TIMEOUT 100              // Longest TCP connect attempt (ms, LAN handshakes take a few)
+#endif
+
+template <uint8_t MaxSources>
+class ATEMLiteSource {
+public:
+    ATEMLiteSource() {
+        memset(flags, 0, sizeof(flags));
+    }
+
+    const char* name() const { return "Lightweight parser"; }
+
+    bool connect(const IPAddress& ip) {
+        // Keep the last flags - they are only replaced by fresh records
+        client.stop();
+        return client.connect(ip, ATEM_PORT, ATEM_CONNECT_TIMEOUT);
+    }
+
+    // Drain pending bytes and update tally flags
+    void poll() {
+        while (client.available()) {
+            int bytesRead = client.read(buffer, sizeof(buffer));
+            if (bytesRead <= 0) break;
+            packets++;
+            parse(buffer, bytesRead);
+        }
+    }
+
+    bool isConnected() {
+        return client.connected();
+    }
+
+    unsigned long getPacketCount() const {
+        return packets;
+    }
+
+    uint8_t getSourceCount() {
+        return MaxSources;
+    }
+
+    uint8_t getTallyFlags(uint8_t index) {
+        return (index < MaxSources) ? flags[index] : 0;
+    }
+
+    // No library debug output to silence
+    void setVerbose(bool) {}
+
+private:
+    // Look for tally records: 0x01 0x00 <camera 1-N> <flags>
+    void parse(const uint8_t* data, int length) {
+        for (int i = 0; i < length - 4; i++) {
+            if (data[i] == 0x01 && data[i + 1] == 0x00) {
+                uint8_t cameraId = data[i + 2];
+                if (cameraId >= 1 && cameraId <= MaxSources) {
+                    flags[cameraId - 1] = data[i + 3] & (TALLY_FLAG_PROGRAM | TALLY_FLAG_PREVIEW);
+                }
+            }
+        }
+    }
+
+    WiFiClient client;
+    uint8_t flags[MaxSources];
+    uint8_t buffer[512];
+    unsigned long packets = 0;
+};
+
+#endif // ATEM_LITE_SOURCE_H
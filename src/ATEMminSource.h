@@ -0,0 +1,92 @@
+/*
+ * ATEMmin Tally Source for the ESP32 ATEM Tally System
+ *
+ * Tally source for ATEMBridgeCore backed by SKAARHOJ's ATEMmin library
+ * (full ATEM UDP protocol, tally-by-index). Used by the full bridge build.
+ *
+ * Tally source interface (duck-typed by the core):
+ *   const char* name()                   - Human-readable source name
+ *   bool connect(const IPAddress& ip)    - Start (or restart) a session, non-blocking
+ *   void poll()                          - Drain pending packets
+ *   bool isConnected()
+ *   unsigned long getPacketCount()       - Grows whenever packets arrive (session health)
+ *   uint8_t getSourceCount()             - Number of tally-by-index sources
+ *   uint8_t getTallyFlags(uint8_t index) - 0-based; TALLY_FLAG_PROGRAM/PREVIEW
+ *   void setVerbose(bool verbose)        - Library debug output (off in show mode)
+ */
+
+#ifndef ATEMMIN_SOURCE_H
+#define ATEMMIN_SOURCE_H
+
+#include <ATEMbase.h>
+#include <ATEMmin.h>
+
+// ATEMmin with the session's last-contact time exposed (protected in ATEMbase)
+class ATEMminSession : public ATEMmin {
+public:
+    unsigned long getLastContact() const { return _lastContact; }
+};
+
+class ATEMminSource {
+public:
+    const char* name() const { return "ATEMmin (SKAARHOJ)"; }
+
+    // Start the handshake and return - the session comes up in poll() as the
+    // switcher's initial state dump arrives. Calling it again restarts the
+    // session on the same socket.
+    bool connect(const IPAddress& ip) {
+        if (!begun) {
+            // Initialize ATEM library with IP
+            atem.begin(ip);
+            atem.serialOutput(verbose ? 1 : 0); // Moderate debug output
+            begun = true;
+        }
+        atem.connect();
+        return true;
+    }
+
+    // Run ATEM library loop - this handles all communication. The library
+    // stamps every packet it takes from the switcher; a new stamp counts as
+    // packets received since the last poll.
+    void poll() {
+        atem.runLoop();
+        if (atem.getLastContact() != lastContact) {
+            lastContact = atem.getLastContact();
+            packets++;
+        }
+    }
+
+    bool isConnected() {
+        return atem.isConnected();
+    }
+
+    unsigned long getPacketCount() const {
+        return packets;
+    }
+
+    uint8_t getSourceCount() {
+        return atem.getTallyByIndexSources();
+    }
+
+    // Library debug chatter on Serial (applied now or when the session starts)
+    void setVerbose(bool on) {
+        verbose = on;
+        if (begun) {
+            atem.serialOutput(verbose ? 1 : 0);
+        }
+    }
+
+    // ATEMmin uses 0-based indexing, so Camera 1 = index 0
+    uint8_t getTallyFlags(uint8_t index) {
+        return atem.getTallyByIndexTallyFlags(index);
+    }
+
+private:
+    ATEMminSession atem;
+    bool begun = false;
+    bool verbose = true;
+    unsigned long lastContact = 0;
+    unsigned long packets = 0;
+};
+
+#endif // ATEMMIN_SOURCE_H
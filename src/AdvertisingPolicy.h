@@ -0,0 +1,99 @@
+/*
+ * Advertising Policy for the ESP32 ATEM Tally System
+ *
+ * Picks the bridge's advertising interval. A scanning tally finds the bridge
+ * within about one advertising interval, so the interval is what a
+ * reconnecting tally waits for - but a fast interval costs radio time that
+ * the connected links share.
+ *
+ * - FAST for the burst window after boot and after any tally disconnect
+ * - FAST while a known (registered) tally is missing, up to the missing
+ *   window after the last disconnect
+ * - SLOW otherwise, so the bridge stays discoverable for new tallies
+ * - OFF while every connection slot is taken
+ *
+ * The bridge applies the mode from the main loop; the policy only decides.
+ */
+
+#ifndef ADVERTISING_POLICY_H
+#define ADVERTISING_POLICY_H
+
+#include <Arduino.h>
+
+typedef enum {
+    ADV_OFF,          // All slots taken - not connectable
+    ADV_FAST,         // Tally expected back soon
+    ADV_SLOW          // Every expected tally connected
+} AdvertisingMode;
+
+class AdvertisingPolicy {
+public:
+    AdvertisingPolicy(unsigned long burstWindow, unsigned long missingWindow)
+        : burstAfter(burstWindow), missingAfter(missingWindow) {
+        begin(0);
+    }
+
+    // Start with a burst (bridge boot)
+    void begin(unsigned long now) {
+        lastDrop = now;
+        mode = ADV_OFF;
+        modeSince = now;
+    }
+
+    // A tally link dropped - open a new burst
+    void onDisconnect(unsigned long now) {
+        lastDrop = now;
+        bursts++;
+    }
+
+    // Mode for the current connections
+    AdvertisingMode select(unsigned long now, bool slotFree, bool knownMissing) const {
+        if (!slotFree) return ADV_OFF;
+        unsigned long since = now - lastDrop;
+        if (since < burstAfter) return ADV_FAST;
+        if (knownMissing && since < missingAfter) return ADV_FAST;
+        return ADV_SLOW;
+    }
+
+    // Milliseconds until select() changes on its own (0 = only on an event)
+    unsigned long msUntilChange(unsigned long now, bool knownMissing) const {
+        unsigned long since = now - lastDrop;
+        unsigned long window = knownMissing ? max(burstAfter, missingAfter) : burstAfter;
+        return since < window ? window - since : 0;
+    }
+
+    // The bridge applied a mode (for the fast-time statistic)
+    void onApplied(AdvertisingMode next, unsigned long now) {
+        if (mode == ADV_FAST) {
+            fastTime += now - modeSince;
+        }
+        mode = next;
+        modeSince = now;
+        changes++;
+    }
+
+    AdvertisingMode getMode() const { return mode; }
+    const char* getModeName() const {
+        return mode == ADV_FAST ? "FAST" : (mode == ADV_SLOW ? "SLOW" : "OFF");
+    }
+
+    unsigned long getBursts() const { return bursts; }
+    unsigned long getChanges() const { return changes; }
+    unsigned long getFastTime(unsigned long now) const {
+        return fastTime + (mode == ADV_FAST ? now - modeSince : 0);
+    }
+
+private:
+    unsigned long burstAfter;
+    unsigned long missingAfter;
+
+    unsigned long lastDrop;
+    AdvertisingMode mode;
+    unsigned long modeSince;
+
+    unsigned long bursts = 0;
+    unsigned long changes = 0;
+    unsigned long fastTime = 0;
+};
+
+#endif // ADVERTISING_POLICY_H
@@ -0,0 +1,151 @@
+/*
+ * Ambient-Adaptive Brightness for the ESP32 ATEM Tally System
+ *
+ * Scales the tally LEDs to the room: dim in a dark studio, full brightness
+ * outdoors, and less battery spent whenever full brightness is not needed.
+ *
+ * - A light sensor (photodiode or phototransistor divider) on an ADC1 pin is
+ *   sampled from a timer; an exponential filter (AMBIENT_FILTER) keeps a
+ *   passing shadow or a photo flash from pumping the LEDs
+ * - ambientScale() maps the filtered level between AMBIENT_DARK and
+ *   AMBIENT_BRIGHT onto a scale of the configured LED brightness, from
+ *   AMBIENT_MIN_SCALE up to full
+ * - PROGRAM never drops below AMBIENT_PROGRAM_FLOOR - a live camera's red
+ *   light stays readable in any room
+ * - The LED output layer passes every channel through apply() and reports
+ *   what it drove; the average LED current is kept next to the current the
+ *   same pattern would have drawn without ambient scaling
+ *
+ * Without a sensor (pin < 0) the scale stays at full. sample() takes a raw
+ * reading, so the filter and curve run without ADC hardware.
+ */
+
+#ifndef AMBIENT_BRIGHTNESS_H
+#define AMBIENT_BRIGHTNESS_H
+
+#include <Arduino.h>
+
+#ifndef AMBIENT_DARK
+#define AMBIENT_DARK 200                      // Raw reading (0-4095) at or below which the scale is minimal
+#endif
+#ifndef AMBIENT_BRIGHT
+#define AMBIENT_BRIGHT 3000                   // Raw reading at or above which the scale is full
+#endif
+#ifndef AMBIENT_MIN_SCALE
+#define AMBIENT_MIN_SCALE 48                  // Scale of LED brightness in the dark (0-255)
+#endif
+#ifndef AMBIENT_PROGRAM_FLOOR
+#define AMBIENT_PROGRAM_FLOOR 128             // Lowest scale while on PROGRAM (0-255)
+#endif
+#ifndef AMBIENT_FILTER
+#define AMBIENT_FILTER 0.1f                   // Weight of each new sample in the filtered level
+#endif
+#ifndef AMBIENT_SAMPLE_INTERVAL
+#define AMBIENT_SAMPLE_INTERVAL 250           // Light sensor sample interval (ms)
+#endif
+#ifndef LED_CHANNEL_CURRENT
+#define LED_CHANNEL_CURRENT 20                // Current of one LED color channel at full duty (mA)
+#endif
+
+// Scale (0-255) of the configured LED brightness for a filtered ambient level
+inline uint8_t ambientScale(uint16_t level) {
+    if (level <= AMBIENT_DARK) return AMBIENT_MIN_SCALE;
+    if (level >= AMBIENT_BRIGHT) return 255;
+    return AMBIENT_MIN_SCALE +
+           (uint32_t)(255 - AMBIENT_MIN_SCALE) * (level - AMBIENT_DARK) / (AMBIENT_BRIGHT - AMBIENT_DARK);
+}
+
+class AmbientBrightness {
+public:
+    // Sensor pin (pin < 0 = not fitted) and the number of RGB emitters driven
+    // with the tally color (LED plus strip pixels), for the current estimate
+    bool begin(int pin, uint16_t emitters, unsigned long now) {
+        sensorPin = pin;
+        emitterCount = emitters;
+        meterStart = now;
+        lastOutput = now;
+        if (pin < 0) return false;
+
+        pinMode(pin, INPUT);
+        sample(analogRead(pin));
+        return true;
+    }
+
+    // Read the sensor (sample timer)
+    void update() {
+        if (sensorPin >= 0) {
+            sample(analogRead(sensorPin));
+        }
+    }
+
+    // Filter one raw reading into the level and scale
+    void sample(uint16_t raw) {
+        lastRaw = raw;
+        level = (samples == 0) ? raw : level + (raw - level) * AMBIENT_FILTER;
+        samples++;
+        scale = ambientScale((uint16_t)level);
+    }
+
+    // Channel value after ambient scaling (program = tally is on PROGRAM)
+    uint8_t apply(uint8_t value, bool program) const {
+        uint8_t s = (program && scale < AMBIENT_PROGRAM_FLOOR) ? AMBIENT_PROGRAM_FLOOR : scale;
+        return (value * s) / 255;
+    }
+
+    // The LED output changed: channel duty sums (0-765) driven, and before
+    // ambient scaling
+    void recordOutput(unsigned long now, uint16_t driven, uint16_t requested) {
+        accumulate(now);
+        drivenDuty = driven;
+        requestedDuty = requested;
+    }
+
+    // Average LED current since begin() (mA)
+    float averageCurrent(unsigned long now) {
+        accumulate(now);
+        return toMilliamps(drivenTotal, now);
+    }
+
+    // Average current of the same patterns without ambient scaling (mA)
+    float unscaledCurrent(unsigned long now) {
+        accumulate(now);
+        return toMilliamps(requestedTotal, now);
+    }
+
+    bool isFitted() const { return sensorPin >= 0; }
+    uint16_t getRaw() const { return lastRaw; }
+    uint16_t getLevel() const { return (uint16_t)level; }
+    uint8_t getScale() const { return scale; }
+    unsigned long getSamples() const { return samples; }
+
+private:
+    // Add duty x time since the last output change
+    void accumulate(unsigned long now) {
+        unsigned long elapsed = now - lastOutput;
+        drivenTotal += (uint64_t)drivenDuty * elapsed;
+        requestedTotal += (uint64_t)requestedDuty * elapsed;
+        lastOutput = now;
+    }
+
+    float toMilliamps(uint64_t dutyTime, unsigned long now) const {
+        unsigned long span = now - meterStart;
+        if (span == 0) return 0;
+        return (float)dutyTime / span / 255.0f * LED_CHANNEL_CURRENT * emitterCount;
+    }
+
+    int sensorPin = -1;
+    uint16_t emitterCount = 1;
+    uint16_t lastRaw = 0;
+    float level = 0;
+    uint8_t scale = 255;
+    unsigned long samples = 0;
+
+    uint16_t drivenDuty = 0;
+    uint16_t requestedDuty = 0;
+    uint64_t drivenTotal = 0;        // Duty sum x ms
+    uint64_t requestedTotal = 0;
+    unsigned long meterStart = 0;
+    unsigned long lastOutput = 0;
+};
+
+#endif // AMBIENT_BRIGHTNESS_H
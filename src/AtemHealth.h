@@ -0,0 +1,122 @@
+/*
+ * ATEM Session Health for the ESP32 ATEM Tally System
+ *
+ * Fast dead-switcher detection on the bridge. The tally sources only report
+ * the library's own connection state, which can stay "connected" for
+ * seconds after a switcher power cycle. The monitor watches the
+ * inter-arrival of packets from the switcher instead:
+ *
+ * - The source counts packets; the bridge samples the count every poll
+ * - Silence longer than the degraded timeout marks the session DEGRADED
+ *   (logged, state still shown); longer than the dead timeout marks it DEAD,
+ *   and the bridge reconnects
+ * - Monitoring arms once a few packets arrived, so a session still in its
+ *   handshake is not declared dead
+ * - Neither window is tighter than GAP_MARGIN mean packet gaps, so a
+ *   switcher that talks less often than the configured window does not flap
+ * - Packets resuming on a DEAD session count as a recovery, so the window
+ *   can be tuned against the switcher's real idle cadence
+ */
+
+#ifndef ATEM_HEALTH_H
+#define ATEM_HEALTH_H
+
+#include <Arduino.h>
+
+typedef enum {
+    ATEM_HEALTHY,     // Packets arriving within the degraded timeout
+    ATEM_DEGRADED,    // Silent for longer than usual - state may be stale
+    ATEM_DEAD         // Silent past the dead timeout - state is not authoritative
+} AtemHealthStatus;
+
+class AtemHealth {
+public:
+    AtemHealth(unsigned long degradedTimeout, unsigned long deadTimeout)
+        : degradedAfter(degradedTimeout), deadAfter(deadTimeout) {
+        begin(0);
+    }
+
+    // Start monitoring a new session
+    void begin(unsigned long now) {
+        lastPacket = now;
+        armPackets = 0;
+        meanGap = 0;
+        maxGap = 0;
+        status = ATEM_HEALTHY;
+    }
+
+    // Packets from the switcher arrived since the last sample
+    void onPacket(unsigned long now) {
+        unsigned long gap = now - lastPacket;
+        lastPacket = now;
+        packets++;
+
+        if (armPackets < ARM_PACKETS) {
+            armPackets++;
+        } else {
+            // Mean inter-arrival as an EWMA (1/8 weight per sample)
+            meanGap = (meanGap == 0) ? gap : meanGap + ((long)gap - (long)meanGap) / 8;
+            if (gap > maxGap) maxGap = gap;
+        }
+
+        if (status == ATEM_DEAD) {
+            recoveries++;
+        }
+        status = ATEM_HEALTHY;
+    }
+
+    // Re-evaluate the session; call every poll while the source is connected
+    AtemHealthStatus update(unsigned long now) {
+        if (!isArmed()) return status;
+
+        unsigned long silence = now - lastPacket;
+        if (status == ATEM_HEALTHY && silence > getDegradedTimeout()) {
+            status = ATEM_DEGRADED;
+            degradedEvents++;
+        }
+        if (status == ATEM_DEGRADED && silence > getDeadTimeout()) {
+            status = ATEM_DEAD;
+            deadEvents++;
+        }
+        return status;
+    }
+
+    AtemHealthStatus getStatus() const { return status; }
+    bool isDead() const { return status == ATEM_DEAD; }
+    bool isArmed() const { return armPackets >= ARM_PACKETS; }
+    const char* getStatusName() const {
+        return status == ATEM_HEALTHY ? "HEALTHY" : (status == ATEM_DEGRADED ? "DEGRADED" : "DEAD");
+    }
+
+    unsigned long getLastPacket() const { return lastPacket; }
+    unsigned long getMeanGap() const { return meanGap; }
+    unsigned long getMaxGap() const { return maxGap; }
+    unsigned long getPackets() const { return packets; }
+    unsigned long getDegradedEvents() const { return degradedEvents; }
+    unsigned long getDeadEvents() const { return deadEvents; }
+    unsigned long getRecoveries() const { return recoveries; }
+
+    // Detection windows in effect (ms)
+    unsigned long getDegradedTimeout() const { return max(degradedAfter, meanGap * GAP_MARGIN); }
+    unsigned long getDeadTimeout() const { return max(deadAfter, meanGap * GAP_MARGIN * 2); }
+
+private:
+    static const uint8_t ARM_PACKETS = 3;
+    static const uint8_t GAP_MARGIN = 3;
+
+    unsigned long degradedAfter;
+    unsigned long deadAfter;
+
+    unsigned long lastPacket;
+    uint8_t armPackets;
+    unsigned long meanGap;
+    unsigned long maxGap;
+    AtemHealthStatus status;
+
+    unsigned long packets = 0;
+    unsigned long degradedEvents = 0;
+    unsigned long deadEvents = 0;
+    unsigned long recoveries = 0;
+};
+
+#endif // ATEM_HEALTH_H
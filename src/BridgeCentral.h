@@ -0,0 +1,268 @@
+/*
+ * Central-Role Tally Links for the ESP32 ATEM Tally System
+ *
+ * Alternative bridge topology (BRIDGE_CENTRAL 1): tallies advertise as
+ * peripherals (TallyPeripheral.h) and the bridge connects to them. As the
+ * central, the bridge's controller picks every link's connection interval
+ * and places the connection events itself, instead of serving centrals that
+ * each chose their own timing and collide on its radio.
+ *
+ * - Tallies are found by scanning for TALLY_PERIPHERAL_SERVICE_UUID; with
+ *   CENTRAL_TALLY_ADDRESSES set, only the listed addresses are connected
+ * - Every link is opened with the same CENTRAL_CONN_INTERVAL, so the
+ *   controller can give each link its own slot in the interval
+ * - connect() runs from the loop and blocks for the GATT connect, MTU
+ *   exchange and discovery of one tally
+ * - write() sends a frame or container as a write without response; the
+ *   stack's write completions and congestion events feed the same per-link
+ *   flow control the bridge uses for notifications
+ *
+ * The scan callback runs on the BLE task; candidates are guarded by a
+ * spinlock.
+ */
+
+#ifndef BRIDGE_CENTRAL_H
+#define BRIDGE_CENTRAL_H
+
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <BLEClient.h>
+#include <BLEScan.h>
+#include <BLEAdvertisedDevice.h>
+#include <esp_gap_ble_api.h>
+#include <esp_gattc_api.h>
+#include "TallyProtocol.h"
+#include "TallyClock.h"
+
+#ifndef CENTRAL_TALLY_ADDRESSES
+#define CENTRAL_TALLY_ADDRESSES ""            // Comma-separated tally addresses to connect ("" = any advertising tally)
+#endif
+#ifndef CENTRAL_CONN_INTERVAL
+#define CENTRAL_CONN_INTERVAL 12              // Connection interval for every link (1.25ms units = 15ms)
+#endif
+#ifndef CENTRAL_SUPERVISION_TIMEOUT
+#define CENTRAL_SUPERVISION_TIMEOUT 500       // BLE supervision timeout - dead radio link detection (ms)
+#endif
+#ifndef CENTRAL_SCAN_TIME
+#define CENTRAL_SCAN_TIME 2                   // Scan window while tallies are missing (s)
+#endif
+
+template <uint8_t MaxLinks>
+class BridgeCentral {
+public:
+    BridgeCentral() : scanCallbacks(this) {
+        for (int i = 0; i < MaxLinks; i++) {
+            peers[i].client = nullptr;
+            peers[i].connected = false;
+        }
+    }
+
+    // Configure scanning (call after BLEDevice::init)
+    void begin() {
+        BLEScan* scan = BLEDevice::getScan();
+        scan->setAdvertisedDeviceCallbacks(&scanCallbacks);
+        scan->setInterval(100);
+        scan->setWindow(99);
+        scan->setActiveScan(false);
+    }
+
+    // Scan for advertising tallies in the background (no-op while scanning)
+    void startScan() {
+        if (isScanning()) return;
+        BLEScan* scan = BLEDevice::getScan();
+        scan->clearResults();
+        scanning = true;
+        scanStartedAt = clockMillis();
+        scan->start(CENTRAL_SCAN_TIME, nullptr, false);
+        scans++;
+    }
+
+    // The scan ends on its own after CENTRAL_SCAN_TIME
+    bool isScanning() const {
+        return scanning && clockMillis() - scanStartedAt < CENTRAL_SCAN_TIME * 1000UL + 500;
+    }
+
+    bool hasCandidate() const { return candidateCount > 0; }
+
+    // Connect to the next tally found by the scan. Returns the client with
+    // the tally's registration string, nullptr on failure.
+    BLEClient* connectNext(BLEClientCallbacks* callbacks, String& registration) {
+        Candidate next;
+        portENTER_CRITICAL(&lock);
+        bool found = candidateCount > 0;
+        if (found) {
+            next = candidates[--candidateCount];
+        }
+        portEXIT_CRITICAL(&lock);
+        if (!found) return nullptr;
+
+        int slot = freeSlot();
+        if (slot < 0) return nullptr;
+        if (isScanning()) {
+            BLEDevice::getScan()->stop();
+            scanning = false;
+        }
+
+        // Every link at the same interval so the controller can interleave them
+        esp_ble_gap_set_prefer_conn_params(next.address,
+                                           CENTRAL_CONN_INTERVAL, CENTRAL_CONN_INTERVAL,
+                                           0, CENTRAL_SUPERVISION_TIMEOUT / 10);
+
+        BLEClient* client = BLEDevice::createClient();
+        client->setClientCallbacks(callbacks);
+        BLERemoteService* service = nullptr;
+        BLERemoteCharacteristic* frames = nullptr;
+        BLERemoteCharacteristic* reg = nullptr;
+        bool ok = client->connect(BLEAddress(next.address), next.type) &&
+                  (service = client->getService(TALLY_PERIPHERAL_SERVICE_UUID)) != nullptr &&
+                  (frames = service->getCharacteristic(TALLY_FRAME_UUID)) != nullptr &&
+                  (reg = service->getCharacteristic(TALLY_REGISTRATION_UUID)) != nullptr;
+        if (ok) {
+            registration = String(reg->readValue().c_str());
+            ok = registration.startsWith("TALLY_REG:");
+        }
+        if (!ok) {
+            connectFailures++;
+            if (client->isConnected()) {
+                client->disconnect();
+            }
+            peers[slot].client = client; // Deleted when the slot is reused
+            peers[slot].connected = false;
+            return nullptr;
+        }
+
+        peers[slot].client = client;
+        memcpy(peers[slot].address, next.address, sizeof(esp_bd_addr_t));
+        peers[slot].gattcIf = client->getGattcIf();
+        peers[slot].connId = client->getConnId();
+        peers[slot].frameHandle = frames->getHandle();
+        peers[slot].connected = true;
+        connects++;
+        return client;
+    }
+
+    // Link dropped (BLE task) - the client is deleted when the slot is reused
+    void onDisconnect(uint16_t connId) {
+        int slot = findPeer(connId);
+        if (slot >= 0) {
+            peers[slot].connected = false;
+        }
+    }
+
+    // Send a frame or container to a tally as a write without response
+    esp_err_t write(uint16_t connId, const uint8_t* data, size_t length) {
+        int slot = findPeer(connId);
+        if (slot < 0) return ESP_FAIL;
+        return esp_ble_gattc_write_char(peers[slot].gattcIf, connId, peers[slot].frameHandle,
+                                        length, (uint8_t*)data,
+                                        ESP_GATT_WRITE_TYPE_NO_RSP, ESP_GATT_AUTH_REQ_NONE);
+    }
+
+    void disconnect(uint16_t connId) {
+        int slot = findPeer(connId);
+        if (slot >= 0) {
+            peers[slot].client->disconnect();
+        }
+    }
+
+    // Address string of a connected tally ("" if unknown)
+    String getAddress(uint16_t connId) {
+        int slot = findPeer(connId);
+        return (slot >= 0) ? String(BLEAddress(peers[slot].address).toString().c_str()) : String();
+    }
+
+    unsigned long getScans() const { return scans; }
+    unsigned long getConnects() const { return connects; }
+    unsigned long getConnectFailures() const { return connectFailures; }
+
+private:
+    struct Candidate {
+        esp_bd_addr_t address;
+        esp_ble_addr_type_t type;
+    };
+
+    struct Peer {
+        BLEClient* client;
+        esp_bd_addr_t address;
+        esp_gatt_if_t gattcIf;
+        uint16_t connId;
+        uint16_t frameHandle;      // Tally's frame characteristic
+        bool connected;
+    };
+
+    class ScanCallbacks : public BLEAdvertisedDeviceCallbacks {
+    public:
+        explicit ScanCallbacks(BridgeCentral* owner) : owner(owner) {}
+        void onResult(BLEAdvertisedDevice advertisedDevice) {
+            owner->onScanResult(advertisedDevice);
+        }
+    private:
+        BridgeCentral* owner;
+    };
+
+    // Keep advertising tallies we are allowed to and not yet connected to (BLE task)
+    void onScanResult(BLEAdvertisedDevice& device) {
+        if (!device.haveServiceUUID() ||
+            !device.isAdvertisingService(BLEUUID(TALLY_PERIPHERAL_SERVICE_UUID))) {
+            return;
+        }
+
+        BLEAddress address = device.getAddress();
+        const uint8_t* native = *address.getNative();
+        String allowed = CENTRAL_TALLY_ADDRESSES;
+        if (allowed.length() > 0) {
+            String text = String(address.toString().c_str());
+            allowed.toLowerCase();
+            text.toLowerCase();
+            if (allowed.indexOf(text) < 0) return;
+        }
+        for (int i = 0; i < MaxLinks; i++) {
+            if (peers[i].connected && memcmp(peers[i].address, native, sizeof(esp_bd_addr_t)) == 0) return;
+        }
+
+        portENTER_CRITICAL(&lock);
+        bool known = false;
+        for (int i = 0; i < candidateCount; i++) {
+            known = known || memcmp(candidates[i].address, native, sizeof(esp_bd_addr_t)) == 0;
+        }
+        if (!known && candidateCount < MaxLinks) {
+            memcpy(candidates[candidateCount].address, native, sizeof(esp_bd_addr_t));
+            candidates[candidateCount].type = device.getAddressType();
+            candidateCount++;
+        }
+        portEXIT_CRITICAL(&lock);
+    }
+
+    int findPeer(uint16_t connId) {
+        for (int i = 0; i < MaxLinks; i++) {
+            if (peers[i].connected && peers[i].connId == connId) return i;
+        }
+        return -1;
+    }
+
+    // Free peer slot, deleting the client of a dropped link
+    int freeSlot() {
+        for (int i = 0; i < MaxLinks; i++) {
+            if (!peers[i].connected) {
+                delete peers[i].client;
+                peers[i].client = nullptr;
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    Peer peers[MaxLinks];
+    Candidate candidates[MaxLinks];
+    volatile uint8_t candidateCount = 0;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    ScanCallbacks scanCallbacks;
+
+    bool scanning = false;
+    unsigned long scanStartedAt = 0;
+    unsigned long scans = 0;
+    unsigned long connects = 0;
+    unsigned long connectFailures = 0;
+};
+
+#endif // BRIDGE_CENTRAL_H
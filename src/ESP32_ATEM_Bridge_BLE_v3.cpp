@@ -18,8 +18,10 @@
  * - Individual device registration and management
  * - Supports up to 20 camera inputs with full state tracking
  * - Auto-reconnection for network and ATEM connections
+ * - Event-driven main loop: sleeps until a BLE event, serial input or timer
  * - Comprehensive status monitoring and debugging
  * - Manual testing commands via Serial Monitor
+ * - Built from the shared ATEMBridgeCore - this sketch is configuration only
  * 
  * Improvements in v3.0:
  * - Uses proven ATEMmin library instead of manual TCP parsing
@@ -53,14 +55,7 @@
  * Date: July 2025
  */
 
-#include <BLEDevice.h>
-#include <BLEServer.h>
-#include <BLEUtils.h>
-#include <BLE2902.h>
-#include <WiFi.h>
 #include <USB.h>
-#include <ATEMbase.h>
-#include <ATEMmin.h>
 
 // ===============================================
 // CONFIGURATION - UPDATE THESE VALUES
@@ -74,721 +69,33 @@
 #define MAX_TALLY_DEVICES 4                 // Maximum simultaneous BLE connections
 #define BLE_SERVICE_UUID "12345678-1234-5678-9abc-123456789abc"
 #define BLE_CHARACTERISTIC_UUID "87654321-4321-8765-cba9-987654321cba"
+#define BRIDGE_CENTRAL 0                    // 1 = connect to advertising tallies (TALLY_PERIPHERAL), no tally OTA
 
 // USB Tethering Configuration
-#define USB_TETHER_TIMEOUT 30000            // USB tethering connection timeout (ms)
 #define NETWORK_CHECK_INTERVAL 30000        // Network connectivity check interval (ms)
 
 // System Configuration
 #define MAX_CAMERAS 20                      // Maximum cameras supported
-#define ATEM_RECONNECT_INTERVAL 10000       // ATEM reconnection attempt interval (ms)
-#define TALLY_CHECK_INTERVAL 100            // Tally state check interval (ms) - fast for responsiveness
-#define TALLY_BROADCAST_INTERVAL 500        // Tally broadcast interval (ms) - faster for BLE
-#define HEARTBEAT_INTERVAL 5000             // Heartbeat signal broadcast interval (ms)
+#define ATEM_RECONNECT_INTERVAL 10000       // Longest wait between ATEM reconnection attempts (ms)
+#define TALLY_CHECK_INTERVAL 25             // ATEM poll + tally diff interval (ms) - bounds cut latency
+#define HEARTBEAT_INTERVAL 5000             // Default heartbeat interval if tally requests none (ms)
+#define HEARTBEAT_MIN_INTERVAL 100          // Fastest heartbeat period a tally may negotiate (ms)
+#define LOOP_IDLE_TIMEOUT 1000              // Longest main loop sleep with no events or timers (ms)
+#define BENCH_ITERATIONS 10000              // Iterations per BENCH microbenchmark
+#define BRIDGE_LOG_LEVEL BRIDGE_LOG_DEBUG   // BRIDGE_LOG_ERROR, BRIDGE_LOG_INFO or BRIDGE_LOG_DEBUG
 
 // Standby Preview Configuration
 #define STANDBY_AS_PREVIEW true             // Show non-active cameras as PREVIEW (ready/standby)
 
-// ===============================================
-// DATA STRUCTURES
-// ===============================================
-
-// BLE tally message structure
-typedef struct {
-    uint8_t cameraId;        // Camera number (1-20)
-    char state[12];          // "PREVIEW", "PROGRAM", "OFF", "STANDBY", "HEARTBEAT", "NO_ATEM"
-    uint32_t timestamp;      // Message timestamp for debugging
-    uint8_t bridgeId;        // Bridge identifier (for multiple bridges)
-    uint8_t bridgeStatus;    // Bridge status: 0=No ATEM, 1=ATEM Connected, 2=Heartbeat
-    uint8_t checksum;        // Simple checksum for data integrity
-} __attribute__((packed)) TallyMessage;
-
-// BLE tally device information
-typedef struct {
-    String deviceName;
-    uint8_t cameraId;
-    unsigned long lastSeen;
-    bool connected;
-    bool registered;
-    BLECharacteristic* characteristic;
-} TallyDevice;
-
-// ===============================================
-// GLOBAL VARIABLES
-// ===============================================
-
-// BLE Server
-BLEServer* pServer = nullptr;
-BLEService* pService = nullptr;
-BLECharacteristic* pCharacteristic = nullptr;
-bool deviceConnected = false;
-TallyDevice tallyDevices[MAX_TALLY_DEVICES];
-int numConnectedDevices = 0;
-
-// ATEM Library Instance
-ATEMmin AtemSwitcher;
-bool networkConnected = false;
-unsigned long lastNetworkCheck = 0;
-unsigned long lastATEMReconnectAttempt = 0;
-unsigned long lastTallyCheck = 0;
-
-// Tally state tracking
-uint8_t currentTallyStates[MAX_CAMERAS + 1] = {0}; // Index 1-20, 0 unused
-unsigned long lastStateChange = 0;
-unsigned long lastTallyBroadcast = 0;
-unsigned long lastHeartbeat = 0;
-
-// Statistics
-unsigned long totalMessagesReceived = 0;
-unsigned long totalMessagesSent = 0;
-unsigned long systemStartTime = 0;
-
-// ===============================================
-// BLE FUNCTIONS
-// ===============================================
-
-// Calculate simple checksum for message integrity
-uint8_t calculateChecksum(TallyMessage* msg) {
-    uint8_t checksum = 0;
-    checksum ^= msg->cameraId;
-    checksum ^= msg->bridgeId;
-    checksum ^= msg->bridgeStatus;
-    for (int i = 0; i < strlen(msg->state); i++) {
-        checksum ^= msg->state[i];
-    }
-    return checksum;
-}
-
-// BLE Server Callbacks
-class MyServerCallbacks: public BLEServerCallbacks {
-    void onConnect(BLEServer* pServer) {
-        deviceConnected = true;
-        numConnectedDevices++;
-        Serial.printf("BLE client connected (total: %d/%d)\n", 
-                     numConnectedDevices, MAX_TALLY_DEVICES);
-        
-        // Don't restart advertising if we haven't reached max connections
-        if (numConnectedDevices < MAX_TALLY_DEVICES) {
-            BLEDevice::startAdvertising();
-        }
-    }
-
-    void onDisconnect(BLEServer* pServer) {
-        if (numConnectedDevices > 0) {
-            numConnectedDevices--;
-        }
-        Serial.printf("BLE client disconnected (total: %d/%d)\n", 
-                     numConnectedDevices, MAX_TALLY_DEVICES);
-        
-        // Find and mark device as disconnected
-        for (int i = 0; i < MAX_TALLY_DEVICES; i++) {
-            if (tallyDevices[i].connected) {
-                // This is simplified - in practice, you'd match by connection ID
-                tallyDevices[i].connected = false;
-                Serial.printf("Device %s marked as disconnected\n", 
-                             tallyDevices[i].deviceName.c_str());
-                break;
-            }
-        }
-        
-        // Restart advertising to allow new connections
-        BLEDevice::startAdvertising();
-    }
-};
-
-// BLE Characteristic Callbacks for receiving data
-class MyCharacteristicCallbacks: public BLECharacteristicCallbacks {
-    void onWrite(BLECharacteristic* pCharacteristic) {
-        std::string rxValue = pCharacteristic->getValue();
-        
-        if (rxValue.length() > 0) {
-            // Handle device registration
-            String message = String(rxValue.c_str());
-            message.trim();
-            
-            if (message.startsWith("TALLY_REG:")) {
-                // Parse: "TALLY_REG:1:Tally_CAM_1"
-                int firstColon = message.indexOf(':', 10);
-                int secondColon = message.indexOf(':', firstColon + 1);
-                
-                if (firstColon > 0 && secondColon > 0) {
-                    uint8_t cameraId = message.substring(10, firstColon).toInt();
-                    String deviceName = message.substring(secondColon + 1);
-                    
-                    // Find available slot for registration
-                    for (int i = 0; i < MAX_TALLY_DEVICES; i++) {
-                        if (!tallyDevices[i].registered || 
-                            tallyDevices[i].deviceName == deviceName) {
-                            
-                            tallyDevices[i].deviceName = deviceName;
-                            tallyDevices[i].cameraId = cameraId;
-                            tallyDevices[i].lastSeen = millis();
-                            tallyDevices[i].connected = true;
-                            tallyDevices[i].characteristic = pCharacteristic;
-                            
-                            if (!tallyDevices[i].registered) {
-                                tallyDevices[i].registered = true;
-                                Serial.printf("✓ Registered BLE tally: %s (CAM%d) [slot %d]\n", 
-                                             deviceName.c_str(), cameraId, i);
-                            } else {
-                                Serial.printf("✓ Reconnected BLE tally: %s (CAM%d)\n", 
-                                             deviceName.c_str(), cameraId);
-                            }
-                            
-                            // Send current state for this camera immediately
-                            sendTallyToDevice(i, cameraId, getCurrentTallyState(cameraId));
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-    }
-};
-
-// Initialize BLE server
-bool initializeBLE() {
-    Serial.printf("Initializing BLE server: %s\n", BLE_DEVICE_NAME);
-    
-    // Initialize BLE device
-    BLEDevice::init(BLE_DEVICE_NAME);
-    
-    // Create BLE server
-    pServer = BLEDevice::createServer();
-    pServer->setCallbacks(new MyServerCallbacks());
-    
-    // Create BLE service
-    pService = pServer->createService(BLE_SERVICE_UUID);
-    
-    // Create BLE characteristic for tally data
-    pCharacteristic = pService->createCharacteristic(
-                      BLE_CHARACTERISTIC_UUID,
-                      BLECharacteristic::PROPERTY_READ |
-                      BLECharacteristic::PROPERTY_WRITE |
-                      BLECharacteristic::PROPERTY_NOTIFY
-                    );
-    
-    pCharacteristic->setCallbacks(new MyCharacteristicCallbacks());
-    pCharacteristic->addDescriptor(new BLE2902());
-    
-    // Start the service
-    pService->start();
-    
-    // Start advertising
-    BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
-    pAdvertising->addServiceUUID(BLE_SERVICE_UUID);
-    pAdvertising->setScanResponse(false);
-    pAdvertising->setMinPreferred(0x0);
-    BLEDevice::startAdvertising();
-    
-    Serial.println("✓ BLE server initialized and advertising");
-    Serial.printf("Service UUID: %s\n", BLE_SERVICE_UUID);
-    Serial.printf("Characteristic UUID: %s\n", BLE_CHARACTERISTIC_UUID);
-    
-    // Initialize tally device array
-    for (int i = 0; i < MAX_TALLY_DEVICES; i++) {
-        tallyDevices[i].deviceName = "";
-        tallyDevices[i].cameraId = 0;
-        tallyDevices[i].lastSeen = 0;
-        tallyDevices[i].connected = false;
-        tallyDevices[i].registered = false;
-        tallyDevices[i].characteristic = nullptr;
-    }
-    
-    return true;
-}
-
-// Send tally data to a specific device
-void sendTallyToDevice(int deviceIndex, uint8_t cameraId, const char* state) {
-    if (deviceIndex < 0 || deviceIndex >= MAX_TALLY_DEVICES) return;
-    if (!tallyDevices[deviceIndex].connected || 
-        tallyDevices[deviceIndex].characteristic == nullptr) return;
-    
-    TallyMessage msg;
-    msg.cameraId = cameraId;
-    msg.timestamp = millis();
-    msg.bridgeId = 1;
-    
-    // Set bridge status based on ATEM connection
-    if (AtemSwitcher.isConnected()) {
-        msg.bridgeStatus = 1; // ATEM Connected
-    } else {
-        msg.bridgeStatus = 0; // No ATEM
-    }
-    
-    strncpy(msg.state, state, sizeof(msg.state) - 1);
-    msg.state[sizeof(msg.state) - 1] = '\0';
-    msg.checksum = calculateChecksum(&msg);
-    
-    // Send via BLE characteristic
-    tallyDevices[deviceIndex].characteristic->setValue((uint8_t*)&msg, sizeof(msg));
-    tallyDevices[deviceIndex].characteristic->notify();
-    
-    Serial.printf("Sent to %s: CAM%d -> %s (ATEM:%s)\n", 
-                 tallyDevices[deviceIndex].deviceName.c_str(), cameraId, state,
-                 msg.bridgeStatus ? "OK" : "DISCONNECTED");
-}
-
-// Get current tally state for a camera with standby preview logic
-const char* getCurrentTallyState(uint8_t cameraId) {
-    if (cameraId < 1 || cameraId > MAX_CAMERAS) return "OFF";
-    
-    // If ATEM is not connected, return "NO_ATEM" to indicate bridge status
-    if (!AtemSwitcher.isConnected()) {
-        return "NO_ATEM";
-    }
-    
-    uint8_t state = currentTallyStates[cameraId];
-    if (state & 0x01) {
-        return "PROGRAM";  // Bit 0 = On Program/Live
-    } else if (state & 0x02) {
-        return "PREVIEW";  // Bit 1 = On Preview
-    } else {
-        // Camera is OFF - check if we should show as standby preview
-        if (STANDBY_AS_PREVIEW) {
-            // Check if any camera is currently in PROGRAM
-            bool anyProgramActive = false;
-            for (int cam = 1; cam <= MAX_CAMERAS; cam++) {
-                if (currentTallyStates[cam] & 0x01) {
-                    anyProgramActive = true;
-                    break;
-                }
-            }
-            
-            // If production is active (any camera in PROGRAM), show non-active cameras as PREVIEW (standby)
-            if (anyProgramActive) {
-                return "PREVIEW";  // Show as ready/standby
-            }
-        }
-        return "OFF";
-    }
-}
-
-// Broadcast tally data to all connected BLE devices
-void broadcastTallyData(uint8_t cameraId, const char* state) {
-    Serial.printf("Broadcasting: CAM%d -> %s (to %d devices)\n", 
-                 cameraId, state, numConnectedDevices);
-    
-    int sentCount = 0;
-    for (int i = 0; i < MAX_TALLY_DEVICES; i++) {
-        if (tallyDevices[i].connected && tallyDevices[i].registered) {
-            sendTallyToDevice(i, cameraId, state);
-            sentCount++;
-        }
-    }
-    
-    if (sentCount > 0) {
-        totalMessagesSent += sentCount;
-    } else {
-        Serial.println("Warning: No BLE devices connected");
-    }
-    
-    lastStateChange = millis();
-    lastTallyBroadcast = millis();
-}
-
-// Check for disconnected tally devices
-void checkTallyDeviceConnections() {
-    unsigned long currentTime = millis();
-    
-    for (int i = 0; i < MAX_TALLY_DEVICES; i++) {
-        if (tallyDevices[i].registered && tallyDevices[i].connected) {
-            // BLE connection status is managed by callbacks
-            // This could be used for additional health checks
-        }
-    }
-}
-
-// Send heartbeat signal to all connected tally devices
-void sendHeartbeatSignal() {
-    if (numConnectedDevices == 0) return;
-    
-    Serial.printf("Sending heartbeat signal to %d devices (ATEM:%s)\n", 
-                 numConnectedDevices, AtemSwitcher.isConnected() ? "OK" : "DISCONNECTED");
-    
-    for (int i = 0; i < MAX_TALLY_DEVICES; i++) {
-        if (tallyDevices[i].connected && tallyDevices[i].registered) {
-            TallyMessage msg;
-            msg.cameraId = 0; // 0 = heartbeat/status message
-            msg.timestamp = millis();
-            msg.bridgeId = 1;
-            
-            // Set bridge status and state
-            if (AtemSwitcher.isConnected()) {
-                msg.bridgeStatus = 1; // ATEM Connected
-                strncpy(msg.state, "HEARTBEAT", sizeof(msg.state) - 1);
-            } else {
-                msg.bridgeStatus = 0; // No ATEM
-                strncpy(msg.state, "NO_ATEM", sizeof(msg.state) - 1);
-            }
-            
-            msg.state[sizeof(msg.state) - 1] = '\0';
-            msg.checksum = calculateChecksum(&msg);
-            
-            // Send heartbeat via BLE
-            tallyDevices[i].characteristic->setValue((uint8_t*)&msg, sizeof(msg));
-            tallyDevices[i].characteristic->notify();
-        }
-    }
-    
-    lastHeartbeat = millis();
-}
-
-// ===============================================
-// NETWORK FUNCTIONS (USB Tethering)
-// ===============================================
-
-// Initialize USB tethering network connection
-bool initializeNetwork() {
-    Serial.println("Initializing USB tethering network...");
-    
-    // Initialize WiFi in station mode for network stack (but no WiFi used)
-    WiFi.mode(WIFI_STA);
-    WiFi.disconnect();
-    delay(100);
-    
-    // Wait for USB tethering to provide network interface
-    Serial.println("Waiting for USB tethering network interface...");
-    
-    int attempts = 0;
-    while (attempts < 60) { // Wait up to 30 seconds
-        // Check if we have a valid IP address from USB tethering
-        if (WiFi.localIP().toString() != "0.0.0.0") {
-            networkConnected = true;
-            Serial.println();
-            Serial.printf("✓ USB Tethering Network Connected!\n");
-            Serial.printf("  IP Address: %s\n", WiFi.localIP().toString().c_str());
-            Serial.printf("  Gateway: %s\n", WiFi.gatewayIP().toString().c_str());
-            Serial.printf("  DNS: %s\n", WiFi.dnsIP().toString().c_str());
-            return true;
-        }
-        
-        delay(500);
-        Serial.print(".");
-        attempts++;
-        
-        if (attempts % 20 == 0) {
-            Serial.printf(" [%d/60]\n", attempts);
-        }
-    }
-    
-    networkConnected = false;
-    Serial.println("\n✗ USB tethering network not available!");
-    Serial.println("  Ensure USB tethering is enabled on PC");
-    Serial.println("  Check USB cable connection");
-    return false;
-}
-
-// Check network connectivity status
-bool checkNetworkConnectivity() {
-    // Check if we still have a valid IP address
-    if (WiFi.localIP().toString() == "0.0.0.0") {
-        networkConnected = false;
-        return false;
-    }
-    
-    networkConnected = true;
-    return true;
-}
-
-// ===============================================
-// ATEM FUNCTIONS (Using ATEMmin Library)
-// ===============================================
-
-// Connect to ATEM switcher using ATEMmin library
-bool connectToATEM() {
-    if (!networkConnected) {
-        Serial.println("Cannot connect to ATEM: No network connection");
-        return false;
-    }
-    
-    Serial.printf("Connecting to ATEM switcher at %s using ATEMmin library\n", ATEM_IP);
-    
-    // Parse IP address string to IPAddress object
-    IPAddress atemIP;
-    if (!atemIP.fromString(ATEM_IP)) {
-        Serial.println("✗ Invalid ATEM IP address format");
-        return false;
-    }
-    
-    // Initialize ATEM library with IP
-    AtemSwitcher.begin(atemIP);
-    AtemSwitcher.serialOutput(1); // Enable moderate debug output
-    AtemSwitcher.connect();
-    
-    Serial.println("✓ ATEM library initialized and connecting...");
-    Serial.println("Waiting for ATEM connection establishment...");
-    
-    // Give some time for initial connection
-    unsigned long startTime = millis();
-    while (!AtemSwitcher.isConnected() && (millis() - startTime) < 10000) {
-        AtemSwitcher.runLoop();
-        delay(10);
-    }
-    
-    if (AtemSwitcher.isConnected()) {
-        Serial.println("✓ Connected to ATEM switcher via ATEMmin library");
-        return true;
-    } else {
-        Serial.println("✗ Failed to connect to ATEM switcher");
-        Serial.println("  Check ATEM IP address and network connectivity");
-        Serial.println("  Ensure ATEM is powered on and connected to network");
-        return false;
-    }
-}
-
-// Check for ATEM tally state changes using ATEMmin library
-void checkATEMTallyStates() {
-    if (!AtemSwitcher.isConnected()) {
-        return;
-    }
-    
-    bool anyChanges = false;
-    bool productionActiveNow = false;
-    
-    // First pass: Check for direct tally state changes and detect if production is active
-    for (int cam = 1; cam <= MAX_CAMERAS; cam++) {
-        uint8_t newTallyState = 0;
-        
-        // Get tally state from ATEM library (check if camera index is valid)
-        // Note: ATEMmin uses 0-based indexing, so Camera 1 = index 0, Camera 2 = index 1, etc.
-        int atemIndex = cam - 1; // Convert 1-based camera number to 0-based ATEM index
-        if (atemIndex < AtemSwitcher.getTallyByIndexSources()) {
-            uint8_t tallyFlags = AtemSwitcher.getTallyByIndexTallyFlags(atemIndex);
-            
-            // ATEM tally flags: bit 0 = Program/Live, bit 1 = Preview
-            if (tallyFlags & 0x01) {
-                newTallyState |= 0x01; // Program/Live
-                productionActiveNow = true;
-            }
-            if (tallyFlags & 0x02) {
-                newTallyState |= 0x02; // Preview
-            }
-        }
-        
-        // Check if state changed for this camera
-        if (newTallyState != currentTallyStates[cam]) {
-            currentTallyStates[cam] = newTallyState;
-            anyChanges = true;
-            
-            // Determine tally state string
-            const char* state = getCurrentTallyState(cam);
-            
-            Serial.printf("Camera %d: %s (0x%02X)\n", cam, state, newTallyState);
-        }
-    }
-    
-    // Second pass: If standby preview is enabled and production status might have changed,
-    // check all cameras to see if their display state needs updating
-    if (STANDBY_AS_PREVIEW && anyChanges) {
-        for (int cam = 1; cam <= MAX_CAMERAS; cam++) {
-            const char* currentDisplayState = getCurrentTallyState(cam);
-            
-            // Send updated state to all cameras (they'll filter by their camera ID)
-            broadcastTallyData(cam, currentDisplayState);
-        }
-    } else if (anyChanges) {
-        // Normal mode: only broadcast cameras that actually changed
-        for (int cam = 1; cam <= MAX_CAMERAS; cam++) {
-            if (currentTallyStates[cam] != 0 || anyChanges) { // Send if state is not OFF or if any changes occurred
-                const char* state = getCurrentTallyState(cam);
-                broadcastTallyData(cam, state);
-            }
-        }
-    }
-    
-    if (anyChanges) {
-        totalMessagesReceived++;
-    }
-}
-
-// Main ATEM communication handler using ATEMmin library
-void handleATEM() {
-    if (!networkConnected) return;
-    
-    // Run ATEM library loop - this handles all communication
-    AtemSwitcher.runLoop();
-    
-    // Check connection status
-    if (!AtemSwitcher.isConnected()) {
-        // Connection lost, attempt reconnection
-        if (millis() - lastATEMReconnectAttempt > ATEM_RECONNECT_INTERVAL) {
-            Serial.println("ATEM connection lost - attempting reconnection...");
-            lastATEMReconnectAttempt = millis();
-            connectToATEM();
-        }
-        return;
-    }
-    
-    // Check for tally state changes periodically
-    if (millis() - lastTallyCheck > TALLY_CHECK_INTERVAL) {
-        lastTallyCheck = millis();
-        checkATEMTallyStates();
-    }
-}
+#include "ATEMminSource.h"
+#include "ATEMBridgeCore.h"
 
 // ===============================================
-// SYSTEM FUNCTIONS
+// BRIDGE
 // ===============================================
 
-// Print system status
-void printSystemStatus() {
-    Serial.println("\n==== ESP32 ATEM Bridge v3.0 Status ====");
-    Serial.printf("Uptime: %lu seconds\n", (millis() - systemStartTime) / 1000);
-    Serial.printf("Network: %s", networkConnected ? "Connected" : "Disconnected");
-    if (networkConnected) {
-        Serial.printf(" (%s)", WiFi.localIP().toString().c_str());
-    }
-    Serial.println();
-    
-    Serial.printf("ATEM: %s", AtemSwitcher.isConnected() ? "Connected" : "Disconnected");
-    if (AtemSwitcher.isConnected()) {
-        Serial.printf(" (Library: ATEMmin v2.0)");
-    }
-    Serial.println();
-    
-    Serial.printf("BLE: %d/%d devices connected\n", numConnectedDevices, MAX_TALLY_DEVICES);
-    
-    // List registered devices
-    int registeredCount = 0;
-    for (int i = 0; i < MAX_TALLY_DEVICES; i++) {
-        if (tallyDevices[i].registered) {
-            registeredCount++;
-            Serial.printf("  %s (CAM%d) - %s\n", 
-                         tallyDevices[i].deviceName.c_str(),
-                         tallyDevices[i].cameraId,
-                         tallyDevices[i].connected ? "Connected" : "Disconnected");
-        }
-    }
-    Serial.printf("Registered Devices: %d\n", registeredCount);
-    
-    Serial.printf("Messages: %lu received, %lu sent\n", totalMessagesReceived, totalMessagesSent);
-    
-    if (lastStateChange > 0) {
-        Serial.printf("Last tally change: %lu seconds ago\n", 
-                     (millis() - lastStateChange) / 1000);
-    }
-    
-    Serial.println("=======================================\n");
-}
-
-// Handle serial commands for testing and debugging
-void handleSerialCommands() {
-    if (!Serial.available()) return;
-    
-    String command = Serial.readStringUntil('\n');
-    command.trim();
-    command.toUpperCase();
-    
-    // Manual tally commands: "CAM1:PREVIEW", "CAM2:PROGRAM", etc.
-    int colonIndex = command.indexOf(':');
-    if (colonIndex > 0) {
-        String camStr = command.substring(0, colonIndex);
-        String stateStr = command.substring(colonIndex + 1);
-        
-        if (camStr.startsWith("CAM") && camStr.length() > 3) {
-            uint8_t cameraId = camStr.substring(3).toInt();
-            if (cameraId >= 1 && cameraId <= MAX_CAMERAS) {
-                Serial.printf("Manual test: CAM%d -> %s\n", cameraId, stateStr.c_str());
-                broadcastTallyData(cameraId, stateStr.c_str());
-            } else {
-                Serial.printf("Error: Camera ID must be 1-%d\n", MAX_CAMERAS);
-            }
-        }
-    } 
-    // System commands
-    else if (command == "STATUS") {
-        printSystemStatus();
-    }
-    else if (command == "NETWORK") {
-        Serial.printf("Network Status: %s\n", networkConnected ? "Connected" : "Disconnected");
-        if (networkConnected) {
-            Serial.printf("IP: %s, Gateway: %s, DNS: %s\n", 
-                         WiFi.localIP().toString().c_str(),
-                         WiFi.gatewayIP().toString().c_str(),
-                         WiFi.dnsIP().toString().c_str());
-        }
-    }
-    else if (command == "ATEM") {
-        Serial.printf("ATEM Status: %s\n", AtemSwitcher.isConnected() ? "Connected" : "Disconnected");
-        if (AtemSwitcher.isConnected()) {
-            Serial.printf("Library: ATEMmin (SKAARHOJ)\n");
-            Serial.printf("Tally Sources: %d\n", AtemSwitcher.getTallyByIndexSources());
-        }
-    }
-    else if (command == "BLE") {
-        Serial.printf("BLE Status: %d/%d devices connected\n", numConnectedDevices, MAX_TALLY_DEVICES);
-        Serial.printf("Device Name: %s\n", BLE_DEVICE_NAME);
-        Serial.printf("Service UUID: %s\n", BLE_SERVICE_UUID);
-        Serial.printf("Advertising: %s\n", (numConnectedDevices < MAX_TALLY_DEVICES) ? "Active" : "Stopped");
-    }
-    else if (command == "DEVICES") {
-        Serial.println("Registered BLE Tally Devices:");
-        for (int i = 0; i < MAX_TALLY_DEVICES; i++) {
-            if (tallyDevices[i].registered) {
-                unsigned long lastSeenAge = (millis() - tallyDevices[i].lastSeen) / 1000;
-                Serial.printf("%d. %s (CAM%d) - %s (last seen %lu sec ago)\n", 
-                             i + 1,
-                             tallyDevices[i].deviceName.c_str(),
-                             tallyDevices[i].cameraId,
-                             tallyDevices[i].connected ? "Connected" : "Disconnected",
-                             lastSeenAge);
-            }
-        }
-    }
-    else if (command == "RESET") {
-        Serial.println("Restarting ESP32...");
-        delay(1000);
-        ESP.restart();
-    }
-    else if (command == "STANDBY") {
-        Serial.printf("Standby Preview Mode: %s\n", STANDBY_AS_PREVIEW ? "ENABLED" : "DISABLED");
-        
-        // Show current production status
-        bool anyProgramActive = false;
-        int programCamera = 0;
-        int previewCamera = 0;
-        
-        for (int cam = 1; cam <= MAX_CAMERAS; cam++) {
-            if (currentTallyStates[cam] & 0x01) {
-                anyProgramActive = true;
-                programCamera = cam;
-            }
-            if (currentTallyStates[cam] & 0x02) {
-                previewCamera = cam;
-            }
-        }
-        
-        Serial.printf("Production Status: %s\n", anyProgramActive ? "ACTIVE" : "STANDBY");
-        if (programCamera > 0) {
-            Serial.printf("PROGRAM Camera: %d\n", programCamera);
-        }
-        if (previewCamera > 0) {
-            Serial.printf("PREVIEW Camera: %d\n", previewCamera);
-        }
-        
-        if (STANDBY_AS_PREVIEW && anyProgramActive) {
-            Serial.println("Non-active cameras showing as PREVIEW (ready/standby)");
-        }
-    }
-    else if (command == "HELP") {
-        Serial.println("\nAvailable Commands:");
-        Serial.println("CAMx:STATE  - Send test tally (e.g., CAM1:PREVIEW, CAM1:PROGRAM)");
-        Serial.println("STATUS      - Show system status");
-        Serial.println("NETWORK     - Show network status");
-        Serial.println("ATEM        - Show ATEM status");
-        Serial.println("BLE         - Show BLE status");
-        Serial.println("DEVICES     - List registered tally devices");
-        Serial.println("STANDBY     - Toggle standby preview mode");
-        Serial.println("RESET       - Restart ESP32");
-        Serial.println("HELP        - Show this help\n");
-        Serial.printf("Standby Preview Mode: %s\n", STANDBY_AS_PREVIEW ? "ENABLED" : "DISABLED");
-        Serial.println("(Non-active cameras show as PREVIEW when production is active)");
-    }
-    else {
-        Serial.println("Unknown command. Type HELP for available commands.");
-    }
-}
+ATEMminSource atemSource;
+ATEMBridgeCore<MAX_CAMERAS, MAX_TALLY_DEVICES, STANDBY_AS_PREVIEW, BRIDGE_LOG_LEVEL, ATEMminSource> bridge(atemSource);
 
 // ===============================================
 // MAIN FUNCTIONS
@@ -797,81 +104,13 @@ void handleSerialCommands() {
 void setup() {
     Serial.begin(115200);
     delay(2000);
-    
-    systemStartTime = millis();
-    
-    Serial.println("\n==========================================");
-    Serial.println("ESP32 ATEM Bridge v3.0");
-    Serial.println("BLE Multi-Device + ATEMmin Library");
-    Serial.println("USB Tethering Mode (No WiFi)");
-    Serial.println("==========================================");
-    
+
     // Initialize USB
     USB.begin();
-    
-    // Print device information
-    Serial.printf("Bridge Device: %s\n", BLE_DEVICE_NAME);
-    Serial.printf("Max Devices: %d simultaneous connections\n", MAX_TALLY_DEVICES);
-    Serial.printf("ATEM Target: %s (ATEMmin Library)\n", ATEM_IP);
-    Serial.printf("Free Heap: %d bytes\n", ESP.getFreeHeap());
-    
-    // Initialize BLE server
-    if (!initializeBLE()) {
-        Serial.println("BLE initialization failed - stopping");
-        while(1) delay(1000);
-    }
-    
-    // Initialize network connection via USB tethering
-    Serial.println("\nInitializing USB tethering network...");
-    if (initializeNetwork()) {
-        // Connect to ATEM using library
-        Serial.println("\nConnecting to ATEM using ATEMmin library...");
-        connectToATEM();
-    }
-    
-    Serial.println("\n==========================================");
-    Serial.println("ESP32 Tally Bridge Ready!");
-    Serial.println("Using proven ATEMmin library by SKAARHOJ");
-    Serial.println("Type HELP for available commands");
-    Serial.println("Monitoring ATEM for tally changes...");
-    Serial.println("Waiting for BLE tally devices to connect...");
-    Serial.println("==========================================\n");
-    
-    lastNetworkCheck = millis();
-    lastTallyCheck = millis();
-    lastHeartbeat = millis();
+
+    bridge.begin();
 }
 
 void loop() {
-    // Handle ATEM communication using library
-    handleATEM();
-    
-    // Check tally device connections
-    checkTallyDeviceConnections();
-    
-    // Send periodic heartbeat signal to tally devices
-    if (millis() - lastHeartbeat > HEARTBEAT_INTERVAL) {
-        sendHeartbeatSignal();
-    }
-    
-    // Handle serial commands
-    handleSerialCommands();
-    
-    // Periodic network connection check
-    if (millis() - lastNetworkCheck > NETWORK_CHECK_INTERVAL) {
-        lastNetworkCheck = millis();
-        
-        if (!checkNetworkConnectivity()) {
-            Serial.println("USB tethering network lost - attempting reconnection...");
-            networkConnected = false;
-            
-            if (initializeNetwork()) {
-                delay(2000); // Allow network to stabilize
-                connectToATEM();
-            }
-        }
-    }
-    
-    // Small delay for system stability
-    delay(10);
+    bridge.loop();
 }
@@ -10,8 +10,11 @@
  * - Secure BLE with automatic pairing and encryption
  * - Individual device registration with unique name and camera ID
  * - RGB LED status indication with brightness control
- * - Auto-reconnection with exponential backoff
+ * - Auto-reconnection with immediate first retry and jittered exponential backoff
+ * - Event-driven main loop: sleeps until a frame, BLE event, serial input or
+ *   LED-effect/timer deadline - no fixed polling delay
  * - Message integrity verification with checksums
+ * - Sub-second link-loss detection (missed heartbeats + BLE supervision timeout)
  * - Status monitoring and debugging via Serial
  * - Low power consumption in standby mode
  * - Support for 20 camera inputs with full state tracking
@@ -54,6 +57,20 @@
 #include <BLEScan.h>
 #include <BLEAdvertisedDevice.h>
 #include <BLEClient.h>
+#include <esp_gap_ble_api.h>
+#include <freertos/event_groups.h>
+#include "ReconnectBackoff.h"
+#include "LinkMonitor.h"
+#include "TallyClock.h"
+#include "TimerWheel.h"
+#include "TallyProtocol.h"
+#include "TallyPixels.h"
+#include "AmbientBrightness.h"
+#include "TallyOtaReceiver.h"
+#include "TallyPeripheral.h"
+#include "TallyScanFilter.h"
+#include "TallyGattCache.h"
+#include "PersistQueue.h"
 
 // ===============================================
 // CONFIGURATION - UPDATE THESE VALUES
@@ -65,42 +82,52 @@
 // BLE Configuration (must match bridge)
 #define BRIDGE_SERVICE_UUID "12345678-1234-5678-9abc-123456789abc"
 #define BRIDGE_CHARACTERISTIC_UUID "87654321-4321-8765-cba9-987654321cba"
+#define BRIDGE_SNAPSHOT_UUID "87654321-4321-8765-cba9-987654321cbb"
+#define BRIDGE_OTA_UUID "87654321-4321-8765-cba9-987654321cbc"
 #define BRIDGE_DEVICE_NAME "ATEM_Bridge_BLE"  // Name of bridge to connect to
+#define TALLY_PERIPHERAL false                // true = advertise and let a BRIDGE_CENTRAL bridge connect (no firmware updates)
 
 // LED Configuration
 #define LED_RED_PIN 25                        // GPIO pin for red LED
 #define LED_GREEN_PIN 26                      // GPIO pin for green LED
 #define LED_BLUE_PIN 27                       // GPIO pin for blue LED
-#define LED_BRIGHTNESS 128                    // LED brightness (0-255)
+#define LED_BRIGHTNESS 128                    // LED brightness (0-255) - full scale of the ambient curve
+#define AMBIENT_PIN -1                        // Ambient light sensor ADC1 pin (-1 = not fitted, fixed brightness)
 #define HEARTBEAT_LED_INTERVAL 2000           // Blue heartbeat pulse interval (ms)
 
+// Addressable LED strips (WS2812-style, same state as the RGB LED)
+#define PIXEL_CAMERA_PIN -1                   // Camera-top strip data pin (-1 = not fitted)
+#define PIXEL_CAMERA_COUNT 8                  // Camera-top strip pixels
+#define PIXEL_TALENT_PIN -1                   // Talent-facing strip data pin (-1 = not fitted)
+#define PIXEL_TALENT_COUNT 16                 // Talent-facing strip pixels
+
 // Connection Configuration
 #define SCAN_TIME 5                           // BLE scan time in seconds
 #define CONNECTION_TIMEOUT 10000              // Connection timeout (ms)
-#define RECONNECT_INTERVAL 15000              // Reconnection attempt interval (ms)
-#define MAX_RECONNECT_ATTEMPTS 5              // Max consecutive reconnection attempts
+#define RECONNECT_INTERVAL 500                // Base reconnection backoff after the immediate retry (ms)
+#define MAX_RECONNECT_INTERVAL 8000           // Reconnection backoff cap (ms)
 #define REGISTRATION_RETRY_INTERVAL 5000     // Registration retry interval (ms)
+#define BLE_CONN_INTERVAL_MIN 6               // Preferred connection interval min (1.25ms units = 7.5ms)
+#define BLE_CONN_INTERVAL_MAX 12              // Preferred connection interval max (1.25ms units = 15ms)
+#define BLE_SUPERVISION_TIMEOUT 500           // BLE supervision timeout - dead radio link detection (ms, 100-32000)
 
 // System Configuration
 #define HEARTBEAT_INTERVAL 30000              // Heartbeat/keepalive interval (ms)
-#define MESSAGE_TIMEOUT 60000                 // Message receive timeout (ms)
-#define HEARTBEAT_TIMEOUT 15000               // Heartbeat timeout for connection loss detection (ms)
+#define LINK_LOSS_TIMEOUT 750                 // Link-loss detection latency via missed heartbeats (ms)
+#define HEARTBEAT_MISS_LIMIT 3                // Missed heartbeats before link is declared lost
+#define HEARTBEAT_TIMEOUT 15000               // Fallback timeout if bridge ignores requested heartbeat period (ms)
+#define FRAME_QUEUE_LENGTH 24                 // Frames buffered between BLE callback and main loop (two full notifications)
+#define OTA_QUEUE_LENGTH 8                    // Firmware update notifications buffered for the main loop
+#define OTA_RESTART_DELAY 2000                // Restart into new firmware this long after the update (ms, waits while on PROGRAM)
+#define LOOP_IDLE_TIMEOUT 1000                // Longest main loop sleep with no events or timers (ms)
+#define LED_TEST_STEP 2000                    // Time each color shows in the TEST sequence (ms)
+#define SERIAL_LINE_MAX 128                   // Longest serial command line kept
 #define SERIAL_DEBUG true                     // Enable serial debugging
 
 // ===============================================
 // DATA STRUCTURES
 // ===============================================
 
-// BLE tally message structure (must match bridge)
-typedef struct {
-    uint8_t cameraId;        // Camera number (1-20) or 0 for heartbeat
-    char state[12];          // "PREVIEW", "PROGRAM", "OFF", "STANDBY", "HEARTBEAT", "NO_ATEM"
-    uint32_t timestamp;      // Message timestamp for debugging
-    uint8_t bridgeId;        // Bridge identifier (for multiple bridges)
-    uint8_t bridgeStatus;    // Bridge status: 0=No ATEM, 1=ATEM Connected
-    uint8_t checksum;        // Simple checksum for data integrity
-} __attribute__((packed)) TallyMessage;
-
 // Connection state
 typedef enum {
     STATE_DISCONNECTED,
@@ -111,6 +138,12 @@ typedef enum {
     STATE_ERROR
 } ConnectionState;
 
+// Firmware update notification handed from the BLE callback to the loop
+typedef struct {
+    uint16_t length;
+    uint8_t data[TALLY_BLE_MTU - 3];
+} OtaNotification;
+
 // ===============================================
 // GLOBAL VARIABLES
 // ===============================================
@@ -119,26 +152,89 @@ typedef enum {
 BLEClient* pClient = nullptr;
 BLERemoteService* pRemoteService = nullptr;
 BLERemoteCharacteristic* pRemoteCharacteristic = nullptr;
+BLERemoteCharacteristic* pOtaCharacteristic = nullptr;
 bool doConnect = false;
 bool connected = false;
 bool doScan = false;
-BLEAdvertisedDevice* myDevice = nullptr;
+bool scanning = false;              // Scan running in the background (loop keeps serving)
+bool scanTimedOut = false;          // Scan ran its full SCAN_TIME without finding the bridge
+unsigned long scanSeenBefore = 0;   // Adverts seen before the running scan
+BLEAddress bridgeAddress("00:00:00:00:00:00");   // Bridge found by the last scan
+esp_ble_addr_type_t bridgeAddressType = BLE_ADDR_TYPE_PUBLIC;
 
 // System state
 ConnectionState currentState = STATE_DISCONNECTED;
 String currentTallyState = "OFF";
 bool bridgeHasATEM = false;
+bool bridgeUnconfirmed = false;     // Bridge lost the ATEM a moment ago - last known state, resuming
 unsigned long lastMessageReceived = 0;
 unsigned long lastHeartbeatReceived = 0;
-unsigned long lastConnectionAttempt = 0;
-unsigned long lastRegistrationAttempt = 0;
 unsigned long lastHeartbeat = 0;
 int reconnectAttempts = 0;
+unsigned long nextReconnectDelay = 0;
 bool registered = false;
+ReconnectBackoff reconnectBackoff(RECONNECT_INTERVAL, MAX_RECONNECT_INTERVAL);
+LinkMonitor linkMonitor(LINK_LOSS_TIMEOUT / HEARTBEAT_MISS_LIMIT, HEARTBEAT_MISS_LIMIT, HEARTBEAT_TIMEOUT);
 
 // LED state
 bool heartbeatLedState = false;
-unsigned long lastHeartbeatLed = 0;
+TallyPixels<PIXEL_CAMERA_COUNT> cameraPixels;
+TallyPixels<PIXEL_TALENT_COUNT> talentPixels;
+AmbientBrightness ambient;                     // Room light scaling and LED current
+
+// Tally state from the bridge's advert, shown while connecting
+TallyAdvertisement bridgeAdvert;
+bool bridgeAdvertReceived = false;             // Set by the scan callback
+bool advertStateShown = false;                 // Tally state came from the advert
+
+// Picks the bridge out of every advert in range (raw payload, no parsing)
+TallyScanFilter scanFilter;
+
+// Bridge handles from the last discovery - reconnects skip discovery
+TallyGattCache gattCache;
+unsigned long lastSyncTime = 0;                // Connect to subscribed + snapshot (ms)
+
+// Firmware updates pushed by the bridge
+TallyOtaReceiver otaReceiver;
+
+// NVS writes (GATT handles, installed image) wait for a pause in switching
+PersistQueue persist;
+unsigned long lastTallyTraffic = 0;            // Last camera frame from the bridge
+
+// Advertising link for a central-role bridge (TALLY_PERIPHERAL)
+TallyPeripheral peripheral;
+
+// Scheduled work (reconnection, registration retry, link checks, LED effects,
+// LED flashes, OTA restart, light sensor)
+TimerWheel<7> timers;
+int8_t reconnectTimer = -1;
+int8_t registrationTimer = -1;
+int8_t linkCheckTimer = -1;
+int8_t ledEffectTimer = -1;
+int8_t otaRestartTimer = -1;
+int8_t ambientTimer = -1;
+int8_t flashTimer = -1;
+unsigned long ledEffectPeriod = 0;
+
+// Color shown over the tally state until the flash timer fires (data and
+// error flashes, TEST sequence)
+bool flashActive = false;
+uint8_t flashRed = 0, flashGreen = 0, flashBlue = 0;
+int8_t ledTestStep = -1;                       // TEST sequence position (-1 = not running)
+String serialLine;                             // Serial command being received
+
+// Main loop wake-up events and frame hand-off from the BLE callback
+#define LOOP_EVENT_FRAME   BIT0
+#define LOOP_EVENT_BLE     BIT1
+#define LOOP_EVENT_SERIAL  BIT2
+#define LOOP_EVENT_OTA     BIT3
+#define LOOP_EVENT_ALL     (LOOP_EVENT_FRAME | LOOP_EVENT_BLE | LOOP_EVENT_SERIAL | LOOP_EVENT_OTA)
+EventGroupHandle_t loopEvents = nullptr;
+QueueHandle_t frameQueue = nullptr;
+QueueHandle_t otaQueue = nullptr;
+unsigned long droppedFrames = 0;
+unsigned long droppedOtaChunks = 0;
+unsigned long loopCount = 0;
 
 // Statistics
 unsigned long totalMessagesReceived = 0;
@@ -147,6 +243,14 @@ unsigned long systemStartTime = 0;
 unsigned long totalOnlineTime = 0;
 unsigned long lastOnlineStart = 0;
 
+// Time-to-recover statistics (link loss -> first valid message)
+unsigned long linkLostAt = 0;
+unsigned long recoveryCount = 0;
+unsigned long lastRecoveryTime = 0;
+unsigned long minRecoveryTime = 0;
+unsigned long maxRecoveryTime = 0;
+unsigned long totalRecoveryTime = 0;
+
 // ===============================================
 // LED FUNCTIONS
 // ===============================================
@@ -158,9 +262,23 @@ void setLEDColor(uint8_t red, uint8_t green, uint8_t blue) {
     green = (green * LED_BRIGHTNESS) / 255;
     blue = (blue * LED_BRIGHTNESS) / 255;
     
+    // Then the room's light level - PROGRAM keeps its floor
+    bool program = (currentTallyState == "PROGRAM");
+    uint16_t requested = red + green + blue;
+    red = ambient.apply(red, program);
+    green = ambient.apply(green, program);
+    blue = ambient.apply(blue, program);
+    ambient.recordOutput(clockMillis(), red + green + blue, requested);
+    
     analogWrite(LED_RED_PIN, red);
     analogWrite(LED_GREEN_PIN, green);
     analogWrite(LED_BLUE_PIN, blue);
+    
+    // Strips are re-sent only when the color changes
+    cameraPixels.fill(red, green, blue);
+    cameraPixels.show();
+    talentPixels.fill(red, green, blue);
+    talentPixels.show();
 }
 
 // Turn off all LEDs
@@ -168,24 +286,80 @@ void setLEDOff() {
     setLEDColor(0, 0, 0);
 }
 
-// Flash LED with specified color
-void flashLED(uint8_t red, uint8_t green, uint8_t blue, int duration = 100) {
+// Show a color over the tally state for duration ms - the flash timer
+// returns the LED to the current state
+void showFlash(uint8_t red, uint8_t green, uint8_t blue, unsigned long duration) {
+    flashRed = red;
+    flashGreen = green;
+    flashBlue = blue;
+    flashActive = true;
+    timers.start(flashTimer, duration);
     setLEDColor(red, green, blue);
-    delay(duration);
-    updateTallyLED(); // Return to current state
+}
+
+// Flash LED with specified color (the TEST sequence owns the LED while it runs)
+void flashLED(uint8_t red, uint8_t green, uint8_t blue, unsigned long duration = 100) {
+    if (ledTestStep >= 0) return;
+    showFlash(red, green, blue, duration);
+}
+
+// Bridge ATEM status for log lines. While the bridge resumes its ATEM
+// session the last known state stays on the LED - a brief network drop must
+// not take a live camera's red light off.
+const char* bridgeATEMStatusName() {
+    if (!bridgeHasATEM) return "DISCONNECTED";
+    return bridgeUnconfirmed ? "RESUMING" : "OK";
+}
+
+// Tally state is known - registered, or connecting with state from the advert
+bool tallyStateKnown() {
+    return currentState == STATE_REGISTERED ||
+           (advertStateShown && (currentState == STATE_CONNECTING || currentState == STATE_CONNECTED));
+}
+
+// Blink/pulse period of the current LED pattern (0 = solid, no refresh needed)
+unsigned long currentLEDEffectPeriod() {
+    if (tallyStateKnown()) {
+        if (linkMonitor.isLost()) return 500;
+        if (currentTallyState == "PROGRAM" || currentTallyState == "PREVIEW" || 
+            currentTallyState == "STANDBY") return 0;
+        if (currentTallyState == "NO_ATEM" || !bridgeHasATEM) return 1500;
+        return HEARTBEAT_LED_INTERVAL; // Blue heartbeat pulse
+    }
+    if (currentState == STATE_CONNECTING) return 200;
+    if (currentState == STATE_SCANNING) return 1000;
+    return 0;
+}
+
+// Keep the LED effect timer running only while the current pattern animates
+void scheduleLEDEffect() {
+    unsigned long period = currentLEDEffectPeriod();
+    if (period == 0) {
+        timers.stop(ledEffectTimer);
+    } else if (period != ledEffectPeriod || !timers.isPending(ledEffectTimer)) {
+        timers.start(ledEffectTimer, period, period);
+    }
+    ledEffectPeriod = period;
 }
 
 // Update LED based on current tally state
 void updateTallyLED() {
-    // Check for heartbeat timeout (connection lost)
-    if (currentState == STATE_REGISTERED && 
-        millis() - lastHeartbeatReceived > HEARTBEAT_TIMEOUT) {
+    scheduleLEDEffect();
+    
+    // A flash holds the LED until its timer ends it
+    if (flashActive) {
+        setLEDColor(flashRed, flashGreen, flashBlue);
+        return;
+    }
+    
+    // Check for missed heartbeats (connection lost) - never show stale on-air state
+    if (currentState == STATE_REGISTERED && linkMonitor.isLost()) {
         // Connection lost - magenta blink
         static bool blinkState = false;
         static unsigned long lastBlink = 0;
-        if (millis() - lastBlink > 500) {
+        if (clockMillis() - lastBlink >= 500) {
             blinkState = !blinkState;
-            lastBlink = millis();
+            lastBlink = clockMillis();
             if (blinkState) {
                 setLEDColor(255, 0, 255); // Magenta
             } else {
@@ -195,7 +369,7 @@ void updateTallyLED() {
         return;
     }
     
-    if (currentState == STATE_REGISTERED) {
+    if (tallyStateKnown()) {
         // Show tally state based on camera status
         if (currentTallyState == "PROGRAM") {
             setLEDColor(255, 0, 0);  // Red - Live/Program
@@ -207,9 +381,9 @@ void updateTallyLED() {
             // Bridge connected but no ATEM - yellow slow pulse
             static bool pulseState = false;
             static unsigned long lastPulse = 0;
-            if (millis() - lastPulse > 1500) {
+            if (clockMillis() - lastPulse >= 1500) {
                 pulseState = !pulseState;
-                lastPulse = millis();
+                lastPulse = clockMillis();
                 if (pulseState) {
                     setLEDColor(255, 255, 0); // Yellow
                 } else {
@@ -230,9 +404,9 @@ void updateTallyLED() {
         // Fast orange blink
         static bool blinkState = false;
         static unsigned long lastBlink = 0;
-        if (millis() - lastBlink > 200) {
+        if (clockMillis() - lastBlink >= 200) {
             blinkState = !blinkState;
-            lastBlink = millis();
+            lastBlink = clockMillis();
             if (blinkState) {
                 setLEDColor(255, 128, 0); // Orange
             } else {
@@ -243,9 +417,9 @@ void updateTallyLED() {
         // Slow orange blink
         static bool blinkState = false;
         static unsigned long lastBlink = 0;
-        if (millis() - lastBlink > 1000) {
+        if (clockMillis() - lastBlink >= 1000) {
             blinkState = !blinkState;
-            lastBlink = millis();
+            lastBlink = clockMillis();
             if (blinkState) {
                 setLEDColor(255, 128, 0); // Orange
             } else {
@@ -259,41 +433,99 @@ void updateTallyLED() {
     }
 }
 
-// Handle heartbeat LED pulsing
-void handleHeartbeatLED() {
-    if (currentState == STATE_REGISTERED && currentTallyState == "OFF" && bridgeHasATEM) {
-        if (millis() - lastHeartbeatLed > HEARTBEAT_LED_INTERVAL) {
-            heartbeatLedState = !heartbeatLedState;
-            lastHeartbeatLed = millis();
-            updateTallyLED();
-        }
+// Refresh blink/pulse effects (LED effect timer callback, runs at the
+// current pattern's period)
+void refreshLED(int) {
+    // Heartbeat pulse toggles once per period; blinks track their own phase
+    if (tallyStateKnown() && currentTallyState == "OFF" && bridgeHasATEM) {
+        heartbeatLedState = !heartbeatLedState;
     }
+    updateTallyLED();
 }
 
-// ===============================================
-// MESSAGE FUNCTIONS
-// ===============================================
+// LED test colors, one every LED_TEST_STEP ms (TEST command)
+struct LEDTestColor {
+    const char* name;
+    uint8_t red, green, blue;
+};
+const LEDTestColor LED_TEST_SEQUENCE[] = {
+    { "Red (PROGRAM)", 255, 0, 0 },
+    { "Green (PREVIEW)", 0, 255, 0 },
+    { "Blue (CONNECTED)", 0, 0, 255 },
+    { "Yellow (NO ATEM)", 255, 255, 0 },
+    { "Orange (CONNECTING)", 255, 128, 0 },
+    { "Purple (ERROR)", 128, 0, 128 },
+    { "Magenta (CONNECTION LOST)", 255, 0, 255 },
+};
+const int8_t LED_TEST_STEPS = sizeof(LED_TEST_SEQUENCE) / sizeof(LED_TEST_SEQUENCE[0]);
 
-// Calculate simple checksum for message integrity
-uint8_t calculateChecksum(TallyMessage* msg) {
-    uint8_t checksum = 0;
-    checksum ^= msg->cameraId;
-    checksum ^= msg->bridgeId;
-    checksum ^= msg->bridgeStatus;
-    for (int i = 0; i < strlen(msg->state); i++) {
-        checksum ^= msg->state[i];
+// Show the next TEST color, or hand the LED back to the tally state
+void stepLEDTest() {
+    ledTestStep++;
+    if (ledTestStep >= LED_TEST_STEPS) {
+        ledTestStep = -1;
+        Serial.println("Test complete - returning to normal operation");
+        return;
     }
-    return checksum;
+    const LEDTestColor& color = LED_TEST_SEQUENCE[ledTestStep];
+    Serial.printf("%s...\n", color.name);
+    showFlash(color.red, color.green, color.blue, LED_TEST_STEP);
 }
 
+// Flash over (flash timer callback) - the loop's LED update restores the
+// tally state
+void endFlash(int) {
+    flashActive = false;
+    if (ledTestStep >= 0) {
+        stepLEDTest();
+    }
+}
+
+// Sample the light sensor (ambient timer) - the loop's LED update applies a
+// new brightness
+void sampleAmbient(int) {
+    ambient.update();
+}
+
+// ===============================================
+// MESSAGE FUNCTIONS
+// ===============================================
+
 // Verify message integrity
 bool verifyMessage(TallyMessage* msg) {
-    uint8_t receivedChecksum = msg->checksum;
-    msg->checksum = 0; // Clear for calculation
-    uint8_t calculatedChecksum = calculateChecksum(msg);
-    msg->checksum = receivedChecksum; // Restore
+    return verifyTallyMessage(msg);
+}
+
+// Reset reconnection backoff and record time-to-recover after a link loss
+void recordSync() {
+    if (reconnectBackoff.getAttempts() > 0) {
+        reconnectBackoff.reset();
+        reconnectAttempts = 0;
+    }
     
-    return (receivedChecksum == calculatedChecksum);
+    if (linkLostAt > 0) {
+        lastRecoveryTime = clockMillis() - linkLostAt;
+        linkLostAt = 0;
+        
+        if (recoveryCount == 0 || lastRecoveryTime < minRecoveryTime) {
+            minRecoveryTime = lastRecoveryTime;
+        }
+        if (lastRecoveryTime > maxRecoveryTime) {
+            maxRecoveryTime = lastRecoveryTime;
+        }
+        totalRecoveryTime += lastRecoveryTime;
+        recoveryCount++;
+        
+        if (SERIAL_DEBUG) {
+            Serial.printf("✓ Link recovered in %lu ms\n", lastRecoveryTime);
+        }
+    }
+}
+
+// Schedule the next reconnection attempt using jittered backoff
+void scheduleReconnect() {
+    nextReconnectDelay = reconnectBackoff.nextDelay();
+    timers.start(reconnectTimer, nextReconnectDelay);
 }
 
 // Process received tally message
@@ -307,17 +539,27 @@ void processTallyMessage(TallyMessage* msg) {
         return;
     }
     
+    // Any valid message means we are in sync with the bridge
+    recordSync();
+    
+    // Every valid frame keeps the link alive - the bridge skips heartbeats
+    // while camera frames flow - and heartbeats also arm loss detection
+    linkMonitor.onMessage(msg->cameraId, clockMillis());
+    
     // Update bridge status
-    bridgeHasATEM = (msg->bridgeStatus == 1);
+    bool hadATEM = bridgeHasATEM;
+    bool wasUnconfirmed = bridgeUnconfirmed;
+    bridgeHasATEM = (msg->bridgeStatus & TALLY_BRIDGE_ATEM) != 0;
+    bridgeUnconfirmed = (msg->bridgeStatus & TALLY_BRIDGE_UNCONFIRMED) != 0;
     
     // Handle heartbeat messages (cameraId = 0)
     if (msg->cameraId == 0) {
-        lastHeartbeatReceived = millis();
-        lastMessageReceived = millis();
+        lastHeartbeatReceived = clockMillis();
+        lastMessageReceived = clockMillis();
         
-        if (SERIAL_DEBUG) {
-            Serial.printf("💓 Heartbeat from bridge (ATEM:%s)\n", 
-                         bridgeHasATEM ? "OK" : "DISCONNECTED");
+        // Heartbeats arrive several times a second - only log status changes
+        if (SERIAL_DEBUG && (bridgeHasATEM != hadATEM || bridgeUnconfirmed != wasUnconfirmed)) {
+            Serial.printf("💓 Heartbeat from bridge (ATEM:%s)\n", bridgeATEMStatusName());
         }
         
         // Update LED based on bridge ATEM status
@@ -325,6 +567,9 @@ void processTallyMessage(TallyMessage* msg) {
         return;
     }
     
+    // The switcher is cutting - keep NVS writes out of the way
+    lastTallyTraffic = clockMillis();
+    
     // Check if message is for this camera
     if (msg->cameraId != CAMERA_ID) {
         // Message for different camera - ignore silently
@@ -333,8 +578,8 @@ void processTallyMessage(TallyMessage* msg) {
     
     // Update statistics
     totalMessagesReceived++;
-    lastMessageReceived = millis();
-    lastHeartbeatReceived = millis(); // Any message resets heartbeat timeout
+    lastMessageReceived = clockMillis();
+    lastHeartbeatReceived = clockMillis(); // Any message resets heartbeat timeout
     
     // Flash white to indicate data received
     flashLED(255, 255, 255, 50);
@@ -349,23 +594,67 @@ void processTallyMessage(TallyMessage* msg) {
             Serial.printf("✓ CAM%d: %s -> %s (bridge %d, ATEM:%s, ts: %lu)\n", 
                          msg->cameraId, previousState.c_str(), 
                          newState.c_str(), msg->bridgeId, 
-                         bridgeHasATEM ? "OK" : "DISCONNECTED", msg->timestamp);
+                         bridgeATEMStatusName(), msg->timestamp);
         }
         
         updateTallyLED();
     }
 }
 
+// Show the on-air state from the bridge's advert while the connection is set
+// up - the snapshot and registration then confirm it
+void applyBridgeAdvertisement() {
+    advertStateShown = bridgeAdvertReceived;
+    if (!bridgeAdvertReceived) {
+        return;
+    }
+    bridgeAdvertReceived = false;
+    
+    uint32_t cameraBit = 1UL << (CAMERA_ID - 1);
+    bridgeHasATEM = (bridgeAdvert.status & TALLY_ADV_STATUS_ATEM) != 0;
+    bridgeUnconfirmed = (bridgeAdvert.status & TALLY_ADV_STATUS_UNCONFIRMED) != 0;
+    if (!bridgeHasATEM) {
+        currentTallyState = "NO_ATEM";
+    } else if (bridgeAdvert.program & cameraBit) {
+        currentTallyState = "PROGRAM";
+    } else if (bridgeAdvert.preview & cameraBit) {
+        currentTallyState = "PREVIEW";
+    } else {
+        currentTallyState = "OFF";
+    }
+    
+    if (SERIAL_DEBUG) {
+        Serial.printf("✓ CAM%d: %s from bridge advert (seq %d, ATEM:%s)\n",
+                     CAMERA_ID, currentTallyState.c_str(), bridgeAdvert.sequence,
+                     bridgeATEMStatusName());
+    }
+    updateTallyLED();
+}
+
+// Service layout from the bridge's advert - the GATT cache key (0 = not
+// advertised, handles are discovered and not cached)
+uint8_t advertisedGattLayout() {
+    return advertStateShown ? bridgeAdvert.gatt : 0;
+}
+
 // ===============================================
 // BLE FUNCTIONS
 // ===============================================
 
-// BLE notification callback for receiving data
-static void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
-                          uint8_t* pData, size_t length, bool isNotify) {
-    if (length == sizeof(TallyMessage)) {
-        TallyMessage* msg = (TallyMessage*)pData;
-        processTallyMessage(msg);
+// Hand frames from the bridge to the main loop so LED work (including
+// flashes) never blocks the BLE stack
+static void queueBridgeFrames(const uint8_t* pData, size_t length) {
+    // A notification or write holds one frame or a packed container of several
+    TallyMessage frames[TALLY_MAX_BATCH_FRAMES];
+    int count = unpackTallyFrames(pData, length, frames, TALLY_MAX_BATCH_FRAMES);
+    
+    if (count > 0) {
+        for (int i = 0; i < count; i++) {
+            if (xQueueSend(frameQueue, &frames[i], 0) != pdTRUE) {
+                droppedFrames++;
+            }
+        }
+        xEventGroupSetBits(loopEvents, LOOP_EVENT_FRAME);
     } else {
         if (SERIAL_DEBUG) {
             Serial.printf("✗ Received invalid message size: %d bytes\n", length);
@@ -373,99 +662,172 @@ static void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
     }
 }
 
+// BLE notification callback for receiving data
+static void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
+                                     uint8_t* pData, size_t length, bool isNotify) {
+    queueBridgeFrames(pData, length);
+}
+
+// Firmware update notification - flash work happens in the loop. A chunk
+// dropped here is resent once the bridge sees the gap.
+static void queueOtaNotification(const uint8_t* pData, size_t length) {
+    OtaNotification notification;
+    if (length > sizeof(notification.data)) return;
+    
+    notification.length = length;
+    memcpy(notification.data, pData, length);
+    if (xQueueSend(otaQueue, &notification, 0) != pdTRUE) {
+        droppedOtaChunks++;
+    }
+    xEventGroupSetBits(loopEvents, LOOP_EVENT_OTA);
+}
+
+static void otaNotifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
+                             uint8_t* pData, size_t length, bool isNotify) {
+    queueOtaNotification(pData, length);
+}
+
+// GATT client events - notifications on a link set up from cached handles
+// bypass the library's characteristic objects
+static void onGattcEvent(esp_gattc_cb_event_t event, esp_gatt_if_t gattcIf, esp_ble_gattc_cb_param_t* param) {
+    gattCache.onGattcEvent(event, gattcIf, param);
+}
+
+// Link to the bridge up (BLE task)
+void onBridgeConnected() {
+    if (SERIAL_DEBUG) {
+        Serial.println("✓ BLE connected to bridge");
+    }
+    connected = true;
+    currentState = STATE_CONNECTED;
+    linkMonitor.begin(clockMillis());
+    timers.stop(reconnectTimer);
+    timers.start(linkCheckTimer, linkMonitor.getTimeout() + 1);
+    timers.start(registrationTimer, REGISTRATION_RETRY_INTERVAL, REGISTRATION_RETRY_INTERVAL);
+    
+    // Start tracking online time - the loop shows the new state
+    lastOnlineStart = clockMillis();
+    
+    xEventGroupSetBits(loopEvents, LOOP_EVENT_BLE);
+}
+
+// Link to the bridge dropped (BLE task)
+void onBridgeDisconnected() {
+    if (SERIAL_DEBUG) {
+        Serial.println("✗ BLE disconnected from bridge");
+    }
+    connected = false;
+    registered = false;
+    advertStateShown = false;
+    currentState = STATE_DISCONNECTED;
+    timers.stop(linkCheckTimer);
+    timers.stop(registrationTimer);
+    
+    // Update total online time
+    if (lastOnlineStart > 0) {
+        totalOnlineTime += clockMillis() - lastOnlineStart;
+        lastOnlineStart = 0;
+    }
+    
+    // Trigger reconnection (first retry is immediate) - a peripheral tally
+    // just keeps advertising for the bridge
+    if (linkLostAt == 0) {
+        linkLostAt = clockMillis();
+    }
+    if (!TALLY_PERIPHERAL) {
+        scheduleReconnect();
+    }
+    xEventGroupSetBits(loopEvents, LOOP_EVENT_BLE);
+}
+
 // BLE client connection callback
 class MyClientCallback : public BLEClientCallbacks {
     void onConnect(BLEClient* pclient) {
-        if (SERIAL_DEBUG) {
-            Serial.println("✓ BLE connected to bridge");
-        }
-        connected = true;
-        currentState = STATE_CONNECTED;
-        reconnectAttempts = 0;
-        
-        // Start tracking online time
-        lastOnlineStart = millis();
-        
-        updateTallyLED();
+        onBridgeConnected();
     }
 
     void onDisconnect(BLEClient* pclient) {
-        if (SERIAL_DEBUG) {
-            Serial.println("✗ BLE disconnected from bridge");
-        }
-        connected = false;
-        registered = false;
-        currentState = STATE_DISCONNECTED;
-        
-        // Update total online time
-        if (lastOnlineStart > 0) {
-            totalOnlineTime += millis() - lastOnlineStart;
-            lastOnlineStart = 0;
-        }
-        
-        updateTallyLED();
-        
-        // Trigger reconnection
-        doScan = true;
-        lastConnectionAttempt = millis();
+        gattCache.detach();
+        onBridgeDisconnected();
     }
 };
 
+// Central-role bridge connected or dropped (TALLY_PERIPHERAL). The bridge read
+// the registration characteristic before writing frames, so the tally counts
+// as registered as soon as the link is up.
+void onPeripheralLink(bool up) {
+    if (!up) {
+        onBridgeDisconnected();
+        return;
+    }
+    onBridgeConnected();
+    timers.stop(registrationTimer);
+    registered = true;
+    currentState = STATE_REGISTERED;
+}
+
 // BLE advertised device callback for finding the bridge
 class MyAdvertisedDeviceCallbacks: public BLEAdvertisedDeviceCallbacks {
     void onResult(BLEAdvertisedDevice advertisedDevice) {
-        if (SERIAL_DEBUG) {
-            Serial.printf("Found BLE device: %s\n", advertisedDevice.toString().c_str());
+        // Every advert in range lands here, already copied by the library -
+        // reject strangers on the raw payload without parsing or logging
+        const uint8_t* payload = advertisedDevice.getPayload();
+        size_t length = advertisedDevice.getPayloadLength();
+        if (!scanFilter.matches(payload, length)) {
+            return;
         }
         
-        // Check if this is our target bridge
-        if (advertisedDevice.haveServiceUUID() && 
-            advertisedDevice.isAdvertisingService(BLEUUID(BRIDGE_SERVICE_UUID))) {
-            
-            if (SERIAL_DEBUG) {
-                Serial.printf("✓ Found ATEM bridge: %s\n", advertisedDevice.getName().c_str());
-            }
-            
-            BLEDevice::getScan()->stop();
-            myDevice = new BLEAdvertisedDevice(advertisedDevice);
-            doConnect = true;
-            doScan = false;
-            currentState = STATE_CONNECTING;
-            updateTallyLED();
-        } else {
-            if (SERIAL_DEBUG) {
-                Serial.println("  Not our target bridge");
-            }
+        if (SERIAL_DEBUG) {
+            Serial.printf("✓ Found ATEM bridge: %s\n", advertisedDevice.getAddress().toString().c_str());
         }
+        
+        // Tally state from the scan response (read by the loop once the scan returns)
+        uint8_t dataLength = 0;
+        const uint8_t* data = TallyScanFilter::findField(payload, length, TALLY_AD_MANUFACTURER, dataLength);
+        bridgeAdvertReceived = (data != nullptr) && decodeTallyAdvertisement(data, dataLength, &bridgeAdvert);
+        
+        BLEDevice::getScan()->stop();
+        bridgeAddress = advertisedDevice.getAddress();   // The result itself goes with clearResults()
+        bridgeAddressType = advertisedDevice.getAddressType();
+        doConnect = true;
+        doScan = false;
+        currentState = STATE_CONNECTING;
+        xEventGroupSetBits(loopEvents, LOOP_EVENT_BLE);
     }
 };
 
-// Connect to BLE bridge server
-bool connectToServer() {
-    if (SERIAL_DEBUG) {
-        Serial.printf("Connecting to bridge: %s\n", myDevice->getAddress().toString().c_str());
+MyAdvertisedDeviceCallbacks scanCallbacks;
+
+// Show the bridge's snapshot of every camera so the current state is shown
+// before registration completes
+void applyBridgeSnapshot(const std::string& value) {
+    TallyMessage frames[TALLY_SNAPSHOT_MAX_FRAMES];
+    int count = unpackTallyFrames((const uint8_t*)value.data(), value.length(),
+                                  frames, TALLY_SNAPSHOT_MAX_FRAMES);
+    for (int i = 0; i < count; i++) {
+        processTallyMessage(&frames[i]);
     }
     
-    totalConnectionAttempts++;
-    
-    pClient = BLEDevice::createClient();
-    pClient->setClientCallbacks(new MyClientCallback());
-    
-    // Connect to the remove BLE Server
-    if (!pClient->connect(myDevice)) {
-        if (SERIAL_DEBUG) {
-            Serial.println("✗ Failed to connect to bridge");
-        }
-        return false;
+    if (SERIAL_DEBUG) {
+        Serial.printf("✓ Snapshot: %d frames, CAM%d -> %s\n", count, CAMERA_ID, currentTallyState.c_str());
     }
-    
+}
+
+// Read the snapshot after discovery (older bridges have no snapshot)
+void readBridgeSnapshot(BLERemoteCharacteristic* pSnapshot) {
+    if (pSnapshot == nullptr || !pSnapshot->canRead()) return;
+    applyBridgeSnapshot(pSnapshot->readValue());
+}
+
+// Full service discovery: find the characteristics, subscribe, read the
+// snapshot and remember the handles for the next connection
+bool discoverBridgeService() {
     // Obtain a reference to the service
     pRemoteService = pClient->getService(BRIDGE_SERVICE_UUID);
     if (pRemoteService == nullptr) {
         if (SERIAL_DEBUG) {
             Serial.println("✗ Failed to find bridge service");
         }
-        pClient->disconnect();
         return false;
     }
     
@@ -475,7 +837,6 @@ bool connectToServer() {
         if (SERIAL_DEBUG) {
             Serial.println("✗ Failed to find bridge characteristic");
         }
-        pClient->disconnect();
         return false;
     }
     
@@ -487,31 +848,135 @@ bool connectToServer() {
         }
     }
     
+    // Firmware updates (older bridges have no OTA characteristic)
+    pOtaCharacteristic = pRemoteService->getCharacteristic(BRIDGE_OTA_UUID);
+    if (pOtaCharacteristic != nullptr && pOtaCharacteristic->canNotify()) {
+        pOtaCharacteristic->registerForNotify(otaNotifyCallback);
+    } else {
+        pOtaCharacteristic = nullptr;
+    }
+    
+    // Sync state without waiting for the registration reply
+    BLERemoteCharacteristic* pSnapshot = pRemoteService->getCharacteristic(BRIDGE_SNAPSHOT_UUID);
+    readBridgeSnapshot(pSnapshot);
+    
+    if (pRemoteCharacteristic->canNotify()) {
+        gattCache.store(bridgeAddress, advertisedGattLayout(), pRemoteCharacteristic,
+                        (pSnapshot != nullptr && pSnapshot->canRead()) ? pSnapshot : nullptr,
+                        pOtaCharacteristic);
+    }
+    return true;
+}
+
+// Known bridge: subscribe and read the snapshot by cached handle. On a
+// mismatch the entry is dropped and the caller discovers instead.
+bool attachCachedHandles() {
+    if (!gattCache.has(bridgeAddress, advertisedGattLayout())) return false;
+    
+    std::string snapshot;
+    if (!gattCache.attach(pClient, snapshot)) {
+        if (SERIAL_DEBUG) {
+            Serial.println("✗ Cached GATT handles rejected - discovering");
+        }
+        return false;
+    }
+    pRemoteService = nullptr;
+    pRemoteCharacteristic = nullptr;
+    pOtaCharacteristic = nullptr;
+    applyBridgeSnapshot(snapshot);
+    return true;
+}
+
+// Write to the bridge's frame characteristic (cached or discovered). The
+// library write reports nothing, so it counts as sent while the link is up.
+bool writeBridgeFrames(const uint8_t* data, size_t length) {
+    if (gattCache.isActive()) {
+        return gattCache.writeFrames(data, length) == ESP_OK;
+    }
+    if (!pRemoteCharacteristic) return false;
+    pRemoteCharacteristic->writeValue((uint8_t*)data, length, false);
+    return pClient->isConnected();
+}
+
+// Connect to BLE bridge server
+bool connectToServer() {
+    if (SERIAL_DEBUG) {
+        Serial.printf("Connecting to bridge: %s\n", bridgeAddress.toString().c_str());
+    }
+    
+    totalConnectionAttempts++;
+    
+    // Show the advertised state until the connection confirms it
+    applyBridgeAdvertisement();
+    
+    pClient = BLEDevice::createClient();
+    pClient->setClientCallbacks(new MyClientCallback());
+    
+    // Short supervision timeout so the controller reports a dead link quickly
+    esp_ble_gap_set_prefer_conn_params(*bridgeAddress.getNative(),
+                                       BLE_CONN_INTERVAL_MIN, BLE_CONN_INTERVAL_MAX,
+                                       0, BLE_SUPERVISION_TIMEOUT / 10);
+    
+    // Connect to the remove BLE Server
+    if (!pClient->connect(bridgeAddress, bridgeAddressType)) {
+        if (SERIAL_DEBUG) {
+            Serial.println("✗ Failed to connect to bridge");
+        }
+        return false;
+    }
+    
+    if (SERIAL_DEBUG) {
+        Serial.printf("✓ Negotiated MTU %d\n", pClient->getMTU());
+    }
+    
+    // Subscribe and sync state without waiting for the registration reply
+    unsigned long syncStart = clockMillis();
+    bool cached = attachCachedHandles();
+    if (!cached && !discoverBridgeService()) {
+        pClient->disconnect();
+        return false;
+    }
+    lastSyncTime = clockMillis() - syncStart;
+    
+    if (SERIAL_DEBUG) {
+        Serial.printf("✓ Synced with bridge in %lu ms (%s)\n", lastSyncTime,
+                     cached ? "cached handles" : "service discovery");
+    }
+    
     // Send registration message
     registerWithBridge();
     
     return true;
 }
 
+// Registration message with requested heartbeat period: "TALLY_REG:1:Tally_CAM_1:250"
+String registrationMessage() {
+    return "TALLY_REG:" + String(CAMERA_ID) + ":" + String(DEVICE_NAME) + 
+           ":" + String(linkMonitor.getPeriod());
+}
+
 // Register this tally device with the bridge
 void registerWithBridge() {
-    if (!connected || !pRemoteCharacteristic) return;
+    if (!connected || (!pRemoteCharacteristic && !gattCache.isActive())) return;
     
-    // Send registration message: "TALLY_REG:1:Tally_CAM_1"
-    String regMessage = "TALLY_REG:" + String(CAMERA_ID) + ":" + String(DEVICE_NAME);
+    String regMessage = registrationMessage();
     
     if (SERIAL_DEBUG) {
         Serial.printf("Registering with bridge: %s\n", regMessage.c_str());
     }
     
-    pRemoteCharacteristic->writeValue(regMessage.c_str(), regMessage.length());
-    lastRegistrationAttempt = millis();
-    
-    // Give bridge time to process registration
-    delay(1000);
+    // State is already synced from the snapshot - nothing waits on the
+    // bridge's side. A failed write leaves the registration timer running.
+    if (!writeBridgeFrames((const uint8_t*)regMessage.c_str(), regMessage.length())) {
+        if (SERIAL_DEBUG) {
+            Serial.println("✗ Registration write failed - will retry");
+        }
+        return;
+    }
     
     registered = true;
     currentState = STATE_REGISTERED;
+    timers.stop(registrationTimer);
     
     if (SERIAL_DEBUG) {
         Serial.printf("✓ Registered as %s for camera %d\n", DEVICE_NAME, CAMERA_ID);
@@ -520,6 +985,13 @@ void registerWithBridge() {
     updateTallyLED();
 }
 
+// Scan ran its full time (BLE task) - the loop backs off and scans again.
+// A scan stopped because the bridge was found does not end up here.
+void onScanComplete(BLEScanResults results) {
+    scanTimedOut = true;
+    xEventGroupSetBits(loopEvents, LOOP_EVENT_BLE);
+}
+
 // Start BLE scan for bridge
 void startBLEScan() {
     if (SERIAL_DEBUG) {
@@ -529,59 +1001,162 @@ void startBLEScan() {
     currentState = STATE_SCANNING;
     updateTallyLED();
     
+    // Controller duplicate filter on (each advertiser reported once per
+    // scan), library parsing off - the scan filter reads the raw payload.
+    // The scan runs in the background; onResult() or onScanComplete() wake
+    // the loop when it is over.
     BLEScan* pBLEScan = BLEDevice::getScan();
-    pBLEScan->setAdvertisedDeviceCallbacks(new MyAdvertisedDeviceCallbacks());
+    pBLEScan->setAdvertisedDeviceCallbacks(&scanCallbacks, false, false);
     pBLEScan->setInterval(1349);
     pBLEScan->setWindow(449);
     pBLEScan->setActiveScan(true);
-    pBLEScan->start(SCAN_TIME, false);
+    scanSeenBefore = scanFilter.getSeen();
+    scanning = pBLEScan->start(SCAN_TIME, onScanComplete, false);
+}
+
+// Scan over (loop): the bridge was found or the scan timed out
+void finishBLEScan() {
+    scanning = false;
+    scanTimedOut = false;
+    BLEDevice::getScan()->clearResults(); // Release the results the library kept
+    
+    if (SERIAL_DEBUG) {
+        Serial.printf("Scan done: %lu adverts seen\n", scanFilter.getSeen() - scanSeenBefore);
+    }
+}
+
+// Drop the link to the bridge (reconnection follows from the disconnect callback)
+void disconnectFromBridge() {
+    if (TALLY_PERIPHERAL) {
+        peripheral.disconnect();
+    } else {
+        pClient->disconnect();
+    }
 }
 
 // ===============================================
 // SYSTEM FUNCTIONS
 // ===============================================
 
-// Check connection health and handle reconnection
-void handleConnection() {
-    unsigned long currentTime = millis();
+// Missed-heartbeat link-loss detection (link check timer callback)
+void checkLink(int) {
+    if (!connected) return;
     
-    // Handle connection timeouts
-    if (connected && (currentTime - lastMessageReceived > MESSAGE_TIMEOUT)) {
+    unsigned long currentTime = clockMillis();
+    bool wasLost = linkMonitor.isLost();
+    LinkStatus link = linkMonitor.update(currentTime);
+    
+    if (link == LINK_LOST && !wasLost) {
         if (SERIAL_DEBUG) {
-            Serial.println("Message timeout - disconnecting");
+            Serial.printf("✗ Link lost - no frames for %lu ms\n", 
+                         currentTime - linkMonitor.getLastFrame());
         }
-        pClient->disconnect();
+        linkLostAt = currentTime;
+        updateTallyLED();
+    } else if (link == LINK_DEAD) {
+        if (SERIAL_DEBUG) {
+            Serial.println("Link dead - disconnecting");
+        }
+        disconnectFromBridge();
         return;
     }
     
-    // Handle reconnection attempts
-    if (!connected && !doConnect && !doScan) {
-        if (currentTime - lastConnectionAttempt > RECONNECT_INTERVAL) {
-            if (reconnectAttempts < MAX_RECONNECT_ATTEMPTS) {
-                if (SERIAL_DEBUG) {
-                    Serial.printf("Reconnection attempt %d/%d\n", 
-                                 reconnectAttempts + 1, MAX_RECONNECT_ATTEMPTS);
-                }
-                doScan = true;
-                reconnectAttempts++;
-                lastConnectionAttempt = currentTime;
-            } else {
-                // Too many failed attempts - wait longer
-                if (currentTime - lastConnectionAttempt > (RECONNECT_INTERVAL * 3)) {
-                    if (SERIAL_DEBUG) {
-                        Serial.println("Resetting reconnection attempts");
-                    }
-                    reconnectAttempts = 0;
-                }
+    // Check again just after the next possible state change
+    unsigned long silence = clockMillis() - linkMonitor.getLastFrame();
+    unsigned long limit = linkMonitor.getTimeout() + (linkMonitor.isLost() ? linkMonitor.getGrace() : 0);
+    timers.start(linkCheckTimer, (silence < limit) ? limit - silence + 1 : 1);
+}
+
+// Reconnection attempt (reconnect timer callback, armed with the backoff delay)
+void attemptReconnect(int) {
+    if (TALLY_PERIPHERAL || connected || doConnect || doScan || scanning) return;
+    
+    reconnectAttempts++;
+    if (SERIAL_DEBUG) {
+        Serial.printf("Reconnection attempt %d (after %lu ms backoff)\n", 
+                     reconnectAttempts, nextReconnectDelay);
+    }
+    doScan = true;
+}
+
+// Re-register if connection exists but not registered (registration timer callback)
+void retryRegistration(int) {
+    if (connected && !registered) {
+        registerWithBridge();
+    }
+}
+
+// Apply frames queued by the BLE notification callback
+void processPendingFrames() {
+    TallyMessage msg;
+    while (xQueueReceive(frameQueue, &msg, 0) == pdTRUE) {
+        processTallyMessage(&msg);
+    }
+}
+
+// Write firmware update notifications to flash and answer the bridge
+void processOtaChunks() {
+    OtaNotification notification;
+    while (xQueueReceive(otaQueue, &notification, 0) == pdTRUE) {
+        bool wasComplete = otaReceiver.isComplete();
+        TallyOtaReply reply;
+        size_t length = otaReceiver.handle(notification.data, notification.length, &reply);
+        if (length > 0 && connected && gattCache.isActive()) {
+            gattCache.writeOta((const uint8_t*)&reply, length);
+        } else if (length > 0 && connected && pOtaCharacteristic) {
+            pOtaCharacteristic->writeValue((uint8_t*)&reply, length, false);
+        }
+        
+        if (SERIAL_DEBUG && length > 0 && reply.type == TALLY_OTA_REJECT) {
+            Serial.printf("Firmware offer declined (reason %lu)\n", (unsigned long)reply.value);
+        }
+        if (otaReceiver.isComplete() && !wasComplete) {
+            if (SERIAL_DEBUG) {
+                Serial.println("✓ Firmware update installed - restarting when off PROGRAM");
             }
+            timers.start(otaRestartTimer, OTA_RESTART_DELAY);
         }
     }
+}
+
+// Restart into updated firmware (OTA restart timer), never while on air
+void restartAfterUpdate(int) {
+    if (currentTallyState == "PROGRAM") {
+        timers.start(otaRestartTimer, OTA_RESTART_DELAY);
+        return;
+    }
+    if (SERIAL_DEBUG) {
+        Serial.println("Restarting into new firmware...");
+        Serial.flush();
+    }
+    persist.flush();
+    ESP.restart();
+}
+
+// Serial receive callback (runs on the UART event task)
+void onSerialReceive() {
+    xEventGroupSetBits(loopEvents, LOOP_EVENT_SERIAL);
+}
+
+// Create loop events and scheduled work (before BLE starts, since callbacks
+// arm timers and wake the loop)
+void initializeTimers() {
+    loopEvents = xEventGroupCreate();
+    frameQueue = xQueueCreate(FRAME_QUEUE_LENGTH, sizeof(TallyMessage));
+    otaQueue = xQueueCreate(OTA_QUEUE_LENGTH, sizeof(OtaNotification));
+    if (SERIAL_DEBUG) {
+        Serial.onReceive(onSerialReceive);
+    }
     
-    // Re-register if connection exists but not registered
-    if (connected && !registered) {
-        if (currentTime - lastRegistrationAttempt > REGISTRATION_RETRY_INTERVAL) {
-            registerWithBridge();
-        }
+    reconnectTimer = timers.create(attemptReconnect);
+    registrationTimer = timers.create(retryRegistration);
+    linkCheckTimer = timers.create(checkLink);
+    ledEffectTimer = timers.create(refreshLED);
+    otaRestartTimer = timers.create(restartAfterUpdate);
+    ambientTimer = timers.create(sampleAmbient);
+    flashTimer = timers.create(endFlash);
+    if (ambient.isFitted()) {
+        timers.start(ambientTimer, AMBIENT_SAMPLE_INTERVAL, AMBIENT_SAMPLE_INTERVAL);
     }
 }
 
@@ -589,10 +1164,10 @@ void handleConnection() {
 void printSystemStatus() {
     Serial.println("\n==== ESP32 Tally Light Status ====");
     Serial.printf("Device: %s (CAM%d)\n", DEVICE_NAME, CAMERA_ID);
-    Serial.printf("Uptime: %lu seconds\n", (millis() - systemStartTime) / 1000);
+    Serial.printf("Uptime: %lu seconds\n", (clockMillis() - systemStartTime) / 1000);
     
     if (lastOnlineStart > 0) {
-        unsigned long currentOnlineTime = millis() - lastOnlineStart;
+        unsigned long currentOnlineTime = clockMillis() - lastOnlineStart;
         Serial.printf("Online Time: %lu seconds (current session)\n", currentOnlineTime / 1000);
     }
     Serial.printf("Total Online: %lu seconds\n", totalOnlineTime / 1000);
@@ -603,38 +1178,114 @@ void printSystemStatus() {
     };
     Serial.printf("State: %s\n", stateNames[currentState]);
     Serial.printf("Tally: %s\n", currentTallyState.c_str());
-    Serial.printf("Bridge ATEM: %s\n", bridgeHasATEM ? "Connected" : "Disconnected");
+    Serial.printf("Bridge ATEM: %s\n", bridgeHasATEM ?
+                  (bridgeUnconfirmed ? "Resuming (last known state)" : "Connected") : "Disconnected");
     
+    if (TALLY_PERIPHERAL) {
+        Serial.printf("Link: peripheral, %lu frame writes from the bridge\n", peripheral.getWrites());
+    } else {
+        Serial.printf("Scan: %lu adverts seen, %lu processed\n",
+                     scanFilter.getSeen(), scanFilter.getProcessed());
+        Serial.printf("GATT: %lu cached, %lu discovered, %lu rejected, last sync %lu ms\n",
+                     gattCache.getHits(), gattCache.getDiscoveries(),
+                     gattCache.getInvalidations(), lastSyncTime);
+    }
     if (connected) {
         Serial.println("BLE: Connected to bridge");
         if (lastMessageReceived > 0) {
             Serial.printf("Last message: %lu seconds ago\n", 
-                         (millis() - lastMessageReceived) / 1000);
+                         (clockMillis() - lastMessageReceived) / 1000);
         }
         if (lastHeartbeatReceived > 0) {
-            unsigned long heartbeatAge = (millis() - lastHeartbeatReceived) / 1000;
-            Serial.printf("Last heartbeat: %lu seconds ago", heartbeatAge);
-            if (heartbeatAge > HEARTBEAT_TIMEOUT / 1000) {
+            Serial.printf("Last heartbeat: %lu ms ago", clockMillis() - lastHeartbeatReceived);
+            if (linkMonitor.isLost()) {
                 Serial.print(" (TIMEOUT - CONNECTION LOST)");
             }
             Serial.println();
         }
+        Serial.printf("Link monitor: %s, heartbeat %lu ms, timeout %lu ms\n",
+                     linkMonitor.isArmed() ? "armed" : "fallback",
+                     linkMonitor.getPeriod(), linkMonitor.getTimeout());
     } else {
         Serial.println("BLE: Disconnected");
-        Serial.printf("Reconnect attempts: %d/%d\n", reconnectAttempts, MAX_RECONNECT_ATTEMPTS);
+        Serial.printf("Reconnect attempts: %d (next backoff %lu ms)\n", 
+                     reconnectAttempts, nextReconnectDelay);
+    }
+    
+    if (linkMonitor.getLossEvents() > 0) {
+        Serial.printf("Link losses: %lu (false positives: %lu, %.1f%%)\n",
+                     linkMonitor.getLossEvents(), linkMonitor.getFalsePositives(),
+                     100.0 * linkMonitor.getFalsePositives() / linkMonitor.getLossEvents());
     }
     
-    Serial.printf("Messages received: %lu\n", totalMessagesReceived);
+    if (recoveryCount > 0) {
+        Serial.printf("Recovery: %lu links, last %lu ms, min/avg/max %lu/%lu/%lu ms\n",
+                     recoveryCount, lastRecoveryTime, minRecoveryTime,
+                     totalRecoveryTime / recoveryCount, maxRecoveryTime);
+    }
+    
+    Serial.printf("Messages received: %lu", totalMessagesReceived);
+    if (droppedFrames > 0) {
+        Serial.printf(" (%lu dropped - queue full)", droppedFrames);
+    }
+    Serial.println();
+    
+    unsigned long uptime = clockMillis() - systemStartTime;
+    if (uptime > 0) {
+        Serial.printf("Main loop: %lu wakeups (%.1f/s)\n", loopCount, loopCount * 1000.0 / uptime);
+    }
     Serial.printf("Connection attempts: %lu\n", totalConnectionAttempts);
+    Serial.printf("Persistence: %d pending, %lu queued, %lu coalesced, %lu NVS writes in %lu batches\n",
+                 persist.pendingCount(), persist.getQueued(), persist.getCoalesced(),
+                 persist.getWrites(), persist.getBatches());
+    if (otaReceiver.isReceiving() || otaReceiver.isComplete()) {
+        Serial.printf("Firmware update: %s, %d%% (%lu/%lu bytes), %lu CRC errors, %lu resumes\n",
+                     otaReceiver.isComplete() ? "installed" : "receiving", otaReceiver.getProgress(),
+                     (unsigned long)otaReceiver.getReceived(), (unsigned long)otaReceiver.getPayloadSize(),
+                     otaReceiver.getCrcErrors(), otaReceiver.getResumes());
+    }
+    if (droppedOtaChunks > 0) {
+        Serial.printf("Firmware chunks dropped: %lu (queue full, resent)\n", droppedOtaChunks);
+    }
+    if (cameraPixels.isEnabled() || talentPixels.isEnabled()) {
+        Serial.printf("LED strip frames: %lu sent, %lu unchanged skipped\n",
+                     cameraPixels.getFramesSent() + talentPixels.getFramesSent(),
+                     cameraPixels.getFramesSkipped() + talentPixels.getFramesSkipped());
+    }
+    if (ambient.isFitted()) {
+        Serial.printf("Ambient light: %u raw, %u filtered, brightness %d/255 (PROGRAM at least %d)\n",
+                     ambient.getRaw(), ambient.getLevel(), ambient.getScale(), AMBIENT_PROGRAM_FLOOR);
+    }
+    float ledCurrent = ambient.averageCurrent(clockMillis());
+    float fullCurrent = ambient.unscaledCurrent(clockMillis());
+    Serial.printf("LED current: %.1f mA average, %.1f mA without ambient scaling (%.0f%% saved)\n",
+                 ledCurrent, fullCurrent, fullCurrent > 0 ? (fullCurrent - ledCurrent) * 100 / fullCurrent : 0.0f);
     Serial.printf("Free heap: %d bytes\n", ESP.getFreeHeap());
     Serial.println("=================================\n");
 }
 
+// Collect a serial line without blocking - a partial line waits for the
+// next pass instead of stalling the loop for the stream timeout
+bool readSerialLine(String& line) {
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (c == '\n') {
+            line = serialLine;
+            serialLine = "";
+            return true;
+        }
+        if (serialLine.length() < SERIAL_LINE_MAX) {
+            serialLine += c;
+        }
+    }
+    return false;
+}
+
 // Handle serial commands for testing and debugging
 void handleSerialCommands() {
-    if (!Serial.available()) return;
+    String command;
+    if (!readSerialLine(command)) return;
     
-    String command = Serial.readStringUntil('\n');
     command.trim();
     command.toUpperCase();
     
@@ -642,10 +1293,14 @@ void handleSerialCommands() {
         printSystemStatus();
     }
     else if (command == "CONNECT") {
-        if (!connected) {
+        if (TALLY_PERIPHERAL) {
+            Serial.println(connected ? "Already connected" : "Advertising - waiting for the bridge to connect");
+        } else if (!connected) {
             Serial.println("Starting connection attempt...");
-            doScan = true;
+            reconnectBackoff.reset();
             reconnectAttempts = 0;
+            timers.stop(reconnectTimer);
+            doScan = true;
         } else {
             Serial.println("Already connected");
         }
@@ -653,7 +1308,7 @@ void handleSerialCommands() {
     else if (command == "DISCONNECT") {
         if (connected) {
             Serial.println("Disconnecting...");
-            pClient->disconnect();
+            disconnectFromBridge();
         } else {
             Serial.println("Not connected");
         }
@@ -668,40 +1323,13 @@ void handleSerialCommands() {
     }
     else if (command == "TEST") {
         Serial.println("LED Test Sequence:");
-        Serial.println("Red (PROGRAM)...");
-        setLEDColor(255, 0, 0);
-        delay(2000);
-        
-        Serial.println("Green (PREVIEW)...");
-        setLEDColor(0, 255, 0);
-        delay(2000);
-        
-        Serial.println("Blue (CONNECTED)...");
-        setLEDColor(0, 0, 255);
-        delay(2000);
-        
-        Serial.println("Yellow (NO ATEM)...");
-        setLEDColor(255, 255, 0);
-        delay(2000);
-        
-        Serial.println("Orange (CONNECTING)...");
-        setLEDColor(255, 128, 0);
-        delay(2000);
-        
-        Serial.println("Purple (ERROR)...");
-        setLEDColor(128, 0, 128);
-        delay(2000);
-        
-        Serial.println("Magenta (CONNECTION LOST)...");
-        setLEDColor(255, 0, 255);
-        delay(2000);
-        
-        Serial.println("Test complete - returning to normal operation");
-        updateTallyLED();
+        ledTestStep = -1;
+        stepLEDTest();
     }
     else if (command == "RESET") {
         Serial.println("Restarting ESP32...");
-        delay(1000);
+        Serial.flush();
+        persist.flush();
         ESP.restart();
     }
     else if (command == "HELP") {
@@ -735,12 +1363,16 @@ void setup() {
         Serial.println("==========================================");
     }
     
-    systemStartTime = millis();
+    systemStartTime = clockMillis();
     
     // Initialize LED pins
     pinMode(LED_RED_PIN, OUTPUT);
     pinMode(LED_GREEN_PIN, OUTPUT);
     pinMode(LED_BLUE_PIN, OUTPUT);
+    cameraPixels.begin(PIXEL_CAMERA_PIN, RMT_CHANNEL_0);
+    talentPixels.begin(PIXEL_TALENT_PIN, RMT_CHANNEL_1);
+    ambient.begin(AMBIENT_PIN, 1 + (cameraPixels.isEnabled() ? PIXEL_CAMERA_COUNT : 0) +
+                              (talentPixels.isEnabled() ? PIXEL_TALENT_COUNT : 0), clockMillis());
     
     // Initialize LEDs to off
     setLEDOff();
@@ -750,25 +1382,70 @@ void setup() {
         Serial.printf("Camera ID: %d\n", CAMERA_ID);
         Serial.printf("Bridge Service: %s\n", BRIDGE_SERVICE_UUID);
         Serial.printf("LED Pins: R=%d, G=%d, B=%d\n", LED_RED_PIN, LED_GREEN_PIN, LED_BLUE_PIN);
+        if (ambient.isFitted()) {
+            Serial.printf("Ambient Light: GPIO %d\n", AMBIENT_PIN);
+        }
+        Serial.printf("LED Strips: camera %s, talent %s\n",
+                     cameraPixels.isEnabled() ? String(PIXEL_CAMERA_COUNT).c_str() : "none",
+                     talentPixels.isEnabled() ? String(PIXEL_TALENT_COUNT).c_str() : "none");
         Serial.printf("Free Heap: %d bytes\n", ESP.getFreeHeap());
     }
     
-    // Initialize BLE
+    // Create scheduled work
+    initializeTimers();
+    
+    // Initialize BLE (request a larger MTU so the bridge can pack several frames per notification)
     BLEDevice::init(DEVICE_NAME);
+    BLEDevice::setMTU(TALLY_BLE_MTU);
+    scanFilter.begin(BRIDGE_SERVICE_UUID, nullptr);
+    gattCache.begin(queueBridgeFrames, queueOtaNotification, persist);
+    otaReceiver.begin(persist);
+    BLEDevice::setCustomGattcHandler(onGattcEvent);
     
     if (SERIAL_DEBUG) {
         Serial.println("\n✓ BLE initialized");
-        Serial.println("Searching for ATEM bridge...");
+        Serial.println(TALLY_PERIPHERAL ? "Advertising for ATEM bridge..." : "Searching for ATEM bridge...");
         Serial.println("==========================================\n");
     }
     
-    // Start initial scan
-    doScan = true;
-    lastHeartbeatLed = millis();
-    lastHeartbeatReceived = millis(); // Initialize heartbeat tracking
+    // Advertise for a central-role bridge, or start the initial scan
+    if (TALLY_PERIPHERAL) {
+        peripheral.begin(registrationMessage(), queueBridgeFrames, onPeripheralLink);
+    } else {
+        doScan = true;
+    }
+    lastHeartbeatReceived = clockMillis(); // Initialize heartbeat tracking
+    
 }
 
 void loop() {
+    loopCount++;
+    
+    // Apply frames from the bridge first - lowest on-air latency
+    processPendingFrames();
+    
+    // Firmware update chunks (flash writes) after the tally
+    processOtaChunks();
+    
+    // Settings reach NVS once switching has paused
+    persist.service(clockMillis(), lastTallyTraffic);
+    
+    // Run due scheduled work (reconnection, link checks, LED effects)
+    timers.advance();
+    
+    // Handle serial commands
+    if (SERIAL_DEBUG) {
+        handleSerialCommands();
+    }
+    
+    // Scan over: connect to the bridge it found, or back off and scan again
+    if (scanning && (doConnect || scanTimedOut)) {
+        finishBLEScan();
+        if (!doConnect && !connected) {
+            scheduleReconnect();
+        }
+    }
+    
     // Handle BLE connection logic
     if (doConnect) {
         if (connectToServer()) {
@@ -780,28 +1457,27 @@ void loop() {
                 Serial.println("✗ Connection failed");
             }
             currentState = STATE_ERROR;
+            scheduleReconnect();
         }
         doConnect = false;
     }
     
-    // Start BLE scan if needed
+    // Start a BLE scan if needed (runs in the background for up to SCAN_TIME)
     if (doScan) {
-        startBLEScan();
         doScan = false;
+        if (!scanning && !connected) {
+            startBLEScan();
+        }
+        if (!scanning && !connected) {
+            scheduleReconnect(); // Scan did not start - try again later
+        }
     }
     
-    // Handle connection management
-    handleConnection();
-    
-    // Update LED display
+    // Apply any state change made this pass to the LED
     updateTallyLED();
-    handleHeartbeatLED();
-    
-    // Handle serial commands
-    if (SERIAL_DEBUG) {
-        handleSerialCommands();
-    }
     
-    // Small delay for system stability
-    delay(50);
+    // Sleep until there is work: frame, BLE event, serial input or the next
+    // timer / LED-effect deadline
+    TickType_t wait = pdMS_TO_TICKS(timers.msUntilNext(LOOP_IDLE_TIMEOUT));
+    xEventGroupWaitBits(loopEvents, LOOP_EVENT_ALL, pdTRUE, pdFALSE, wait);
 }
@@ -10,8 +10,11 @@
  * - Secure BLE with automatic pairing and encryption
  * - Individual device registration with unique name and camera ID
  * - RGB LED status indication with brightness control
- * - Auto-reconnection with exponential backoff
+ * - Auto-reconnection with immediate first retry and jittered exponential backoff
+ * - Event-driven main loop: sleeps until a frame, BLE event, serial input or
+ *   LED-effect/timer deadline - no fixed polling delay
  * - Message integrity verification with checksums
+ * - Sub-second link-loss detection (missed heartbeats + BLE supervision timeout)
  * - Status monitoring and debugging via Serial
  * - Low power consumption in standby mode
  * - Support for 20 camera inputs with full state tracking
@@ -54,6 +57,20 @@
 #include <BLEUtils.h>
 #include <BLEScan.h>
 #include <BLEAdvertisedDevice.h>
+#include <esp_gap_ble_api.h>
+#include <freertos/event_groups.h>
+#include "ReconnectBackoff.h"
+#include "LinkMonitor.h"
+#include "TallyClock.h"
+#include "TimerWheel.h"
+#include "TallyProtocol.h"
+#include "TallyPixels.h"
+#include "AmbientBrightness.h"
+#include "TallyOtaReceiver.h"
+#include "TallyPeripheral.h"
+#include "TallyScanFilter.h"
+#include "TallyGattCache.h"
+#include "PersistQueue.h"
 
 // ===============================================
 // CONFIGURATION - UPDATE THESE VALUES
@@ -68,18 +85,40 @@
 #define GREEN_LED_PIN 26                    // GPIO pin for GREEN LED  
 #define BLUE_LED_PIN 27                     // GPIO pin for BLUE LED
 
+// Addressable LED strips (WS2812-style, same state as the RGB LED)
+#define PIXEL_CAMERA_PIN -1                 // Camera-top strip data pin (-1 = not fitted)
+#define PIXEL_CAMERA_COUNT 8                // Camera-top strip pixels
+#define PIXEL_TALENT_PIN -1                 // Talent-facing strip data pin (-1 = not fitted)
+#define PIXEL_TALENT_COUNT 16               // Talent-facing strip pixels
+
 // BLE Configuration (must match bridge configuration)
 #define BLE_SERVER_NAME "ATEM_Bridge_BLE"  // Name of the bridge to connect to
 #define SERVICE_UUID "12345678-1234-5678-9abc-123456789abc"
 #define CHARACTERISTIC_UUID "87654321-4321-8765-cba9-987654321cba"
+#define SNAPSHOT_UUID "87654321-4321-8765-cba9-987654321cbb"
+#define OTA_UUID "87654321-4321-8765-cba9-987654321cbc"
+#define TALLY_PERIPHERAL false             // true = advertise and let a BRIDGE_CENTRAL bridge connect (no firmware updates)
 
 // System Configuration
-#define LED_BRIGHTNESS 255                  // LED brightness (0-255) - 255 for maximum visibility
+#define LED_BRIGHTNESS 255                  // LED brightness (0-255) - full scale of the ambient curve
+#define AMBIENT_PIN -1                      // Ambient light sensor ADC1 pin (-1 = not fitted, fixed brightness)
 #define LED_DIM_BRIGHTNESS 64              // Dimmed brightness for status indicators
-#define HEARTBEAT_TIMEOUT 15000            // Heartbeat timeout (ms) - disconnect if no heartbeat
-#define RECONNECT_INTERVAL 5000            // Base reconnection attempt interval (ms)
-#define MAX_RECONNECT_INTERVAL 30000       // Maximum reconnection interval (ms)
+#define LINK_LOSS_TIMEOUT 750              // Link-loss detection latency via missed heartbeats (ms)
+#define HEARTBEAT_MISS_LIMIT 3             // Missed heartbeats before link is declared lost
+#define HEARTBEAT_TIMEOUT 15000            // Fallback timeout if bridge ignores requested heartbeat period (ms)
+#define BLE_CONN_INTERVAL_MIN 6            // Preferred connection interval min (1.25ms units = 7.5ms)
+#define BLE_CONN_INTERVAL_MAX 12           // Preferred connection interval max (1.25ms units = 15ms)
+#define BLE_SUPERVISION_TIMEOUT 500        // BLE supervision timeout - dead radio link detection (ms, 100-32000)
+#define RECONNECT_INTERVAL 500             // Base backoff after the immediate first retry (ms)
+#define MAX_RECONNECT_INTERVAL 8000        // Maximum reconnection backoff (ms)
 #define STATUS_UPDATE_INTERVAL 10000       // Status print interval (ms)
+#define REGISTRATION_RETRY_INTERVAL 1000   // Retry after a failed registration write (ms)
+#define FRAME_QUEUE_LENGTH 24              // Frames buffered between BLE callback and main loop (two full notifications)
+#define OTA_QUEUE_LENGTH 8                 // Firmware update notifications buffered for the main loop
+#define OTA_RESTART_DELAY 2000             // Restart into new firmware this long after the update (ms, waits while on PROGRAM)
+#define LOOP_IDLE_TIMEOUT 1000             // Longest main loop sleep with no events or timers (ms)
+#define LED_TEST_STEP 1000                 // Time each color shows in the TEST_LED sequence (ms)
+#define SERIAL_LINE_MAX 128                // Longest serial command line kept
 
 // Power Management
 #define POWER_SAVE_MODE false              // Enable power saving features
@@ -89,16 +128,6 @@
 // DATA STRUCTURES
 // ===============================================
 
-// BLE tally message structure (must match bridge)
-typedef struct {
-    uint8_t cameraId;        // Camera number (1-20)
-    char state[12];          // "PREVIEW", "PROGRAM", "OFF", "STANDBY", "HEARTBEAT", "NO_ATEM"
-    uint32_t timestamp;      // Message timestamp for debugging
-    uint8_t bridgeId;        // Bridge identifier (for multiple bridges)
-    uint8_t bridgeStatus;    // Bridge status: 0=No ATEM, 1=ATEM Connected, 2=Heartbeat
-    uint8_t checksum;        // Simple checksum for data integrity
-} __attribute__((packed)) TallyMessage;
-
 // Connection states
 enum ConnectionState {
     DISCONNECTED,     // Not connected to bridge
@@ -108,6 +137,12 @@ enum ConnectionState {
     ERROR_STATE       // Error condition
 };
 
+// Firmware update notification handed from the BLE callback to the loop
+struct OtaNotification {
+    uint16_t length;
+    uint8_t data[TALLY_BLE_MTU - 3];
+};
+
 // ===============================================
 // GLOBAL VARIABLES
 // ===============================================
@@ -119,16 +154,57 @@ void updateLEDStatus();
 BLEClient* pClient = nullptr;
 BLERemoteService* pRemoteService = nullptr;
 BLERemoteCharacteristic* pRemoteCharacteristic = nullptr;
-BLEAdvertisedDevice* targetDevice = nullptr;
+BLERemoteCharacteristic* pOtaCharacteristic = nullptr;
+BLEAddress bridgeAddress("00:00:00:00:00:00");   // Bridge found by the last scan
+esp_ble_addr_type_t bridgeAddressType = BLE_ADDR_TYPE_PUBLIC;
+bool bridgeFound = false;
+bool scanning = false;              // Scan running in the background (loop keeps serving)
+bool scanTimedOut = false;          // Scan ran its full time without finding the bridge
 
 // Connection Management
 ConnectionState connectionState = DISCONNECTED;
 unsigned long lastHeartbeat = 0;
 unsigned long lastReconnectAttempt = 0;
-unsigned long currentReconnectInterval = RECONNECT_INTERVAL;
-unsigned long lastStatusUpdate = 0;
+unsigned long currentReconnectInterval = 0;
+ReconnectBackoff reconnectBackoff(RECONNECT_INTERVAL, MAX_RECONNECT_INTERVAL);
+LinkMonitor linkMonitor(LINK_LOSS_TIMEOUT / HEARTBEAT_MISS_LIMIT, HEARTBEAT_MISS_LIMIT, HEARTBEAT_TIMEOUT);
 bool deviceRegistered = false;
 
+// Firmware updates pushed by the bridge
+TallyOtaReceiver otaReceiver;
+
+// NVS writes (GATT handles, installed image) wait for a pause in switching
+PersistQueue persist;
+unsigned long lastTallyTraffic = 0;  // Last camera frame from the bridge
+
+// Advertising link for a central-role bridge (TALLY_PERIPHERAL)
+TallyPeripheral peripheral;
+
+// Scheduled work (reconnection, registration retry, link checks, LED effects,
+// LED flashes, status prints, OTA restart, light sensor)
+TimerWheel<8> timers;
+int8_t reconnectTimer = -1;
+int8_t registrationTimer = -1;
+int8_t linkCheckTimer = -1;
+int8_t ledEffectTimer = -1;
+int8_t statusTimer = -1;
+int8_t otaRestartTimer = -1;
+int8_t ambientTimer = -1;
+int8_t flashTimer = -1;
+
+// Main loop wake-up events and frame hand-off from the BLE callback
+#define LOOP_EVENT_FRAME   BIT0
+#define LOOP_EVENT_BLE     BIT1
+#define LOOP_EVENT_SERIAL  BIT2
+#define LOOP_EVENT_OTA     BIT3
+#define LOOP_EVENT_ALL     (LOOP_EVENT_FRAME | LOOP_EVENT_BLE | LOOP_EVENT_SERIAL | LOOP_EVENT_OTA)
+EventGroupHandle_t loopEvents = nullptr;
+QueueHandle_t frameQueue = nullptr;
+QueueHandle_t otaQueue = nullptr;
+unsigned long droppedFrames = 0;
+unsigned long droppedOtaChunks = 0;
+unsigned long loopCount = 0;
+
 // Tally State
 String currentTallyState = "OFF";
 String bridgeStatus = "UNKNOWN";
@@ -136,10 +212,34 @@ unsigned long lastStateChange = 0;
 unsigned long totalMessagesReceived = 0;
 unsigned long systemStartTime = 0;
 
+// Tally state from the bridge's advert, shown while connecting
+TallyAdvertisement bridgeAdvert;
+bool bridgeAdvertReceived = false;  // Set by the scan callback
+bool advertStateShown = false;      // Tally state came from the advert
+TallyScanFilter scanFilter;         // Finds the bridge by name in raw adverts
+TallyGattCache gattCache;           // Bridge handles - reconnects skip discovery
+unsigned long lastSyncTime = 0;     // Connect to subscribed + snapshot (ms)
+
+// Time-to-recover statistics (link loss -> first valid message)
+unsigned long linkLostAt = 0;
+unsigned long recoveryCount = 0;
+unsigned long lastRecoveryTime = 0;
+unsigned long minRecoveryTime = 0;
+unsigned long maxRecoveryTime = 0;
+unsigned long totalRecoveryTime = 0;
+
 // LED Control
 unsigned long lastLEDUpdate = 0;
 bool ledPulseState = false;
 int pulsePhase = 0;
+unsigned long ledEffectPeriod = 0;
+bool flashActive = false;           // Flash color shown over the status until the flash timer
+uint8_t flashRed = 0, flashGreen = 0, flashBlue = 0;
+int8_t ledTestStep = -1;            // TEST_LED sequence position (-1 = not running)
+String serialLine;                  // Serial command being received
+TallyPixels<PIXEL_CAMERA_COUNT> cameraPixels;
+TallyPixels<PIXEL_TALENT_COUNT> talentPixels;
+AmbientBrightness ambient;          // Room light scaling and LED current
 
 // ===============================================
 // LED FUNCTIONS
@@ -152,10 +252,24 @@ void setLED(uint8_t red, uint8_t green, uint8_t blue, uint8_t brightness = LED_B
     green = (green * brightness) / 255;
     blue = (blue * brightness) / 255;
     
+    // Then the room's light level - PROGRAM keeps its floor
+    bool program = (currentTallyState == "PROGRAM");
+    uint16_t requested = red + green + blue;
+    red = ambient.apply(red, program);
+    green = ambient.apply(green, program);
+    blue = ambient.apply(blue, program);
+    ambient.recordOutput(clockMillis(), red + green + blue, requested);
+    
     // Set LED pins
     analogWrite(RED_LED_PIN, red);
     analogWrite(GREEN_LED_PIN, green);
     analogWrite(BLUE_LED_PIN, blue);
+    
+    // Strips are re-sent only when the color changes
+    cameraPixels.fill(red, green, blue);
+    cameraPixels.show();
+    talentPixels.fill(red, green, blue);
+    talentPixels.show();
 }
 
 // Turn off all LEDs
@@ -163,21 +277,100 @@ void clearLED() {
     setLED(0, 0, 0);
 }
 
-// Flash LED briefly for feedback
-void flashLED(uint8_t red, uint8_t green, uint8_t blue, int duration = 100) {
+// Show a color over the status for duration ms - the flash timer returns
+// the LED to the current status
+void showFlash(uint8_t red, uint8_t green, uint8_t blue, unsigned long duration) {
+    flashRed = red;
+    flashGreen = green;
+    flashBlue = blue;
+    flashActive = true;
+    timers.start(flashTimer, duration);
     setLED(red, green, blue, LED_BRIGHTNESS);
-    delay(duration);
-    updateLEDStatus(); // Return to current status
+}
+
+// Flash LED briefly for feedback (TEST_LED owns the LED while it runs)
+void flashLED(uint8_t red, uint8_t green, uint8_t blue, unsigned long duration = 100) {
+    if (ledTestStep >= 0) return;
+    showFlash(red, green, blue, duration);
+}
+
+// Blink/pulse period of the tally state pattern
+unsigned long tallyEffectPeriod() {
+    if (bridgeStatus == "NO_ATEM") return 2000;
+    if (currentTallyState == "HEARTBEAT") return 100;
+    return 0;
+}
+
+// Blink/pulse period of the current LED pattern (0 = solid, no refresh needed)
+unsigned long currentLEDEffectPeriod() {
+    switch (connectionState) {
+        case DISCONNECTED: return 1000;
+        case SCANNING:     return 200;
+        case CONNECTING:   return advertStateShown ? tallyEffectPeriod() : 300;
+        case ERROR_STATE:  return 250;
+        case CONNECTED:
+            if (linkMonitor.isLost()) return 500;
+            return tallyEffectPeriod();
+    }
+    return 0;
+}
+
+// Keep the LED effect timer running only while the current pattern animates
+void scheduleLEDEffect() {
+    unsigned long period = currentLEDEffectPeriod();
+    if (period == 0) {
+        timers.stop(ledEffectTimer);
+    } else if (period != ledEffectPeriod || !timers.isPending(ledEffectTimer)) {
+        timers.start(ledEffectTimer, period, period);
+    }
+    ledEffectPeriod = period;
+}
+
+// Show the camera's tally state (or the bridge's missing ATEM)
+void showTallyState(unsigned long currentTime) {
+    if (bridgeStatus == "NO_ATEM") {
+        // Yellow slow pulse - connected but bridge has no ATEM
+        if (currentTime - lastLEDUpdate >= 2000) {
+            ledPulseState = !ledPulseState;
+            setLED(255, 255, 0, ledPulseState ? LED_BRIGHTNESS : LED_DIM_BRIGHTNESS);
+            lastLEDUpdate = currentTime;
+        }
+    } else if (currentTallyState == "PROGRAM") {
+        // Red solid - camera is live
+        setLED(255, 0, 0, LED_BRIGHTNESS);
+    } else if (currentTallyState == "PREVIEW" || currentTallyState == "STANDBY") {
+        // Green solid - camera is in preview or standby
+        setLED(0, 255, 0, LED_BRIGHTNESS);
+    } else if (currentTallyState == "HEARTBEAT") {
+        // Blue gentle pulse - connected and receiving heartbeats
+        if (currentTime - lastLEDUpdate >= 100) {
+            pulsePhase = (pulsePhase + 5) % 360;
+            int brightness = LED_DIM_BRIGHTNESS + (int)((LED_BRIGHTNESS - LED_DIM_BRIGHTNESS) * 
+                           (1 + sin(pulsePhase * PI / 180)) / 2);
+            setLED(0, 0, 255, brightness);
+            lastLEDUpdate = currentTime;
+        }
+    } else if (currentTallyState == "OFF") {
+        // Off - camera not active
+        clearLED();
+    }
 }
 
 // Update LED based on current system state
 void updateLEDStatus() {
-    unsigned long currentTime = millis();
+    unsigned long currentTime = clockMillis();
+    scheduleLEDEffect();
+    
+    // A flash holds the LED until its timer ends it
+    if (flashActive) {
+        setLED(flashRed, flashGreen, flashBlue, LED_BRIGHTNESS);
+        return;
+    }
     
     switch (connectionState) {
         case DISCONNECTED:
             // Orange slow blink - searching for bridge
-            if (currentTime - lastLEDUpdate > 1000) {
+            if (currentTime - lastLEDUpdate >= 1000) {
                 ledPulseState = !ledPulseState;
                 setLED(255, 165, 0, ledPulseState ? LED_DIM_BRIGHTNESS : 0); // Orange
                 lastLEDUpdate = currentTime;
@@ -186,7 +379,7 @@ void updateLEDStatus() {
             
         case SCANNING:
             // Orange fast blink - scanning
-            if (currentTime - lastLEDUpdate > 200) {
+            if (currentTime - lastLEDUpdate >= 200) {
                 ledPulseState = !ledPulseState;
                 setLED(255, 165, 0, ledPulseState ? LED_BRIGHTNESS : 0); // Orange fast
                 lastLEDUpdate = currentTime;
@@ -194,8 +387,13 @@ void updateLEDStatus() {
             break;
             
         case CONNECTING:
+            if (advertStateShown) {
+                // Tally state from the bridge's advert until the connection confirms it
+                showTallyState(currentTime);
+                break;
+            }
             // Yellow pulse - connecting
-            if (currentTime - lastLEDUpdate > 300) {
+            if (currentTime - lastLEDUpdate >= 300) {
                 ledPulseState = !ledPulseState;
                 setLED(255, 255, 0, ledPulseState ? LED_BRIGHTNESS : LED_DIM_BRIGHTNESS); // Yellow
                 lastLEDUpdate = currentTime;
@@ -204,47 +402,21 @@ void updateLEDStatus() {
             
         case CONNECTED:
             // Display tally state or connection status
-            if (bridgeStatus == "NO_ATEM") {
-                // Yellow slow pulse - connected but bridge has no ATEM
-                if (currentTime - lastLEDUpdate > 2000) {
+            if (linkMonitor.isLost()) {
+                // Magenta blink - missed heartbeats, never show stale on-air state
+                if (currentTime - lastLEDUpdate >= 500) {
                     ledPulseState = !ledPulseState;
-                    setLED(255, 255, 0, ledPulseState ? LED_BRIGHTNESS : LED_DIM_BRIGHTNESS);
-                    lastLEDUpdate = currentTime;
-                }
-            } else if (currentTallyState == "PROGRAM") {
-                // Red solid - camera is live
-                setLED(255, 0, 0, LED_BRIGHTNESS);
-            } else if (currentTallyState == "PREVIEW" || currentTallyState == "STANDBY") {
-                // Green solid - camera is in preview or standby
-                setLED(0, 255, 0, LED_BRIGHTNESS);
-            } else if (currentTallyState == "HEARTBEAT") {
-                // Blue gentle pulse - connected and receiving heartbeats
-                if (currentTime - lastLEDUpdate > 100) {
-                    pulsePhase = (pulsePhase + 5) % 360;
-                    int brightness = LED_DIM_BRIGHTNESS + (int)((LED_BRIGHTNESS - LED_DIM_BRIGHTNESS) * 
-                                   (1 + sin(pulsePhase * PI / 180)) / 2);
-                    setLED(0, 0, 255, brightness);
+                    setLED(255, 0, 255, ledPulseState ? LED_BRIGHTNESS : 0); // Magenta
                     lastLEDUpdate = currentTime;
                 }
-            } else if (currentTallyState == "OFF") {
-                // Check if we've lost heartbeat
-                if (currentTime - lastHeartbeat > HEARTBEAT_TIMEOUT) {
-                    // Magenta blink - no heartbeat
-                    if (currentTime - lastLEDUpdate > 500) {
-                        ledPulseState = !ledPulseState;
-                        setLED(255, 0, 255, ledPulseState ? LED_BRIGHTNESS : 0); // Magenta
-                        lastLEDUpdate = currentTime;
-                    }
-                } else {
-                    // Off - camera not active
-                    clearLED();
-                }
+            } else {
+                showTallyState(currentTime);
             }
             break;
             
         case ERROR_STATE:
             // Purple blink - error
-            if (currentTime - lastLEDUpdate > 250) {
+            if (currentTime - lastLEDUpdate >= 250) {
                 ledPulseState = !ledPulseState;
                 setLED(128, 0, 128, ledPulseState ? LED_BRIGHTNESS : 0); // Purple
                 lastLEDUpdate = currentTime;
@@ -257,58 +429,155 @@ void updateLEDStatus() {
 // BLE FUNCTIONS
 // ===============================================
 
-// Calculate simple checksum for message integrity
-uint8_t calculateChecksum(TallyMessage* msg) {
-    uint8_t checksum = 0;
-    checksum ^= msg->cameraId;
-    checksum ^= msg->bridgeId;
-    checksum ^= msg->bridgeStatus;
-    for (int i = 0; i < strlen(msg->state); i++) {
-        checksum ^= msg->state[i];
+// Verify message integrity
+bool verifyMessage(TallyMessage* msg) {
+    return verifyTallyMessage(msg);
+}
+
+// Schedule the next reconnection attempt using jittered backoff
+void scheduleReconnect() {
+    currentReconnectInterval = reconnectBackoff.nextDelay();
+    lastReconnectAttempt = clockMillis();
+    timers.start(reconnectTimer, currentReconnectInterval);
+}
+
+// Reset reconnection backoff and record time-to-recover after a link loss
+void recordSync() {
+    reconnectBackoff.reset();
+    
+    if (linkLostAt > 0) {
+        lastRecoveryTime = clockMillis() - linkLostAt;
+        linkLostAt = 0;
+        
+        if (recoveryCount == 0 || lastRecoveryTime < minRecoveryTime) {
+            minRecoveryTime = lastRecoveryTime;
+        }
+        if (lastRecoveryTime > maxRecoveryTime) {
+            maxRecoveryTime = lastRecoveryTime;
+        }
+        totalRecoveryTime += lastRecoveryTime;
+        recoveryCount++;
+        
+        Serial.printf("✓ Link recovered in %lu ms\n", lastRecoveryTime);
     }
-    return checksum;
 }
 
-// Verify message integrity
-bool verifyMessage(TallyMessage* msg) {
-    uint8_t calculatedChecksum = calculateChecksum(msg);
-    return (calculatedChecksum == msg->checksum);
+// Link to the bridge up (BLE task)
+void onBridgeConnected() {
+    Serial.println("✓ Connected to bridge");
+    connectionState = CONNECTED;
+    linkMonitor.begin(clockMillis());
+    timers.start(linkCheckTimer, linkMonitor.getTimeout() + 1);
+    xEventGroupSetBits(loopEvents, LOOP_EVENT_BLE);
+}
+
+// Link to the bridge dropped (BLE task)
+void onBridgeDisconnected() {
+    Serial.println("✗ Disconnected from bridge");
+    
+    // Start reconnection process (first retry is immediate) unless the
+    // heartbeat timeout already scheduled it - a peripheral tally just keeps
+    // advertising
+    if (connectionState != DISCONNECTED) {
+        if (linkLostAt == 0) {
+            linkLostAt = clockMillis();
+        }
+        if (!TALLY_PERIPHERAL) {
+            scheduleReconnect();
+        }
+    }
+    
+    connectionState = DISCONNECTED;
+    deviceRegistered = false;
+    advertStateShown = false;
+    bridgeStatus = "DISCONNECTED";
+    currentTallyState = "OFF";
+    timers.stop(linkCheckTimer);
+    timers.stop(registrationTimer);
+    xEventGroupSetBits(loopEvents, LOOP_EVENT_BLE);
 }
 
 // BLE Client Callbacks
 class MyClientCallback : public BLEClientCallbacks {
     void onConnect(BLEClient* pclient) {
-        Serial.println("✓ Connected to bridge");
-        connectionState = CONNECTED;
-        currentReconnectInterval = RECONNECT_INTERVAL; // Reset backoff
+        onBridgeConnected();
     }
 
     void onDisconnect(BLEClient* pclient) {
-        Serial.println("✗ Disconnected from bridge");
-        connectionState = DISCONNECTED;
-        deviceRegistered = false;
-        bridgeStatus = "DISCONNECTED";
-        currentTallyState = "OFF";
-        
-        // Start reconnection process
-        lastReconnectAttempt = millis();
+        gattCache.detach();
+        onBridgeDisconnected();
     }
 };
 
-// Notification callback for receiving tally data
-static void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
-                          uint8_t* pData, size_t length, bool isNotify) {
-    
-    // Verify message size
-    if (length != sizeof(TallyMessage)) {
-        Serial.printf("Invalid message size: %d (expected %d)\n", length, sizeof(TallyMessage));
-        flashLED(128, 0, 128); // Purple flash for error
+// Central-role bridge connected or dropped (TALLY_PERIPHERAL) - the bridge
+// reads the registration characteristic itself, so no write is needed
+void onPeripheralLink(bool up) {
+    if (up) {
+        onBridgeConnected();
+        deviceRegistered = true;
+    } else {
+        onBridgeDisconnected();
+    }
+}
+
+// Tally data from the bridge - frames are handed to the main loop so LED
+// work (including flashes) never blocks the BLE stack
+static void queueBridgeFrames(const uint8_t* pData, size_t length) {
+    // Split into frames - one bare frame or a packed container of several
+    TallyMessage frames[TALLY_MAX_BATCH_FRAMES];
+    int count = unpackTallyFrames(pData, length, frames, TALLY_MAX_BATCH_FRAMES);
+    if (count == 0) {
+        Serial.printf("Invalid message size: %d (expected %d or a frame container)\n", length, sizeof(TallyMessage));
         return;
     }
     
-    // Parse message
-    TallyMessage* msg = (TallyMessage*)pData;
+    for (int i = 0; i < count; i++) {
+        if (xQueueSend(frameQueue, &frames[i], 0) != pdTRUE) {
+            droppedFrames++;
+        }
+    }
+    xEventGroupSetBits(loopEvents, LOOP_EVENT_FRAME);
+}
+
+// Notification callback for receiving tally data
+static void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
+                                     uint8_t* pData, size_t length, bool isNotify) {
+    queueBridgeFrames(pData, length);
+}
+
+// Firmware update notification - flash writes happen in the main loop. A
+// dropped chunk is resent once the bridge sees the gap.
+static void queueOtaNotification(const uint8_t* pData, size_t length) {
+    OtaNotification notification;
+    if (length > sizeof(notification.data)) return;
     
+    notification.length = length;
+    memcpy(notification.data, pData, length);
+    if (xQueueSend(otaQueue, &notification, 0) != pdTRUE) {
+        droppedOtaChunks++;
+    }
+    xEventGroupSetBits(loopEvents, LOOP_EVENT_OTA);
+}
+
+static void otaNotifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
+                             uint8_t* pData, size_t length, bool isNotify) {
+    queueOtaNotification(pData, length);
+}
+
+// GATT client events - notifications on a link set up from cached handles
+static void onGattcEvent(esp_gattc_cb_event_t event, esp_gatt_if_t gattcIf, esp_ble_gattc_cb_param_t* param) {
+    gattCache.onGattcEvent(event, gattcIf, param);
+}
+
+// Bridge status name from TALLY_BRIDGE_* bits. ATEM_RESUMING keeps the last
+// known tally state on the LED while the bridge gets its ATEM session back.
+String bridgeStatusName(uint8_t status) {
+    if (!(status & TALLY_BRIDGE_ATEM)) return "NO_ATEM";
+    return (status & TALLY_BRIDGE_UNCONFIRMED) ? "ATEM_RESUMING" : "ATEM_OK";
+}
+
+// Process a tally frame from the bridge (main loop)
+void processTallyMessage(TallyMessage* msg) {
     // Verify message integrity
     if (!verifyMessage(msg)) {
         Serial.println("Message checksum failed");
@@ -316,36 +585,47 @@ static void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
         return;
     }
     
-    // Flash white to indicate data received
-    flashLED(255, 255, 255, 50);
-    
     totalMessagesReceived++;
-    lastHeartbeat = millis();
+    lastHeartbeat = clockMillis();
+    recordSync();
+    
+    // Every valid frame keeps the link alive - the bridge skips heartbeats
+    // while camera frames flow - and heartbeats also arm loss detection
+    linkMonitor.onMessage(msg->cameraId, lastHeartbeat);
+    
+    // Camera frames mean the switcher is cutting - NVS writes wait
+    if (msg->cameraId != 0) {
+        lastTallyTraffic = lastHeartbeat;
+    }
     
     // Handle different message types
     if (msg->cameraId == 0) {
-        // Heartbeat/status message
-        bridgeStatus = String(msg->state);
-        currentTallyState = "HEARTBEAT";
-        
-        Serial.printf("Heartbeat received - Bridge: %s, ATEM: %s\n", 
-                     msg->state, msg->bridgeStatus ? "Connected" : "Disconnected");
+        // Heartbeat/status message - arrives several times a second, so only
+        // log bridge status changes and never overwrite an active tally state
+        String newBridgeStatus = bridgeStatusName(msg->bridgeStatus);
+        if (newBridgeStatus != bridgeStatus) {
+            Serial.printf("Heartbeat received - Bridge: %s, ATEM: %s\n", 
+                         msg->state, newBridgeStatus.c_str());
+            bridgeStatus = newBridgeStatus;
+        }
+        if (currentTallyState == "OFF") {
+            currentTallyState = "HEARTBEAT";
+        }
     } else if (msg->cameraId == CAMERA_ID) {
+        // Flash white to indicate data received
+        flashLED(255, 255, 255, 50);
+        
         // Tally state for this camera
         String newState = String(msg->state);
         if (newState != currentTallyState) {
             Serial.printf("Tally state change: CAM%d %s -> %s\n", 
                          CAMERA_ID, currentTallyState.c_str(), newState.c_str());
             currentTallyState = newState;
-            lastStateChange = millis();
+            lastStateChange = clockMillis();
         }
         
         // Update bridge status
-        if (msg->bridgeStatus == 0) {
-            bridgeStatus = "NO_ATEM";
-        } else {
-            bridgeStatus = "ATEM_OK";
-        }
+        bridgeStatus = bridgeStatusName(msg->bridgeStatus);
     }
     
     // Update LED immediately after receiving valid message
@@ -355,86 +635,217 @@ static void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
 // Device scan callback
 class MyAdvertisedDeviceCallbacks: public BLEAdvertisedDeviceCallbacks {
     void onResult(BLEAdvertisedDevice advertisedDevice) {
-        if (advertisedDevice.getName() == BLE_SERVER_NAME) {
+        // Raw payload check - strangers' adverts are not parsed or logged
+        // (the library has already copied each result into advertisedDevice)
+        const uint8_t* payload = advertisedDevice.getPayload();
+        size_t length = advertisedDevice.getPayloadLength();
+        if (scanFilter.matches(payload, length)) {
             Serial.printf("Found target device: %s\n", BLE_SERVER_NAME);
+            
+            // Tally state from the scan response (applied once the scan returns)
+            uint8_t dataLength = 0;
+            const uint8_t* data = TallyScanFilter::findField(payload, length, TALLY_AD_MANUFACTURER, dataLength);
+            bridgeAdvertReceived = (data != nullptr) && decodeTallyAdvertisement(data, dataLength, &bridgeAdvert);
+            
+            // Keep the address only - the result itself goes with clearResults()
             BLEDevice::getScan()->stop();
-            targetDevice = new BLEAdvertisedDevice(advertisedDevice);
+            bridgeAddress = advertisedDevice.getAddress();
+            bridgeAddressType = advertisedDevice.getAddressType();
+            bridgeFound = true;
             connectionState = CONNECTING;
+            xEventGroupSetBits(loopEvents, LOOP_EVENT_BLE);
         }
     }
 };
 
+MyAdvertisedDeviceCallbacks scanCallbacks;
+
 // Initialize BLE client
 bool initializeBLE() {
     Serial.printf("Initializing BLE client: %s (CAM%d)\n", DEVICE_NAME, CAMERA_ID);
     
-    // Initialize BLE device
+    // Initialize BLE device (request a larger MTU so the bridge can pack several frames per notification)
     BLEDevice::init(DEVICE_NAME);
+    BLEDevice::setMTU(TALLY_BLE_MTU);
+    // The bridge's advert carries its service UUID but no name (the scan
+    // response holds the tally state); the name still matches older bridges
+    scanFilter.begin(SERVICE_UUID, BLE_SERVER_NAME);
+    gattCache.begin(queueBridgeFrames, queueOtaNotification, persist);
+    otaReceiver.begin(persist);
+    BLEDevice::setCustomGattcHandler(onGattcEvent);
     
     Serial.println("✓ BLE client initialized");
     return true;
 }
 
-// Scan for bridge device
+// Scan ran its full time (BLE task) - the loop backs off and scans again.
+// A scan stopped because the bridge was found does not end up here.
+void onScanComplete(BLEScanResults results) {
+    scanTimedOut = true;
+    xEventGroupSetBits(loopEvents, LOOP_EVENT_BLE);
+}
+
+// Scan for bridge device in the background; onResult() or onScanComplete()
+// wake the loop when it is over
 bool scanForBridge() {
     connectionState = SCANNING;
     
     Serial.printf("Scanning for bridge: %s\n", BLE_SERVER_NAME);
     
+    // Duplicate filter on, library parsing off (see TallyScanFilter.h)
     BLEScan* pBLEScan = BLEDevice::getScan();
-    pBLEScan->setAdvertisedDeviceCallbacks(new MyAdvertisedDeviceCallbacks());
+    pBLEScan->setAdvertisedDeviceCallbacks(&scanCallbacks, false, false);
     pBLEScan->setInterval(1349);
     pBLEScan->setWindow(449);
     pBLEScan->setActiveScan(true);
-    pBLEScan->start(10, false); // Scan for 10 seconds
+    scanning = pBLEScan->start(10, onScanComplete, false); // Scan for 10 seconds
+    return scanning;
+}
+
+// Show the on-air state from the bridge's advert while the connection is set
+// up - the snapshot and registration then confirm it
+void applyAdvertisement() {
+    advertStateShown = bridgeAdvertReceived;
+    if (!bridgeAdvertReceived) {
+        return;
+    }
+    bridgeAdvertReceived = false;
     
-    return (targetDevice != nullptr);
+    uint32_t cameraBit = 1UL << (CAMERA_ID - 1);
+    bridgeStatus = bridgeStatusName(bridgeAdvert.status); // TALLY_ADV_STATUS_* bits match TALLY_BRIDGE_*
+    if (bridgeAdvert.program & cameraBit) {
+        currentTallyState = "PROGRAM";
+    } else if (bridgeAdvert.preview & cameraBit) {
+        currentTallyState = "PREVIEW";
+    } else {
+        currentTallyState = "OFF";
+    }
+    
+    Serial.printf("Advert: CAM%d %s, %s (seq %d)\n", CAMERA_ID, currentTallyState.c_str(),
+                 bridgeStatus.c_str(), bridgeAdvert.sequence);
+    updateLEDStatus();
+}
+
+// Service layout from the bridge's advert - the GATT cache key (0 = not
+// advertised, handles are discovered and not cached)
+uint8_t advertisedGattLayout() {
+    return advertStateShown ? bridgeAdvert.gatt : 0;
+}
+
+// Show the bridge's snapshot of every camera
+void applySnapshot(const std::string& value) {
+    TallyMessage frames[TALLY_SNAPSHOT_MAX_FRAMES];
+    int count = unpackTallyFrames((const uint8_t*)value.data(), value.length(),
+                                  frames, TALLY_SNAPSHOT_MAX_FRAMES);
+    for (int i = 0; i < count; i++) {
+        processTallyMessage(&frames[i]);
+    }
+    Serial.printf("Snapshot: %d frames, state %s\n", count, currentTallyState.c_str());
+}
+
+// Find the characteristics, subscribe and read the snapshot (older bridges
+// have none), then remember the handles for the next connection
+bool discoverBridge() {
+    // Get the service
+    pRemoteService = pClient->getService(SERVICE_UUID);
+    if (pRemoteService == nullptr) {
+        Serial.println("Failed to find service");
+        return false;
+    }
+    
+    // Get the characteristic
+    pRemoteCharacteristic = pRemoteService->getCharacteristic(CHARACTERISTIC_UUID);
+    if (pRemoteCharacteristic == nullptr) {
+        Serial.println("Failed to find characteristic");
+        return false;
+    }
+    
+    // Register for notifications
+    if (pRemoteCharacteristic->canNotify()) {
+        pRemoteCharacteristic->registerForNotify(notifyCallback);
+        Serial.println("✓ Registered for notifications");
+    }
+    
+    // Firmware updates (older bridges have no OTA characteristic)
+    pOtaCharacteristic = pRemoteService->getCharacteristic(OTA_UUID);
+    if (pOtaCharacteristic != nullptr && pOtaCharacteristic->canNotify()) {
+        pOtaCharacteristic->registerForNotify(otaNotifyCallback);
+    } else {
+        pOtaCharacteristic = nullptr;
+    }
+    
+    BLERemoteCharacteristic* pSnapshot = pRemoteService->getCharacteristic(SNAPSHOT_UUID);
+    if (pSnapshot != nullptr && !pSnapshot->canRead()) {
+        pSnapshot = nullptr;
+    }
+    if (pSnapshot != nullptr) {
+        applySnapshot(pSnapshot->readValue());
+    }
+    
+    if (pRemoteCharacteristic->canNotify()) {
+        gattCache.store(bridgeAddress, advertisedGattLayout(), pRemoteCharacteristic, pSnapshot, pOtaCharacteristic);
+    }
+    return true;
+}
+
+// Subscribe and read the snapshot by the cached handles of a known bridge
+bool attachCachedHandles() {
+    if (!gattCache.has(bridgeAddress, advertisedGattLayout())) {
+        return false;
+    }
+    
+    std::string snapshot;
+    if (!gattCache.attach(pClient, snapshot)) {
+        Serial.println("Cached GATT handles rejected - discovering");
+        return false;
+    }
+    pRemoteService = nullptr;
+    pRemoteCharacteristic = nullptr;
+    pOtaCharacteristic = nullptr;
+    applySnapshot(snapshot);
+    return true;
 }
 
 // Connect to bridge
 bool connectToBridge() {
-    if (!targetDevice) {
+    if (!bridgeFound) {
         Serial.println("No target device found");
         return false;
     }
     
     Serial.println("Attempting to connect to bridge...");
     
+    // Show the advertised state until the connection confirms it
+    applyAdvertisement();
+    
     // Create BLE client
     pClient = BLEDevice::createClient();
     pClient->setClientCallbacks(new MyClientCallback());
     
+    // Short supervision timeout so the controller reports a dead link quickly
+    esp_ble_gap_set_prefer_conn_params(*bridgeAddress.getNative(),
+                                       BLE_CONN_INTERVAL_MIN, BLE_CONN_INTERVAL_MAX,
+                                       0, BLE_SUPERVISION_TIMEOUT / 10);
+    
     // Connect to the bridge
-    if (!pClient->connect(targetDevice)) {
+    if (!pClient->connect(bridgeAddress, bridgeAddressType)) {
         Serial.println("Failed to connect to bridge");
         delete pClient;
         pClient = nullptr;
         return false;
     }
     
-    Serial.println("Connected to bridge - getting service...");
+    Serial.printf("Connected to bridge (MTU %d) - getting service...\n", pClient->getMTU());
     
-    // Get the service
-    pRemoteService = pClient->getService(SERVICE_UUID);
-    if (pRemoteService == nullptr) {
-        Serial.println("Failed to find service");
-        pClient->disconnect();
-        return false;
-    }
-    
-    // Get the characteristic
-    pRemoteCharacteristic = pRemoteService->getCharacteristic(CHARACTERISTIC_UUID);
-    if (pRemoteCharacteristic == nullptr) {
-        Serial.println("Failed to find characteristic");
+    // Sync state before registering - by cached handle for a known bridge
+    unsigned long syncStart = clockMillis();
+    bool cached = attachCachedHandles();
+    if (!cached && !discoverBridge()) {
         pClient->disconnect();
         return false;
     }
-    
-    // Register for notifications
-    if (pRemoteCharacteristic->canNotify()) {
-        pRemoteCharacteristic->registerForNotify(notifyCallback);
-        Serial.println("✓ Registered for notifications");
-    }
+    lastSyncTime = clockMillis() - syncStart;
+    Serial.printf("✓ Synced in %lu ms (%s)\n", lastSyncTime, cached ? "cached handles" : "discovery");
     
     // Register with bridge
     registerWithBridge();
@@ -443,93 +854,272 @@ bool connectToBridge() {
     return true;
 }
 
+// Registration message: "TALLY_REG:camera_id:device_name:heartbeat_ms"
+String registrationMessage() {
+    return "TALLY_REG:" + String(CAMERA_ID) + ":" + String(DEVICE_NAME) + 
+           ":" + String(linkMonitor.getPeriod());
+}
+
 // Register this device with the bridge
 void registerWithBridge() {
-    if (!pRemoteCharacteristic || !pRemoteCharacteristic->canWrite()) {
+    bool cached = gattCache.isActive();
+    if (!cached && (!pRemoteCharacteristic || !pRemoteCharacteristic->canWrite())) {
         Serial.println("Cannot register - characteristic not writable");
         return;
     }
     
-    // Send registration message: "TALLY_REG:camera_id:device_name"
-    String regMessage = "TALLY_REG:" + String(CAMERA_ID) + ":" + String(DEVICE_NAME);
+    String regMessage = registrationMessage();
     
     Serial.printf("Registering with bridge: %s\n", regMessage.c_str());
     
-    pRemoteCharacteristic->writeValue(regMessage.c_str(), regMessage.length());
+    // The snapshot already synced state, so nothing waits on the reply; a
+    // failed write is retried from the registration timer
+    bool sent;
+    if (cached) {
+        sent = gattCache.writeFrames((const uint8_t*)regMessage.c_str(), regMessage.length()) == ESP_OK;
+    } else {
+        pRemoteCharacteristic->writeValue((uint8_t*)regMessage.c_str(), regMessage.length());
+        sent = pClient->isConnected();
+    }
+    if (!sent) {
+        Serial.println("✗ Registration write failed - will retry");
+        timers.start(registrationTimer, REGISTRATION_RETRY_INTERVAL);
+        return;
+    }
     deviceRegistered = true;
+    timers.stop(registrationTimer);
     
     Serial.printf("✓ Registered as CAM%d (%s)\n", CAMERA_ID, DEVICE_NAME);
 }
 
-// Main connection handler
-void handleConnection() {
-    unsigned long currentTime = millis();
+// Retry a failed registration (registration timer callback)
+void retryRegistration(int) {
+    if (connectionState == CONNECTED && !deviceRegistered) {
+        registerWithBridge();
+    }
+}
+
+// Scan over (loop): connect to the bridge it found, or back off and scan again
+void finishScan() {
+    scanning = false;
+    scanTimedOut = false;
+    BLEDevice::getScan()->clearResults(); // Release the results the library kept
     
-    switch (connectionState) {
-        case DISCONNECTED:
-            // Attempt reconnection with exponential backoff
-            if (currentTime - lastReconnectAttempt >= currentReconnectInterval) {
-                Serial.println("Attempting to reconnect...");
-                
-                // Clean up previous connection
-                if (pClient) {
-                    pClient->disconnect();
-                    delete pClient;
-                    pClient = nullptr;
-                }
-                
-                pRemoteService = nullptr;
-                pRemoteCharacteristic = nullptr;
-                targetDevice = nullptr;
-                deviceRegistered = false;
-                
-                // Start scanning
-                if (scanForBridge()) {
-                    if (connectToBridge()) {
-                        Serial.println("✓ Reconnected successfully");
-                        currentReconnectInterval = RECONNECT_INTERVAL;
-                    } else {
-                        connectionState = DISCONNECTED;
-                        // Exponential backoff
-                        currentReconnectInterval = min(currentReconnectInterval * 2, 
-                                                     (unsigned long)MAX_RECONNECT_INTERVAL);
-                    }
-                } else {
-                    connectionState = DISCONNECTED;
-                    currentReconnectInterval = min(currentReconnectInterval * 2, 
-                                                 (unsigned long)MAX_RECONNECT_INTERVAL);
-                }
-                
-                lastReconnectAttempt = currentTime;
-            }
-            break;
-            
-        case CONNECTED:
-            // Check for heartbeat timeout
-            if (currentTime - lastHeartbeat > HEARTBEAT_TIMEOUT) {
-                Serial.println("Heartbeat timeout - disconnecting");
-                if (pClient && pClient->isConnected()) {
-                    pClient->disconnect();
-                }
-                connectionState = DISCONNECTED;
-            }
-            break;
-            
-        default:
-            // Handle other states as needed
-            break;
+    if (connectToBridge()) {
+        Serial.println("✓ Reconnected successfully");
+    } else {
+        connectionState = DISCONNECTED;
+        // Jittered exponential backoff
+        scheduleReconnect();
+    }
+}
+
+// Reconnection attempt (reconnect timer callback, armed with the backoff delay)
+void attemptReconnect(int) {
+    if (TALLY_PERIPHERAL || connectionState != DISCONNECTED || scanning) return;
+    
+    Serial.println("Attempting to reconnect...");
+    
+    // Clean up previous connection
+    if (pClient) {
+        pClient->disconnect();
+        delete pClient;
+        pClient = nullptr;
     }
+    
+    pRemoteService = nullptr;
+    pRemoteCharacteristic = nullptr;
+    bridgeFound = false;
+    deviceRegistered = false;
+    
+    // Start scanning - finishScan() connects or backs off (backoff resets
+    // once the bridge sends valid data)
+    if (!scanForBridge()) {
+        connectionState = DISCONNECTED;
+        scheduleReconnect();
+    }
+}
+
+// Drop the link to the bridge
+void disconnectFromBridge() {
+    if (TALLY_PERIPHERAL) {
+        peripheral.disconnect();
+    } else if (pClient && pClient->isConnected()) {
+        pClient->disconnect();
+    }
+}
+
+// Missed-heartbeat link-loss detection (link check timer callback)
+void checkLink(int) {
+    if (connectionState != CONNECTED) return;
+    
+    unsigned long currentTime = clockMillis();
+    bool wasLost = linkMonitor.isLost();
+    LinkStatus link = linkMonitor.update(currentTime);
+    
+    if (link == LINK_LOST && !wasLost) {
+        Serial.printf("✗ Link lost - no frames for %lu ms\n", 
+                     currentTime - linkMonitor.getLastFrame());
+        linkLostAt = currentTime;
+    } else if (link == LINK_DEAD) {
+        Serial.println("Link dead - disconnecting");
+        if (!TALLY_PERIPHERAL) {
+            scheduleReconnect();
+        }
+        connectionState = DISCONNECTED;
+        disconnectFromBridge();
+        return;
+    }
+    
+    // Check again just after the next possible state change
+    unsigned long silence = clockMillis() - linkMonitor.getLastFrame();
+    unsigned long limit = linkMonitor.getTimeout() + (linkMonitor.isLost() ? linkMonitor.getGrace() : 0);
+    timers.start(linkCheckTimer, (silence < limit) ? limit - silence + 1 : 1);
+}
+
+// Refresh blink/pulse effects (LED effect timer callback)
+void refreshLED(int) {
+    updateLEDStatus();
+}
+
+// TEST_LED colors, one every LED_TEST_STEP ms
+struct LEDTestColor {
+    const char* name;
+    uint8_t red, green, blue;
+};
+const LEDTestColor LED_TEST_SEQUENCE[] = {
+    { "Red", 255, 0, 0 },
+    { "Green", 0, 255, 0 },
+    { "Blue", 0, 0, 255 },
+    { "Off", 0, 0, 0 },
+};
+const int8_t LED_TEST_STEPS = sizeof(LED_TEST_SEQUENCE) / sizeof(LED_TEST_SEQUENCE[0]);
+
+// Show the next TEST_LED color, or hand the LED back to the status
+void stepLEDTest() {
+    ledTestStep++;
+    if (ledTestStep >= LED_TEST_STEPS) {
+        ledTestStep = -1;
+        Serial.println("LED test complete");
+        return;
+    }
+    const LEDTestColor& color = LED_TEST_SEQUENCE[ledTestStep];
+    Serial.printf("%s...\n", color.name);
+    showFlash(color.red, color.green, color.blue, LED_TEST_STEP);
+}
+
+// Flash over (flash timer callback) - the loop's LED update restores the status
+void endFlash(int) {
+    flashActive = false;
+    if (ledTestStep >= 0) {
+        stepLEDTest();
+    }
+}
+
+// Sample the light sensor (ambient timer) - the loop's LED update applies a
+// new brightness
+void sampleAmbient(int) {
+    ambient.update();
 }
 
 // ===============================================
 // SYSTEM FUNCTIONS
 // ===============================================
 
+// Print one-line status update (status timer callback)
+void printStatusLine(int) {
+    if (connectionState == CONNECTED) {
+        Serial.printf("Status: CAM%d %s | Bridge: %s | Heartbeat: %lus ago\n",
+                     CAMERA_ID, currentTallyState.c_str(), bridgeStatus.c_str(),
+                     (clockMillis() - lastHeartbeat) / 1000);
+    } else if (TALLY_PERIPHERAL) {
+        Serial.println("Status: DISCONNECTED | Advertising for bridge");
+    } else {
+        unsigned long sinceAttempt = clockMillis() - lastReconnectAttempt;
+        unsigned long reconnectIn = (sinceAttempt < currentReconnectInterval) ? 
+                                    currentReconnectInterval - sinceAttempt : 0;
+        Serial.printf("Status: %s | Reconnect in %lums\n",
+                     connectionState == DISCONNECTED ? "DISCONNECTED" : "CONNECTING",
+                     reconnectIn);
+    }
+}
+
+// Apply frames queued by the BLE notification callback
+void processPendingFrames() {
+    TallyMessage msg;
+    while (xQueueReceive(frameQueue, &msg, 0) == pdTRUE) {
+        processTallyMessage(&msg);
+    }
+}
+
+// Write firmware update notifications to flash and answer the bridge
+void processOtaChunks() {
+    OtaNotification notification;
+    while (xQueueReceive(otaQueue, &notification, 0) == pdTRUE) {
+        bool wasComplete = otaReceiver.isComplete();
+        TallyOtaReply reply;
+        size_t length = otaReceiver.handle(notification.data, notification.length, &reply);
+        if (length > 0 && pClient && pClient->isConnected()) {
+            if (gattCache.isActive()) {
+                gattCache.writeOta((const uint8_t*)&reply, length);
+            } else if (pOtaCharacteristic) {
+                pOtaCharacteristic->writeValue((uint8_t*)&reply, length, false);
+            }
+        }
+        
+        if (length > 0 && reply.type == TALLY_OTA_REJECT) {
+            Serial.printf("Firmware offer declined (reason %lu)\n", (unsigned long)reply.value);
+        }
+        if (otaReceiver.isComplete() && !wasComplete) {
+            Serial.println("✓ Firmware update installed - restarting when off PROGRAM");
+            timers.start(otaRestartTimer, OTA_RESTART_DELAY);
+        }
+    }
+}
+
+// Restart into updated firmware (OTA restart timer), never while on air
+void restartAfterUpdate(int) {
+    if (currentTallyState == "PROGRAM") {
+        timers.start(otaRestartTimer, OTA_RESTART_DELAY);
+        return;
+    }
+    Serial.println("Restarting into new firmware...");
+    Serial.flush();
+    persist.flush();
+    ESP.restart();
+}
+
+// Serial receive callback (runs on the UART event task)
+void onSerialReceive() {
+    xEventGroupSetBits(loopEvents, LOOP_EVENT_SERIAL);
+}
+
+// Create loop events and scheduled work (before BLE starts, since callbacks
+// arm timers and wake the loop)
+void initializeTimers() {
+    loopEvents = xEventGroupCreate();
+    frameQueue = xQueueCreate(FRAME_QUEUE_LENGTH, sizeof(TallyMessage));
+    otaQueue = xQueueCreate(OTA_QUEUE_LENGTH, sizeof(OtaNotification));
+    Serial.onReceive(onSerialReceive);
+    
+    reconnectTimer = timers.create(attemptReconnect);
+    registrationTimer = timers.create(retryRegistration);
+    linkCheckTimer = timers.create(checkLink);
+    ledEffectTimer = timers.create(refreshLED);
+    statusTimer = timers.create(printStatusLine);
+    otaRestartTimer = timers.create(restartAfterUpdate);
+    ambientTimer = timers.create(sampleAmbient);
+    flashTimer = timers.create(endFlash);
+    if (ambient.isFitted()) {
+        timers.start(ambientTimer, AMBIENT_SAMPLE_INTERVAL, AMBIENT_SAMPLE_INTERVAL);
+    }
+}
+
 // Print system status
 void printSystemStatus() {
     Serial.println("\n==== ESP32 Tally Light v2.0 Status ====");
     Serial.printf("Device: %s (CAM%d)\n", DEVICE_NAME, CAMERA_ID);
-    Serial.printf("Uptime: %lu seconds\n", (millis() - systemStartTime) / 1000);
+    Serial.printf("Uptime: %lu seconds\n", (clockMillis() - systemStartTime) / 1000);
     
     // Connection status
     const char* stateNames[] = {"DISCONNECTED", "SCANNING", "CONNECTING", "CONNECTED", "ERROR"};
@@ -539,34 +1129,104 @@ void printSystemStatus() {
         Serial.printf("Registered: %s\n", deviceRegistered ? "YES" : "NO");
         Serial.printf("Bridge Status: %s\n", bridgeStatus.c_str());
         
-        unsigned long heartbeatAge = (millis() - lastHeartbeat) / 1000;
-        Serial.printf("Last Heartbeat: %lu seconds ago\n", heartbeatAge);
+        Serial.printf("Last Heartbeat: %lu ms ago\n", clockMillis() - lastHeartbeat);
+        Serial.printf("Link Monitor: %s, heartbeat %lu ms, timeout %lu ms\n",
+                     linkMonitor.isArmed() ? "armed" : "fallback",
+                     linkMonitor.getPeriod(), linkMonitor.getTimeout());
         
-        if (heartbeatAge > HEARTBEAT_TIMEOUT / 1000) {
+        if (linkMonitor.isLost()) {
             Serial.println("⚠️ HEARTBEAT TIMEOUT!");
         }
     }
     
+    if (linkMonitor.getLossEvents() > 0) {
+        Serial.printf("Link Losses: %lu (false positives: %lu, %.1f%%)\n",
+                     linkMonitor.getLossEvents(), linkMonitor.getFalsePositives(),
+                     100.0 * linkMonitor.getFalsePositives() / linkMonitor.getLossEvents());
+    }
+    
     // Tally status
     Serial.printf("Tally State: %s\n", currentTallyState.c_str());
     if (lastStateChange > 0) {
         Serial.printf("Last Change: %lu seconds ago\n", 
-                     (millis() - lastStateChange) / 1000);
+                     (clockMillis() - lastStateChange) / 1000);
     }
     
     // Statistics
     Serial.printf("Messages Received: %lu\n", totalMessagesReceived);
-    Serial.printf("Reconnect Interval: %lu ms\n", currentReconnectInterval);
+    if (droppedFrames > 0) {
+        Serial.printf("Dropped Frames: %lu (queue full)\n", droppedFrames);
+    }
+    Serial.printf("Scan: %lu adverts seen, %lu processed\n", scanFilter.getSeen(), scanFilter.getProcessed());
+    Serial.printf("GATT: %lu cached, %lu discovered, %lu rejected, last sync %lu ms\n",
+                 gattCache.getHits(), gattCache.getDiscoveries(), gattCache.getInvalidations(), lastSyncTime);
+    Serial.printf("Persistence: %d pending, %lu queued, %lu coalesced, %lu NVS writes in %lu batches\n",
+                 persist.pendingCount(), persist.getQueued(), persist.getCoalesced(),
+                 persist.getWrites(), persist.getBatches());
+    if (cameraPixels.isEnabled() || talentPixels.isEnabled()) {
+        Serial.printf("LED Strip Frames: %lu sent, %lu unchanged skipped\n",
+                     cameraPixels.getFramesSent() + talentPixels.getFramesSent(),
+                     cameraPixels.getFramesSkipped() + talentPixels.getFramesSkipped());
+    }
+    if (ambient.isFitted()) {
+        Serial.printf("Ambient Light: %u raw, %u filtered, brightness %d/255 (PROGRAM at least %d)\n",
+                     ambient.getRaw(), ambient.getLevel(), ambient.getScale(), AMBIENT_PROGRAM_FLOOR);
+    }
+    float ledCurrent = ambient.averageCurrent(clockMillis());
+    float fullCurrent = ambient.unscaledCurrent(clockMillis());
+    Serial.printf("LED Current: %.1f mA average, %.1f mA without ambient scaling (%.0f%% saved)\n",
+                 ledCurrent, fullCurrent, fullCurrent > 0 ? (fullCurrent - ledCurrent) * 100 / fullCurrent : 0.0f);
+    unsigned long uptime = clockMillis() - systemStartTime;
+    if (uptime > 0) {
+        Serial.printf("Main Loop: %lu wakeups (%.1f/s)\n", loopCount, loopCount * 1000.0 / uptime);
+    }
+    if (otaReceiver.isReceiving() || otaReceiver.isComplete()) {
+        Serial.printf("Firmware Update: %s, %d%% (%lu/%lu bytes), %lu CRC errors, %lu resumes\n",
+                     otaReceiver.isComplete() ? "installed" : "receiving", otaReceiver.getProgress(),
+                     (unsigned long)otaReceiver.getReceived(), (unsigned long)otaReceiver.getPayloadSize(),
+                     otaReceiver.getCrcErrors(), otaReceiver.getResumes());
+    }
+    if (droppedOtaChunks > 0) {
+        Serial.printf("Dropped Firmware Chunks: %lu (queue full, resent)\n", droppedOtaChunks);
+    }
+    if (TALLY_PERIPHERAL) {
+        Serial.printf("Link: peripheral, %lu frame writes from bridge\n", peripheral.getWrites());
+    } else {
+        Serial.printf("Reconnect Backoff: %lu ms (attempt %d)\n", 
+                     currentReconnectInterval, reconnectBackoff.getAttempts());
+    }
+    if (recoveryCount > 0) {
+        Serial.printf("Recovery: %lu links, last %lu ms, min/avg/max %lu/%lu/%lu ms\n",
+                     recoveryCount, lastRecoveryTime, minRecoveryTime,
+                     totalRecoveryTime / recoveryCount, maxRecoveryTime);
+    }
     Serial.printf("Free Heap: %d bytes\n", ESP.getFreeHeap());
     
     Serial.println("========================================\n");
 }
 
+// Collect a serial line without blocking - a partial line waits for the
+// next pass instead of stalling the loop for the stream timeout
+bool readSerialLine(String& line) {
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (c == '\n') {
+            line = serialLine;
+            serialLine = "";
+            return true;
+        }
+        if (serialLine.length() < SERIAL_LINE_MAX) {
+            serialLine += c;
+        }
+    }
+    return false;
+}
+
 // Handle serial commands
 void handleSerialCommands() {
-    if (!Serial.available()) return;
+    String command;
+    if (!readSerialLine(command)) return;
     
-    String command = Serial.readStringUntil('\n');
     command.trim();
     command.toUpperCase();
     
@@ -575,32 +1235,23 @@ void handleSerialCommands() {
     }
     else if (command == "RECONNECT") {
         Serial.println("Forcing reconnection...");
-        if (pClient && pClient->isConnected()) {
-            pClient->disconnect();
-        }
+        disconnectFromBridge();
         connectionState = DISCONNECTED;
-        currentReconnectInterval = RECONNECT_INTERVAL;
-        lastReconnectAttempt = 0;
+        if (!TALLY_PERIPHERAL) {
+            reconnectBackoff.reset();
+            scheduleReconnect();
+        }
     }
     else if (command == "RESET") {
         Serial.println("Restarting ESP32...");
-        delay(1000);
+        Serial.flush();
+        persist.flush();
         ESP.restart();
     }
     else if (command == "TEST_LED") {
         Serial.println("Testing LED colors...");
-        Serial.println("Red...");
-        setLED(255, 0, 0);
-        delay(1000);
-        Serial.println("Green...");
-        setLED(0, 255, 0);
-        delay(1000);
-        Serial.println("Blue...");
-        setLED(0, 0, 255);
-        delay(1000);
-        Serial.println("Off...");
-        clearLED();
-        Serial.println("LED test complete");
+        ledTestStep = -1;
+        stepLEDTest();
     }
     else if (command == "HELP") {
         Serial.println("\nAvailable Commands:");
@@ -623,7 +1274,7 @@ void setup() {
     Serial.begin(115200);
     delay(2000);
     
-    systemStartTime = millis();
+    systemStartTime = clockMillis();
     
     Serial.println("\n==========================================");
     Serial.println("ESP32 ATEM Tally Light v2.0");
@@ -640,6 +1291,16 @@ void setup() {
     pinMode(RED_LED_PIN, OUTPUT);
     pinMode(GREEN_LED_PIN, OUTPUT);
     pinMode(BLUE_LED_PIN, OUTPUT);
+    if (cameraPixels.begin(PIXEL_CAMERA_PIN, RMT_CHANNEL_0)) {
+        Serial.printf("Camera strip: %d pixels on GPIO %d\n", PIXEL_CAMERA_COUNT, PIXEL_CAMERA_PIN);
+    }
+    if (talentPixels.begin(PIXEL_TALENT_PIN, RMT_CHANNEL_1)) {
+        Serial.printf("Talent strip: %d pixels on GPIO %d\n", PIXEL_TALENT_COUNT, PIXEL_TALENT_PIN);
+    }
+    if (ambient.begin(AMBIENT_PIN, 1 + (cameraPixels.isEnabled() ? PIXEL_CAMERA_COUNT : 0) +
+                                   (talentPixels.isEnabled() ? PIXEL_TALENT_COUNT : 0), clockMillis())) {
+        Serial.printf("Ambient light sensor on GPIO %d\n", AMBIENT_PIN);
+    }
     
     // Turn off all LEDs initially
     clearLED();
@@ -654,6 +1315,9 @@ void setup() {
     delay(200);
     clearLED();
     
+    // Create scheduled work
+    initializeTimers();
+    
     // Initialize BLE
     if (!initializeBLE()) {
         Serial.println("BLE initialization failed - stopping");
@@ -666,38 +1330,47 @@ void setup() {
     
     Serial.println("\n==========================================");
     Serial.printf("Tally Light Ready! (CAM%d - %s)\n", CAMERA_ID, DEVICE_NAME);
-    Serial.println("Searching for ATEM Bridge...");
+    Serial.println(TALLY_PERIPHERAL ? "Advertising for ATEM Bridge..." : "Searching for ATEM Bridge...");
     Serial.println("Type HELP for available commands");
     Serial.println("==========================================\n");
     
-    lastReconnectAttempt = millis();
+    // Advertise for a central-role bridge, or connect (first attempt is immediate)
+    if (TALLY_PERIPHERAL) {
+        peripheral.begin(registrationMessage(), queueBridgeFrames, onPeripheralLink);
+    } else {
+        scheduleReconnect();
+    }
+    timers.start(statusTimer, STATUS_UPDATE_INTERVAL, STATUS_UPDATE_INTERVAL);
 }
 
 void loop() {
-    // Handle BLE connection
-    handleConnection();
+    loopCount++;
     
-    // Update LED status
-    updateLEDStatus();
+    // Apply frames from the bridge first - lowest on-air latency
+    processPendingFrames();
+    
+    // Firmware update chunks (flash writes) after the tally
+    processOtaChunks();
+    
+    // Settings reach NVS once switching has paused
+    persist.service(clockMillis(), lastTallyTraffic);
+    
+    // Run due scheduled work (reconnection, link checks, LED effects, status)
+    timers.advance();
     
     // Handle serial commands
     handleSerialCommands();
     
-    // Print periodic status updates
-    if (millis() - lastStatusUpdate > STATUS_UPDATE_INTERVAL) {
-        lastStatusUpdate = millis();
-        
-        if (connectionState == CONNECTED) {
-            Serial.printf("Status: CAM%d %s | Bridge: %s | Heartbeat: %lus ago\n",
-                         CAMERA_ID, currentTallyState.c_str(), bridgeStatus.c_str(),
-                         (millis() - lastHeartbeat) / 1000);
-        } else {
-            Serial.printf("Status: %s | Reconnect in %lus\n",
-                         connectionState == DISCONNECTED ? "DISCONNECTED" : "CONNECTING",
-                         (currentReconnectInterval - (millis() - lastReconnectAttempt)) / 1000);
-        }
+    // Scan over: bridge found or scan time up
+    if (scanning && (bridgeFound || scanTimedOut)) {
+        finishScan();
     }
     
-    // Small delay for system stability
-    delay(10);
+    // Apply any state change made this pass to the LED
+    updateLEDStatus();
+    
+    // Sleep until there is work: frame, BLE event, serial input or the next
+    // timer / LED-effect deadline
+    TickType_t wait = pdMS_TO_TICKS(timers.msUntilNext(LOOP_IDLE_TIMEOUT));
+    xEventGroupWaitBits(loopEvents, LOOP_EVENT_ALL, pdTRUE, pdFALSE, wait);
 }
@@ -0,0 +1,132 @@
+/*
+ * Link Monitor for the ESP32 ATEM Tally System
+ *
+ * Missed-heartbeat link-loss detection on the tally light.
+ *
+ * - The tally asks the bridge for a heartbeat period at registration
+ * - Every valid frame proves the link is alive (onFrame) - the bridge skips
+ *   a tally's heartbeat while camera frames reach it, so during fast cutting
+ *   the camera frames are the only traffic
+ * - Only heartbeat frames (cameraId 0) count toward arming (onHeartbeat);
+ *   camera frames and snapshot or container bursts arrive back to back and
+ *   say nothing about the heartbeat cadence
+ * - The monitor arms once two heartbeats in a row arrive on that cadence
+ *   (between half and one and a half periods apart), confirming the bridge
+ *   honoured the request (older bridges keep the slow fallback timeout)
+ * - Armed: the link is declared lost after missLimit missed periods and
+ *   should be dropped one period later
+ * - A frame arriving while the link is declared lost counts as a false
+ *   positive, so the detection window can be tuned against real RF
+ *
+ * Dead radio links are caught separately by the BLE supervision timeout,
+ * which fires onDisconnect from the controller.
+ */
+
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include <Arduino.h>
+
+typedef enum {
+    LINK_OK,          // Frames arriving on time
+    LINK_LOST,        // Heartbeat budget exhausted - on-air state is stale
+    LINK_DEAD         // Lost for a further grace period - drop the connection
+} LinkStatus;
+
+class LinkMonitor {
+public:
+    LinkMonitor(unsigned long heartbeatPeriod, uint8_t missedHeartbeats, unsigned long fallback)
+        : period(heartbeatPeriod), missLimit(missedHeartbeats), fallbackTimeout(fallback) {
+        begin(0);
+    }
+
+    // Start monitoring a new connection
+    void begin(unsigned long now) {
+        lastFrame = now;
+        lastHeartbeat = now;
+        onTimeFrames = 0;
+        armed = false;
+        status = LINK_OK;
+    }
+
+    // Any valid frame from the bridge proves the link is alive
+    void onFrame(unsigned long now) {
+        lastFrame = now;
+
+        if (status != LINK_OK) {
+            falsePositives++;
+            status = LINK_OK;
+        }
+    }
+
+    // A heartbeat frame (cameraId 0) also shows the bridge's cadence
+    void onHeartbeat(unsigned long now) {
+        unsigned long gap = now - lastHeartbeat;
+        lastHeartbeat = now;
+
+        // An early heartbeat (status change, snapshot) neither counts nor
+        // breaks the run; a late one restarts it
+        if (!armed && gap >= period / 2) {
+            onTimeFrames = (gap <= period + period / 2) ? onTimeFrames + 1 : 0;
+            armed = (onTimeFrames >= 2);
+        }
+
+        onFrame(now);
+    }
+
+    // A valid frame from the bridge, by cameraId (0 = heartbeat)
+    void onMessage(uint8_t cameraId, unsigned long now) {
+        if (cameraId == 0) {
+            onHeartbeat(now);
+        } else {
+            onFrame(now);
+        }
+    }
+
+    // Re-evaluate link state; call regularly while connected
+    LinkStatus update(unsigned long now) {
+        unsigned long silence = now - lastFrame;
+
+        if (status == LINK_OK && silence > getTimeout()) {
+            status = LINK_LOST;
+            lossEvents++;
+        }
+        if (status == LINK_LOST && silence > getTimeout() + getGrace()) {
+            status = LINK_DEAD;
+        }
+        return status;
+    }
+
+    // Current detection window (ms)
+    unsigned long getTimeout() const {
+        return armed ? period * missLimit : fallbackTimeout;
+    }
+
+    // Time (ms) from loss declaration to dropping the link
+    unsigned long getGrace() const {
+        return armed ? period : fallbackTimeout;
+    }
+
+    bool isLost() const { return status != LINK_OK; }
+    bool isArmed() const { return armed; }
+    unsigned long getPeriod() const { return period; }
+    unsigned long getLastFrame() const { return lastFrame; }
+    unsigned long getLossEvents() const { return lossEvents; }
+    unsigned long getFalsePositives() const { return falsePositives; }
+
+private:
+    unsigned long period;
+    uint8_t missLimit;
+    unsigned long fallbackTimeout;
+
+    unsigned long lastFrame;
+    unsigned long lastHeartbeat;
+    uint8_t onTimeFrames;
+    bool armed;
+    LinkStatus status;
+
+    unsigned long lossEvents = 0;
+    unsigned long falsePositives = 0;
+};
+
+#endif // LINK_MONITOR_H
@@ -0,0 +1,161 @@
+/*
+ * Write-Behind Persistence for the ESP32 ATEM Tally System
+ *
+ * Keeps NVS writes away from tally traffic. An NVS write programs (and now
+ * and then erases) flash; while it runs the instruction cache is off and
+ * everything outside IRAM waits, so a write landing on a cut delays it by
+ * milliseconds - more when NVS has to compact a page.
+ *
+ * - Callers put values here instead of writing Preferences directly; a newer
+ *   value for the same key replaces the pending one, so bursts coalesce
+ * - The owner calls service() from its loop with the time of the last tally
+ *   traffic; pending values are written in one batch once that traffic has
+ *   been quiet for the idle window
+ * - flush() writes at once (before a restart)
+ * - A full queue writes the oldest entry through rather than losing a value
+ *
+ * Values are read back with Preferences at boot only - a read does not see
+ * a pending write.
+ */
+
+#ifndef PERSIST_QUEUE_H
+#define PERSIST_QUEUE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+#ifndef PERSIST_QUEUE_LENGTH
+#define PERSIST_QUEUE_LENGTH 4                // Distinct keys waiting at once
+#endif
+#ifndef PERSIST_MAX_VALUE
+#define PERSIST_MAX_VALUE 32                  // Largest value kept (bytes)
+#endif
+#ifndef PERSIST_IDLE_WINDOW
+#define PERSIST_IDLE_WINDOW 2000              // Tally traffic quiet this long before writing (ms)
+#endif
+
+class PersistQueue {
+public:
+    // Queue a blob (Preferences::putBytes)
+    void putBytes(const char* ns, const char* key, const void* data, size_t length) {
+        if (length > PERSIST_MAX_VALUE) return;
+        Entry* entry = claim(ns, key);
+        entry->type = TYPE_BYTES;
+        entry->length = length;
+        memcpy(entry->data, data, length);
+    }
+
+    // Queue a number (Preferences::putUInt)
+    void putUInt(const char* ns, const char* key, uint32_t value) {
+        Entry* entry = claim(ns, key);
+        entry->type = TYPE_UINT;
+        entry->length = sizeof(value);
+        memcpy(entry->data, &value, sizeof(value));
+    }
+
+    // Queue a removal (Preferences::remove)
+    void remove(const char* ns, const char* key) {
+        Entry* entry = claim(ns, key);
+        entry->type = TYPE_REMOVE;
+        entry->length = 0;
+    }
+
+    // Write the batch once tally traffic has been quiet for the idle window
+    // (main loop). Returns true if it wrote.
+    bool service(unsigned long now, unsigned long lastTraffic) {
+        if (pendingCount() == 0 || now - lastTraffic < PERSIST_IDLE_WINDOW) return false;
+        flush();
+        return true;
+    }
+
+    // Write everything now
+    void flush() {
+        if (pendingCount() == 0) return;
+        for (uint8_t i = 0; i < PERSIST_QUEUE_LENGTH; i++) {
+            if (entries[i].used) {
+                write(entries[i]);
+            }
+        }
+        batches++;
+    }
+
+    uint8_t pendingCount() const {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < PERSIST_QUEUE_LENGTH; i++) {
+            if (entries[i].used) count++;
+        }
+        return count;
+    }
+
+    unsigned long getQueued() const { return queued; }
+    unsigned long getCoalesced() const { return coalesced; }
+    unsigned long getWrites() const { return writes; }
+    unsigned long getBatches() const { return batches; }
+
+private:
+    enum { TYPE_BYTES, TYPE_UINT, TYPE_REMOVE };
+
+    struct Entry {
+        bool used;
+        uint8_t type;
+        const char* ns;              // Namespace and key are string literals
+        const char* key;
+        uint8_t length;
+        uint8_t data[PERSIST_MAX_VALUE];
+        uint32_t order;
+    };
+
+    // Entry for a key: the pending one, a free one, or the oldest after
+    // writing it through
+    Entry* claim(const char* ns, const char* key) {
+        queued++;
+        Entry* free = nullptr;
+        Entry* oldest = nullptr;
+        for (uint8_t i = 0; i < PERSIST_QUEUE_LENGTH; i++) {
+            Entry& entry = entries[i];
+            if (entry.used && strcmp(entry.ns, ns) == 0 && strcmp(entry.key, key) == 0) {
+                coalesced++;
+                entry.order = ++orderSeq;
+                return &entry;
+            }
+            if (!entry.used && free == nullptr) free = &entry;
+            if (entry.used && (oldest == nullptr || entry.order < oldest->order)) oldest = &entry;
+        }
+        if (free == nullptr) {
+            write(*oldest);
+            free = oldest;
+        }
+        free->used = true;
+        free->ns = ns;
+        free->key = key;
+        free->order = ++orderSeq;
+        return free;
+    }
+
+    void write(Entry& entry) {
+        Preferences prefs;
+        prefs.begin(entry.ns, false);
+        if (entry.type == TYPE_BYTES) {
+            prefs.putBytes(entry.key, entry.data, entry.length);
+        } else if (entry.type == TYPE_UINT) {
+            uint32_t value;
+            memcpy(&value, entry.data, sizeof(value));
+            prefs.putUInt(entry.key, value);
+        } else {
+            prefs.remove(entry.key);
+        }
+        prefs.end();
+        entry.used = false;
+        writes++;
+    }
+
+    Entry entries[PERSIST_QUEUE_LENGTH] = {};
+    uint32_t orderSeq = 0;
+
+    unsigned long queued = 0;
+    unsigned long coalesced = 0;
+    unsigned long writes = 0;
+    unsigned long batches = 0;
+};
+
+#endif // PERSIST_QUEUE_H
@@ -0,0 +1,62 @@
+/*
+ * Reconnect Backoff for the ESP32 ATEM Tally System
+ *
+ * Capped exponential backoff with randomized jitter, shared by the tally
+ * light firmwares (bridge link) and the bridge (ATEM link).
+ *
+ * - The first attempt after a reset is immediate (delay 0)
+ * - Each further failure doubles the ceiling, up to maxDelay
+ * - The actual wait is drawn from [ceiling/2, ceiling] so a room full of
+ *   tallies does not hit a rebooted bridge in lock-step
+ * - reset() is called on any successful sync with the other end
+ */
+
+#ifndef RECONNECT_BACKOFF_H
+#define RECONNECT_BACKOFF_H
+
+#include <Arduino.h>
+
+class ReconnectBackoff {
+public:
+    ReconnectBackoff(uint32_t base, uint32_t maximum)
+        : baseDelay(base), maxDelay(maximum), failures(0) {}
+
+    // Delay (ms) to wait before the next attempt
+    uint32_t nextDelay() {
+        uint8_t attempt = failures;
+        if (failures < 255) {
+            failures++;
+        }
+        if (attempt == 0) {
+            return 0; // Immediate first retry
+        }
+
+        uint32_t ceiling = baseDelay;
+        for (uint8_t i = 1; i < attempt && ceiling < maxDelay; i++) {
+            ceiling <<= 1;
+        }
+        if (ceiling > maxDelay) {
+            ceiling = maxDelay;
+        }
+
+        uint32_t half = ceiling / 2;
+        return half + (esp_random() % (ceiling - half + 1));
+    }
+
+    // Forget previous failures (call on successful sync)
+    void reset() {
+        failures = 0;
+    }
+
+    // Number of delays handed out since the last reset
+    uint8_t getAttempts() const {
+        return failures;
+    }
+
+private:
+    uint32_t baseDelay;
+    uint32_t maxDelay;
+    uint8_t failures;
+};
+
+#endif // RECONNECT_BACKOFF_H
@@ -0,0 +1,93 @@
+/*
+ * Sequence-Locked Snapshots for the ESP32 ATEM Tally System
+ *
+ * Publishes a value shared between the main loop and the BLE task without a
+ * mutex on the read side. A write makes the sequence odd, copies the value
+ * and makes it even again; a reader copies the value and retries if the
+ * sequence was odd or moved while it copied. Readers never block writers and
+ * always get a consistent copy.
+ *
+ * - T must be trivially copyable (fixed-size arrays, no String)
+ * - Writes hold a spinlock for the copy only: writers on different tasks are
+ *   serialized, and a write cannot be preempted by a reader spinning on the
+ *   same core
+ * - update() is a read-modify-write under the same lock, for writers that
+ *   change one field of a shared value
+ */
+
+#ifndef SEQ_LOCK_H
+#define SEQ_LOCK_H
+
+#include <Arduino.h>
+#include <string.h>
+#include <type_traits>
+
+template <class T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock values are copied byte-wise");
+
+public:
+    SeqLock() {
+        memset(&value, 0, sizeof(T));
+    }
+
+    // Publish a new value
+    void write(const T& next) {
+        portENTER_CRITICAL(&writeLock);
+        beginWrite();
+        memcpy(&value, &next, sizeof(T));
+        endWrite();
+        portEXIT_CRITICAL(&writeLock);
+    }
+
+    // Change the published value in place (modify runs inside the spinlock -
+    // keep it to plain field updates)
+    template <class Modify>
+    void update(Modify modify) {
+        portENTER_CRITICAL(&writeLock);
+        T next;
+        memcpy(&next, &value, sizeof(T));
+        modify(next);
+        beginWrite();
+        memcpy(&value, &next, sizeof(T));
+        endWrite();
+        portEXIT_CRITICAL(&writeLock);
+    }
+
+    // Consistent copy of the published value (any task, never blocks)
+    T read() const {
+        T copy;
+        while (true) {
+            uint32_t before = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE);
+            if ((before & 1) == 0) {
+                memcpy(&copy, &value, sizeof(T));
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (__atomic_load_n(&sequence, __ATOMIC_RELAXED) == before) {
+                    return copy;
+                }
+            }
+            retries++;
+        }
+    }
+
+    // Moves on every write - compare to skip work when nothing changed
+    uint32_t getSequence() const { return __atomic_load_n(&sequence, __ATOMIC_ACQUIRE); }
+    unsigned long getRetries() const { return retries; }
+
+private:
+    void beginWrite() {
+        __atomic_store_n(&sequence, sequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    void endWrite() {
+        __atomic_store_n(&sequence, sequence + 1, __ATOMIC_RELEASE);
+    }
+
+    T value;
+    uint32_t sequence = 0;
+    mutable unsigned long retries = 0;
+    portMUX_TYPE writeLock = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif // SEQ_LOCK_H
@@ -0,0 +1,51 @@
+/*
+ * Clock for the ESP32 ATEM Tally System
+ *
+ * Every timeout, interval and timestamp in the bridge core, the timer wheel
+ * and the tally firmware reads the time through clockMillis().
+ *
+ * - On device clockMillis() is millis() (inlined, no cost)
+ * - Built with TALLY_VIRTUAL_CLOCK defined (host simulation), time only
+ *   moves when the simulation calls VirtualClock::advance(), so hours of
+ *   heartbeats, backoff and LED effects run as fast as the host can step
+ *   them. VirtualClock::set() can start just before the 32-bit wrap to
+ *   exercise millis() rollover. tests/test_show_sim.cpp runs a 12-hour
+ *   show this way.
+ *
+ * Hardware waits inside library wrappers (ATEMmin's connect handshake) keep
+ * using millis() - a simulation replaces the tally source instead.
+ */
+
+#ifndef TALLY_CLOCK_H
+#define TALLY_CLOCK_H
+
+#include <Arduino.h>
+
+#ifdef TALLY_VIRTUAL_CLOCK
+
+class VirtualClock {
+public:
+    static unsigned long now() { return current(); }
+    static void set(unsigned long ms) { current() = ms; }
+    static void advance(unsigned long ms) { current() += ms; }
+
+private:
+    static unsigned long& current() {
+        static unsigned long ms = 0;
+        return ms;
+    }
+};
+
+inline unsigned long clockMillis() {
+    return VirtualClock::now();
+}
+
+#else
+
+inline unsigned long clockMillis() {
+    return millis();
+}
+
+#endif // TALLY_VIRTUAL_CLOCK
+
+#endif // TALLY_CLOCK_H
@@ -0,0 +1,249 @@
+/*
+ * GATT Handle Cache for the ESP32 ATEM Tally System
+ *
+ * Skips service discovery when a tally reconnects to a bridge it knows.
+ * Discovery costs several round trips between "connected" and "showing the
+ * correct state", yet the bridge's attribute handles only change with its
+ * firmware.
+ *
+ * - After a full discovery the tally stores the bridge's frame, snapshot and
+ *   OTA handles (and their notification descriptors) in NVS, keyed by the
+ *   bridge address and the service layout the bridge advertises
+ *   (TallyAdvertisement.gatt) - written behind through the PersistQueue,
+ *   never during traffic
+ * - On the next connection to that bridge it registers for notifications,
+ *   writes the descriptors and reads the snapshot straight by handle
+ * - Every step is confirmed by the bridge: a failed descriptor write or read
+ *   drops the entry, and the tally falls back to full discovery on the same
+ *   connection
+ *
+ * Bluedroid on Arduino-ESP32 2.x does not expose the GATT database hash, so
+ * the advertised layout stands in for it. It comes from the bridge, so a
+ * bridge reflashed with a different characteristic set (with or without
+ * OTA) no longer matches the stored entry. A bridge that does not advertise
+ * a layout is always discovered.
+ *
+ * The sketch forwards GATT client events (BLE task) to onGattcEvent();
+ * attach() blocks the loop for the confirmations.
+ */
+
+#ifndef TALLY_GATT_CACHE_H
+#define TALLY_GATT_CACHE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <BLEDevice.h>
+#include <BLEClient.h>
+#include <esp_gattc_api.h>
+#include <freertos/event_groups.h>
+#include "TallyProtocol.h"
+#include "PersistQueue.h"
+
+#ifndef TALLY_GATT_TIMEOUT
+#define TALLY_GATT_TIMEOUT 1000               // Wait for each cached-handle confirmation (ms)
+#endif
+
+typedef void (*GattNotifyHandler)(const uint8_t* data, size_t length);
+
+class TallyGattCache {
+public:
+    // Load the stored entry; handlers receive notifications on cached links,
+    // changes are written through the persistence queue
+    void begin(GattNotifyHandler frameHandler, GattNotifyHandler otaHandler, PersistQueue& queue) {
+        persist = &queue;
+        onFrames = frameHandler;
+        onOta = otaHandler;
+        events = xEventGroupCreate();
+
+        Preferences prefs;
+        prefs.begin("tallygatt", true);
+        valid = prefs.getBytes("handles", &handles, sizeof(handles)) == sizeof(handles) &&
+                handles.layout != 0;
+        prefs.end();
+    }
+
+    // Handles of this bridge, with the service layout it advertised, are known
+    bool has(BLEAddress address, uint8_t layout) {
+        return valid && layout != 0 && handles.layout == layout &&
+               memcmp(handles.address, *address.getNative(), sizeof(esp_bd_addr_t)) == 0;
+    }
+
+    // Remember the handles found by a full discovery (ota may be nullptr).
+    // layout is the bridge's advertised TallyAdvertisement.gatt; nothing is
+    // kept without one, or if the service lacks an advertised characteristic.
+    void store(BLEAddress address, uint8_t layout, BLERemoteCharacteristic* frames,
+               BLERemoteCharacteristic* snapshot, BLERemoteCharacteristic* ota) {
+        discoveries++;
+        if (layout == 0 || ((layout & TALLY_GATT_OTA) && ota == nullptr)) return;
+
+        Handles next = {};
+        memcpy(next.address, *address.getNative(), sizeof(esp_bd_addr_t));
+        next.layout = layout;
+        next.frames = frames->getHandle();
+        next.framesCccd = cccdHandle(frames);
+        next.snapshot = (snapshot != nullptr) ? snapshot->getHandle() : 0;
+        if (ota != nullptr) {
+            next.ota = ota->getHandle();
+            next.otaCccd = cccdHandle(ota);
+        }
+        if (next.framesCccd == 0 || (next.ota != 0 && next.otaCccd == 0)) return;
+        if (valid && memcmp(&next, &handles, sizeof(handles)) == 0) return;
+
+        handles = next;
+        valid = true;
+        persist->putBytes("tallygatt", "handles", &handles, sizeof(handles));
+    }
+
+    // Subscribe and read the snapshot by cached handle. Returns false, with
+    // the entry dropped, if the bridge did not confirm a step.
+    bool attach(BLEClient* client, std::string& snapshotValue) {
+        gattcIf = client->getGattcIf();
+        connId = client->getConnId();
+        active = true;
+
+        if (!enableNotify(handles.frames, handles.framesCccd) ||
+            (handles.ota != 0 && !enableNotify(handles.ota, handles.otaCccd)) ||
+            (handles.snapshot != 0 && !read(handles.snapshot, snapshotValue))) {
+            active = false;
+            invalidate();
+            return false;
+        }
+        hits++;
+        return true;
+    }
+
+    // Link closed
+    void detach() {
+        active = false;
+    }
+
+    // Drop the stored entry (handles did not match the bridge)
+    void invalidate() {
+        valid = false;
+        invalidations++;
+        persist->remove("tallygatt", "handles");
+    }
+
+    // Writes on a cached link (no response, like the library path)
+    esp_err_t writeFrames(const uint8_t* data, size_t length) {
+        return write(handles.frames, data, length);
+    }
+    esp_err_t writeOta(const uint8_t* data, size_t length) {
+        return write(handles.ota, data, length);
+    }
+
+    // GATT client event (BLE task)
+    void onGattcEvent(esp_gattc_cb_event_t event, esp_gatt_if_t eventIf, esp_ble_gattc_cb_param_t* param) {
+        if (!active || eventIf != gattcIf) return;
+
+        switch (event) {
+            case ESP_GATTC_NOTIFY_EVT:
+                if (param->notify.conn_id != connId) return;
+                if (param->notify.handle == handles.frames) {
+                    onFrames(param->notify.value, param->notify.value_len);
+                } else if (handles.ota != 0 && param->notify.handle == handles.ota) {
+                    onOta(param->notify.value, param->notify.value_len);
+                }
+                break;
+            case ESP_GATTC_WRITE_DESCR_EVT:
+                if (param->write.conn_id != connId || param->write.handle != pendingHandle) return;
+                xEventGroupSetBits(events, param->write.status == ESP_GATT_OK ? EVENT_OK : EVENT_FAILED);
+                break;
+            case ESP_GATTC_READ_CHAR_EVT:
+                if (param->read.conn_id != connId || param->read.handle != pendingHandle) return;
+                if (param->read.status == ESP_GATT_OK) {
+                    readValue.assign((const char*)param->read.value, param->read.value_len);
+                }
+                xEventGroupSetBits(events, param->read.status == ESP_GATT_OK ? EVENT_OK : EVENT_FAILED);
+                break;
+            default:
+                break;
+        }
+    }
+
+    bool isActive() const { return active; }
+    bool isValid() const { return valid; }
+    unsigned long getHits() const { return hits; }
+    unsigned long getDiscoveries() const { return discoveries; }
+    unsigned long getInvalidations() const { return invalidations; }
+
+private:
+    static const EventBits_t EVENT_OK = BIT0;
+    static const EventBits_t EVENT_FAILED = BIT1;
+
+    // Stored entry (NVS blob)
+    struct Handles {
+        esp_bd_addr_t address;
+        uint16_t layout;           // TallyAdvertisement.gatt of the bridge
+        uint16_t frames;
+        uint16_t framesCccd;
+        uint16_t snapshot;         // 0 = bridge without snapshot
+        uint16_t ota;              // 0 = bridge without OTA
+        uint16_t otaCccd;
+    };
+
+    static uint16_t cccdHandle(BLERemoteCharacteristic* characteristic) {
+        BLERemoteDescriptor* cccd = characteristic->getDescriptor(BLEUUID((uint16_t)0x2902));
+        return (cccd != nullptr) ? cccd->getHandle() : 0;
+    }
+
+    // Register locally, then turn notifications on at the bridge
+    bool enableNotify(uint16_t handle, uint16_t cccd) {
+        esp_bd_addr_t address;
+        memcpy(address, handles.address, sizeof(address));
+        if (esp_ble_gattc_register_for_notify(gattcIf, address, handle) != ESP_OK) return false;
+
+        uint8_t enable[2] = { 0x01, 0x00 };
+        return request(cccd, [&]() {
+            return esp_ble_gattc_write_char_descr(gattcIf, connId, cccd, sizeof(enable), enable,
+                                                  ESP_GATT_WRITE_TYPE_RSP, ESP_GATT_AUTH_REQ_NONE);
+        });
+    }
+
+    // Read a characteristic (long values are completed by the stack)
+    bool read(uint16_t handle, std::string& value) {
+        readValue.clear();
+        if (!request(handle, [&]() {
+                return esp_ble_gattc_read_char(gattcIf, connId, handle, ESP_GATT_AUTH_REQ_NONE);
+            })) {
+            return false;
+        }
+        value = readValue;
+        return true;
+    }
+
+    // Issue one GATT request and wait for its confirmation
+    template <class Issue>
+    bool request(uint16_t handle, Issue issue) {
+        xEventGroupClearBits(events, EVENT_OK | EVENT_FAILED);
+        pendingHandle = handle;
+        if (issue() != ESP_OK) return false;
+        EventBits_t bits = xEventGroupWaitBits(events, EVENT_OK | EVENT_FAILED, pdTRUE, pdFALSE,
+                                               pdMS_TO_TICKS(TALLY_GATT_TIMEOUT));
+        return (bits & EVENT_OK) != 0;
+    }
+
+    esp_err_t write(uint16_t handle, const uint8_t* data, size_t length) {
+        return esp_ble_gattc_write_char(gattcIf, connId, handle, length, (uint8_t*)data,
+                                        ESP_GATT_WRITE_TYPE_NO_RSP, ESP_GATT_AUTH_REQ_NONE);
+    }
+
+    Handles handles = {};
+    bool valid = false;
+    PersistQueue* persist = nullptr;
+    volatile bool active = false;
+    esp_gatt_if_t gattcIf = 0;
+    uint16_t connId = 0;
+
+    GattNotifyHandler onFrames = nullptr;
+    GattNotifyHandler onOta = nullptr;
+    EventGroupHandle_t events = nullptr;
+    volatile uint16_t pendingHandle = 0;
+    std::string readValue;
+
+    unsigned long hits = 0;
+    unsigned long discoveries = 0;
+    unsigned long invalidations = 0;
+};
+
+#endif // TALLY_GATT_CACHE_H
@@ -0,0 +1,353 @@
+/*
+ * Tally OTA Receiver for the ESP32 ATEM Tally System
+ *
+ * Tally side of the firmware update pushed by the bridge (see the OTA
+ * section of TallyProtocol.h).
+ *
+ * - handle() takes one notification from the OTA characteristic and
+ *   returns the reply to write back
+ * - Chunks must arrive in order and pass their CRC32, else the bridge is
+ *   asked to resend from the first missing byte
+ * - The payload streams through inflate (ROM miniz, 32 KB window) and the
+ *   delta decoder straight into the update partition, sector by sector
+ * - Progress survives a BLE disconnect: a repeated offer for the same image
+ *   resumes at the first missing byte
+ * - The installed image's CRC is kept in NVS (written behind through the
+ *   PersistQueue), so an offer of the running image is declined
+ *
+ * Call handle() from the loop task - flash writes take milliseconds.
+ */
+
+#ifndef TALLY_OTA_RECEIVER_H
+#define TALLY_OTA_RECEIVER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <rom/miniz.h>
+#include "TallyProtocol.h"
+#include "TallyClock.h"
+#include "PersistQueue.h"
+
+class TallyOtaReceiver {
+public:
+    ~TallyOtaReceiver() {
+        releaseBuffers();
+    }
+
+    // NVS writes go through the sketch's persistence queue
+    void begin(PersistQueue& queue) {
+        persist = &queue;
+    }
+
+    // Process one notification; returns the reply length written to reply (0 = none)
+    size_t handle(const uint8_t* data, size_t length, TallyOtaReply* reply) {
+        if (length < 1) return 0;
+
+        switch (data[0]) {
+            case TALLY_OTA_OFFER:
+                if (length < 1 + sizeof(TallyOtaImage)) return 0;
+                return onOffer(&data[1], reply);
+            case TALLY_OTA_DATA:
+                if (length < 1 + sizeof(TallyOtaChunk)) return 0;
+                return onChunk(&data[1], length - 1, reply);
+            case TALLY_OTA_END:
+                return onEnd(reply);
+        }
+        return 0;
+    }
+
+    bool isReceiving() const { return receiving; }
+    bool isComplete() const { return complete; }
+    uint32_t getReceived() const { return received; }
+    uint32_t getPayloadSize() const { return image.payloadSize; }
+    uint32_t getWritten() const { return written; }
+    unsigned long getCrcErrors() const { return crcErrors; }
+    unsigned long getResumes() const { return resumes; }
+
+    // Progress in percent of the payload
+    int getProgress() const {
+        return image.payloadSize ? (int)(100ULL * received / image.payloadSize) : 0;
+    }
+
+    // CRC32 of the installed image (0 = never updated over BLE)
+    static uint32_t installedCrc() {
+        Preferences prefs;
+        prefs.begin("tallyota", true);
+        uint32_t crc = prefs.getUInt("imageCrc", 0);
+        prefs.end();
+        return crc;
+    }
+
+private:
+    size_t makeReply(TallyOtaReply* reply, uint8_t type, uint32_t value) {
+        reply->type = type;
+        reply->value = value;
+        return sizeof(TallyOtaReply);
+    }
+
+    size_t onOffer(const uint8_t* data, TallyOtaReply* reply) {
+        TallyOtaImage offer;
+        memcpy(&offer, data, sizeof(offer));
+        if (offer.magic != TALLY_OTA_IMAGE_MAGIC) {
+            return makeReply(reply, TALLY_OTA_REJECT, TALLY_OTA_REASON_CORRUPT);
+        }
+
+        // Same image as the one in progress (or just finished) - resume
+        if ((receiving || complete) && offer.imageCrc == image.imageCrc &&
+            offer.payloadSize == image.payloadSize) {
+            if (complete) {
+                return makeReply(reply, TALLY_OTA_DONE, image.imageCrc);
+            }
+            resumes++;
+            return makeReply(reply, TALLY_OTA_RESUME, received);
+        }
+
+        if (offer.imageCrc == installedCrc()) {
+            return makeReply(reply, TALLY_OTA_REJECT, TALLY_OTA_REASON_CURRENT);
+        }
+
+        cancel();
+        if ((offer.flags & TALLY_OTA_FLAG_DELTA) && !baseMatches(offer)) {
+            return makeReply(reply, TALLY_OTA_REJECT, TALLY_OTA_REASON_BASE);
+        }
+
+        running = esp_ota_get_running_partition();
+        target = esp_ota_get_next_update_partition(nullptr);
+        if (target == nullptr || offer.imageSize > target->size || !allocateBuffers(offer.flags)) {
+            releaseBuffers();
+            return makeReply(reply, TALLY_OTA_REJECT, TALLY_OTA_REASON_RESOURCES);
+        }
+        if (esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &otaHandle) != ESP_OK) {
+            releaseBuffers();
+            return makeReply(reply, TALLY_OTA_REJECT, TALLY_OTA_REASON_RESOURCES);
+        }
+
+        image = offer;
+        received = 0;
+        written = 0;
+        imageCrc = 0;
+        deltaState = DELTA_OP;
+        headerUsed = 0;
+        receiving = true;
+        complete = false;
+        return makeReply(reply, TALLY_OTA_RESUME, 0);
+    }
+
+    size_t onChunk(const uint8_t* data, size_t length, TallyOtaReply* reply) {
+        if (!receiving) return 0;
+
+        TallyOtaChunk chunk;
+        memcpy(&chunk, data, sizeof(chunk));
+        const uint8_t* payload = data + sizeof(chunk);
+        size_t payloadLength = length - sizeof(chunk);
+
+        // Duplicate from before a rewind - already have it
+        if (chunk.offset < received) {
+            return makeReply(reply, TALLY_OTA_ACK, received);
+        }
+        // Gap (lost notification) or corrupt chunk - resend from the first missing byte
+        if (chunk.offset > received || chunk.offset + payloadLength > image.payloadSize ||
+            tallyCrc32(0, payload, payloadLength) != chunk.crc) {
+            crcErrors += (chunk.offset == received);
+            return makeReply(reply, TALLY_OTA_NACK, received);
+        }
+
+        if (!consume(payload, payloadLength)) {
+            cancel();
+            return makeReply(reply, TALLY_OTA_REJECT, TALLY_OTA_REASON_CORRUPT);
+        }
+        received += payloadLength;
+        return makeReply(reply, TALLY_OTA_ACK, received);
+    }
+
+    size_t onEnd(TallyOtaReply* reply) {
+        if (complete) {
+            return makeReply(reply, TALLY_OTA_DONE, image.imageCrc);
+        }
+        if (!receiving) return 0;
+        if (received < image.payloadSize) {
+            return makeReply(reply, TALLY_OTA_NACK, received);
+        }
+
+        bool verified = written == image.imageSize && imageCrc == image.imageCrc;
+        bool installed = verified && esp_ota_end(otaHandle) == ESP_OK &&
+                         esp_ota_set_boot_partition(target) == ESP_OK;
+        otaHandle = 0;
+        if (!installed) {
+            cancel();
+            return makeReply(reply, TALLY_OTA_REJECT, TALLY_OTA_REASON_CORRUPT);
+        }
+
+        persist->putUInt("tallyota", "imageCrc", image.imageCrc);
+
+        releaseBuffers();
+        receiving = false;
+        complete = true;
+        return makeReply(reply, TALLY_OTA_DONE, image.imageCrc);
+    }
+
+    // Drop a transfer in progress (the partially written partition is not booted)
+    void cancel() {
+        if (otaHandle) {
+            esp_ota_abort(otaHandle);
+            otaHandle = 0;
+        }
+        releaseBuffers();
+        receiving = false;
+        complete = false;
+    }
+
+    // Payload pipeline: inflate, then delta, then flash
+
+    bool consume(const uint8_t* data, size_t length) {
+        if (!(image.flags & TALLY_OTA_FLAG_COMPRESSED)) {
+            return decodeDelta(data, length);
+        }
+
+        bool more = received + length < image.payloadSize; // Input continues in later chunks
+        while (length > 0 || inflateHasOutput) {
+            size_t inBytes = length;
+            size_t outBytes = TINFL_LZ_DICT_SIZE - dictOffset;
+            tinfl_status status = tinfl_decompress(inflator, data, &inBytes, dictionary,
+                                                   dictionary + dictOffset, &outBytes,
+                                                   more ? TINFL_FLAG_HAS_MORE_INPUT : 0);
+            if (status < TINFL_STATUS_DONE) return false;
+            if (outBytes > 0 && !decodeDelta(dictionary + dictOffset, outBytes)) return false;
+
+            dictOffset = (dictOffset + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+            data += inBytes;
+            length -= inBytes;
+            inflateHasOutput = (status == TINFL_STATUS_HAS_MORE_OUTPUT);
+            if (status == TINFL_STATUS_DONE) break;
+            if (inBytes == 0 && outBytes == 0 && !inflateHasOutput) break;
+        }
+        return true;
+    }
+
+    bool decodeDelta(const uint8_t* data, size_t length) {
+        if (!(image.flags & TALLY_OTA_FLAG_DELTA)) {
+            return emit(data, length);
+        }
+
+        while (length > 0) {
+            if (deltaState == DELTA_DATA) {
+                size_t n = min((size_t)deltaRemaining, length);
+                if (!emit(data, n)) return false;
+                data += n;
+                length -= n;
+                deltaRemaining -= n;
+                if (deltaRemaining == 0) deltaState = DELTA_OP;
+                continue;
+            }
+
+            // Collect the op header: op + u32 length (DATA) or op + u32 offset + u32 length (COPY)
+            deltaHeader[headerUsed++] = *data++;
+            length--;
+            uint8_t op = deltaHeader[0];
+            size_t headerSize = (op == TALLY_OTA_DELTA_COPY) ? 9 : 5;
+            if (op != TALLY_OTA_DELTA_COPY && op != TALLY_OTA_DELTA_DATA) return false;
+            if (headerUsed < headerSize) continue;
+            headerUsed = 0;
+
+            if (op == TALLY_OTA_DELTA_DATA) {
+                memcpy(&deltaRemaining, &deltaHeader[1], 4);
+                deltaState = (deltaRemaining > 0) ? DELTA_DATA : DELTA_OP;
+            } else {
+                uint32_t baseOffset, copyLength;
+                memcpy(&baseOffset, &deltaHeader[1], 4);
+                memcpy(&copyLength, &deltaHeader[5], 4);
+                if (!copyFromBase(baseOffset, copyLength)) return false;
+            }
+        }
+        return true;
+    }
+
+    bool copyFromBase(uint32_t offset, uint32_t length) {
+        if (offset + length > image.baseSize) return false;
+
+        uint8_t block[256];
+        while (length > 0) {
+            size_t n = min((size_t)length, sizeof(block));
+            if (esp_partition_read(running, offset, block, n) != ESP_OK || !emit(block, n)) {
+                return false;
+            }
+            offset += n;
+            length -= n;
+        }
+        return true;
+    }
+
+    bool emit(const uint8_t* data, size_t length) {
+        if (written + length > image.imageSize) return false;
+        if (esp_ota_write(otaHandle, data, length) != ESP_OK) return false;
+        imageCrc = tallyCrc32(imageCrc, data, length);
+        written += length;
+        return true;
+    }
+
+    // Delta offers only apply on top of the exact image they were made from
+    bool baseMatches(const TallyOtaImage& offer) {
+        const esp_partition_t* base = esp_ota_get_running_partition();
+        if (base == nullptr || offer.baseSize > base->size) return false;
+
+        uint8_t block[256];
+        uint32_t crc = 0;
+        for (uint32_t offset = 0; offset < offer.baseSize; offset += sizeof(block)) {
+            size_t n = min((size_t)(offer.baseSize - offset), sizeof(block));
+            if (esp_partition_read(base, offset, block, n) != ESP_OK) return false;
+            crc = tallyCrc32(crc, block, n);
+        }
+        return crc == offer.baseCrc;
+    }
+
+    bool allocateBuffers(uint8_t flags) {
+        if (!(flags & TALLY_OTA_FLAG_COMPRESSED)) return true;
+
+        inflator = (tinfl_decompressor*)malloc(sizeof(tinfl_decompressor));
+        dictionary = (uint8_t*)malloc(TINFL_LZ_DICT_SIZE);
+        if (inflator == nullptr || dictionary == nullptr) return false;
+        tinfl_init(inflator);
+        dictOffset = 0;
+        inflateHasOutput = false;
+        return true;
+    }
+
+    void releaseBuffers() {
+        free(inflator);
+        free(dictionary);
+        inflator = nullptr;
+        dictionary = nullptr;
+    }
+
+    enum { DELTA_OP, DELTA_DATA };
+
+    TallyOtaImage image = {};
+    const esp_partition_t* running = nullptr;
+    const esp_partition_t* target = nullptr;
+    esp_ota_handle_t otaHandle = 0;
+    bool receiving = false;
+    bool complete = false;
+    PersistQueue* persist = nullptr;
+    uint32_t received = 0;           // Payload bytes accepted (next expected offset)
+    uint32_t written = 0;            // Image bytes written to flash
+    uint32_t imageCrc = 0;           // CRC32 of the image written so far
+
+    // Inflate state (compressed payloads only)
+    tinfl_decompressor* inflator = nullptr;
+    uint8_t* dictionary = nullptr;
+    size_t dictOffset = 0;
+    bool inflateHasOutput = false;
+
+    // Delta decoder state
+    uint8_t deltaState = DELTA_OP;
+    uint8_t deltaHeader[9];
+    size_t headerUsed = 0;
+    uint32_t deltaRemaining = 0;
+
+    unsigned long crcErrors = 0;
+    unsigned long resumes = 0;
+};
+
+#endif // TALLY_OTA_RECEIVER_H
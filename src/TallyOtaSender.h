@@ -0,0 +1,431 @@
+/*
+ * Tally OTA Sender for the ESP32 ATEM Tally System
+ *
+ * Bridge side of the tally firmware update: holds one tally image in flash
+ * and feeds it to every connected tally at once, each link at its own pace.
+ *
+ * - The image (TallyOtaImage header + payload, built by
+ *   tools/make_tally_ota.py) lives in the data partition named
+ *   TALLY_OTA_PARTITION, or in the bridge's spare OTA app partition
+ * - fetch() downloads it over HTTP a block per call, so the bridge keeps
+ *   polling the ATEM while it loads
+ * - Per link: offer -> RESUME(offset) -> windowed chunks, each with a CRC32
+ *   -> END -> DONE. A NACK or a stalled window goes back to the last
+ *   acknowledged offset; a tally that reconnects resumes where it stopped
+ * - nextMessage() is only called when a link has nothing else to send, so
+ *   live tally frames always go first
+ *
+ * Replies arrive on the BLE task; link state is guarded by a spinlock.
+ */
+
+#ifndef TALLY_OTA_SENDER_H
+#define TALLY_OTA_SENDER_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <esp_partition.h>
+#include <esp_ota_ops.h>
+#include "TallyProtocol.h"
+#include "TallyClock.h"
+
+#ifndef TALLY_OTA_PARTITION
+#define TALLY_OTA_PARTITION "tallyfw"         // Data partition for the tally image (else the spare app partition)
+#endif
+#ifndef TALLY_OTA_URL
+#define TALLY_OTA_URL "http://192.168.1.10/tally_ota.bin"  // Default image URL for OTA FETCH
+#endif
+#ifndef TALLY_OTA_WINDOW
+#define TALLY_OTA_WINDOW 2048                 // Unacknowledged payload bytes per link
+#endif
+#ifndef TALLY_OTA_REPLY_TIMEOUT
+#define TALLY_OTA_REPLY_TIMEOUT 2000          // Re-offer or rewind after this long without a reply (ms)
+#endif
+#ifndef TALLY_OTA_MAX_OFFERS
+#define TALLY_OTA_MAX_OFFERS 3                // Offers before a link is treated as not OTA-capable
+#endif
+
+typedef enum {
+    OTA_LINK_IDLE,           // No transfer (not offered yet, or OTA stopped)
+    OTA_LINK_OFFER,          // Offer due
+    OTA_LINK_OFFERED,        // Waiting for RESUME
+    OTA_LINK_SENDING,        // Sending chunks
+    OTA_LINK_ENDING,         // END sent, waiting for DONE
+    OTA_LINK_DONE,           // Tally verified the image
+    OTA_LINK_CURRENT,        // Tally already runs the image
+    OTA_LINK_FAILED          // Rejected, or no OTA characteristic
+} OtaLinkState;
+
+template <uint8_t MaxLinks>
+class TallyOtaSender {
+public:
+    TallyOtaSender() {
+        memset(transfers, 0, sizeof(transfers));
+        memset(&image, 0, sizeof(image));
+    }
+
+    // Find the image partition and load the stored header (call from setup)
+    void begin() {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                             TALLY_OTA_PARTITION);
+        if (partition == nullptr) {
+            partition = esp_ota_get_next_update_partition(nullptr);
+        }
+        loadImage();
+    }
+
+    bool hasImage() const { return imageValid; }
+    bool isActive() const { return active; }
+    bool isFetching() const { return fetching; }
+    const TallyOtaImage& getImage() const { return image; }
+    const esp_partition_t* getPartition() const { return partition; }
+
+    // Start downloading an image into the partition (continue with fetch())
+    bool startFetch(const String& url) {
+        if (partition == nullptr || fetching) return false;
+
+        stop();
+        imageValid = false;
+        if (!http.begin(url) || http.GET() != HTTP_CODE_OK) {
+            http.end();
+            return false;
+        }
+        fetchSize = http.getSize();
+        if (fetchSize < (int)sizeof(TallyOtaImage) || (size_t)fetchSize > partition->size) {
+            http.end();
+            return false;
+        }
+        fetched = 0;
+        erased = 0;
+        fetching = true;
+        return true;
+    }
+
+    // Copy whatever the download has ready into flash. Returns false once the
+    // download has finished (check hasImage() for the result).
+    bool fetch() {
+        if (!fetching) return false;
+
+        WiFiClient* stream = http.getStreamPtr();
+        uint8_t block[512];
+        while (fetched < fetchSize && stream->available() > 0) {
+            int n = stream->read(block, min((int)sizeof(block), fetchSize - fetched));
+            if (n <= 0) break;
+
+            // Erase sector by sector as the download reaches them
+            bool ok = true;
+            while (ok && erased < (size_t)(fetched + n)) {
+                ok = esp_partition_erase_range(partition, erased, SPI_FLASH_SEC_SIZE) == ESP_OK;
+                erased += SPI_FLASH_SEC_SIZE;
+            }
+            if (!ok || esp_partition_write(partition, fetched, block, n) != ESP_OK) {
+                fetched = -1;
+                break;
+            }
+            fetched += n;
+        }
+
+        if (fetched >= 0 && fetched < fetchSize && http.connected()) {
+            return true; // More to come
+        }
+        http.end();
+        fetching = false;
+        if (fetched == fetchSize) {
+            loadImage();
+        }
+        return false;
+    }
+
+    int getFetchProgress() const {
+        return (fetchSize > 0 && fetched > 0) ? (int)(100LL * fetched / fetchSize) : 0;
+    }
+
+    // Offer the image to every ready link (and links that become ready later)
+    bool start() {
+        if (!imageValid) return false;
+
+        portENTER_CRITICAL(&lock);
+        for (int i = 0; i < MaxLinks; i++) {
+            transfers[i].state = transfers[i].ready ? OTA_LINK_OFFER : OTA_LINK_IDLE;
+            transfers[i].offers = 0;
+        }
+        active = true;
+        startedAt = clockMillis();
+        finishedAt = 0;
+        updated = 0;
+        current = 0;
+        failed = 0;
+        portEXIT_CRITICAL(&lock);
+        return true;
+    }
+
+    void stop() {
+        portENTER_CRITICAL(&lock);
+        active = false;
+        for (int i = 0; i < MaxLinks; i++) {
+            transfers[i].state = OTA_LINK_IDLE;
+        }
+        portEXIT_CRITICAL(&lock);
+    }
+
+    // A tally registered on the link (it has subscribed by now)
+    void onLinkReady(int link) {
+        if (link < 0 || link >= MaxLinks) return;
+
+        portENTER_CRITICAL(&lock);
+        Transfer& t = transfers[link];
+        t.ready = true;
+        if (active && t.state == OTA_LINK_IDLE) {
+            t.state = OTA_LINK_OFFER;
+            t.offers = 0;
+        }
+        portEXIT_CRITICAL(&lock);
+    }
+
+    void onLinkDown(int link) {
+        if (link < 0 || link >= MaxLinks) return;
+
+        portENTER_CRITICAL(&lock);
+        transfers[link].ready = false;
+        transfers[link].state = OTA_LINK_IDLE;
+        portEXIT_CRITICAL(&lock);
+    }
+
+    // Build the link's next notification into buffer (at most capacity
+    // bytes). Returns its length, 0 if the link has nothing to send now.
+    size_t nextMessage(int link, uint8_t* buffer, size_t capacity) {
+        if (!active || link < 0 || link >= MaxLinks || capacity < 1 + sizeof(TallyOtaImage)) {
+            return 0;
+        }
+
+        unsigned long now = clockMillis();
+        uint32_t offset;
+        size_t length;
+
+        portENTER_CRITICAL(&lock);
+        Transfer& t = transfers[link];
+        bool replyOverdue = now - t.lastReply > TALLY_OTA_REPLY_TIMEOUT;
+
+        if (t.state == OTA_LINK_OFFERED && replyOverdue) {
+            t.state = (t.offers < TALLY_OTA_MAX_OFFERS) ? OTA_LINK_OFFER : OTA_LINK_FAILED;
+            if (t.state == OTA_LINK_FAILED) failed++;
+        }
+        if ((t.state == OTA_LINK_SENDING || t.state == OTA_LINK_ENDING) && replyOverdue) {
+            t.state = OTA_LINK_SENDING; // Stalled - go back to the last acknowledged byte
+            t.sendOffset = t.ackedOffset;
+            t.lastReply = now;
+            rewinds++;
+        }
+
+        if (t.state == OTA_LINK_OFFER) {
+            t.state = OTA_LINK_OFFERED;
+            t.offers++;
+            t.lastReply = now;
+            portEXIT_CRITICAL(&lock);
+            buffer[0] = TALLY_OTA_OFFER;
+            memcpy(&buffer[1], &image, sizeof(image));
+            return 1 + sizeof(image);
+        }
+
+        if (t.state != OTA_LINK_SENDING) {
+            portEXIT_CRITICAL(&lock);
+            return 0;
+        }
+
+        if (t.sendOffset >= image.payloadSize) {
+            bool allAcked = t.ackedOffset >= image.payloadSize;
+            if (allAcked) {
+                t.state = OTA_LINK_ENDING;
+                t.lastReply = now;
+            }
+            portEXIT_CRITICAL(&lock);
+            if (!allAcked) return 0;
+            buffer[0] = TALLY_OTA_END;
+            return 1;
+        }
+        if (t.sendOffset - t.ackedOffset >= TALLY_OTA_WINDOW) {
+            portEXIT_CRITICAL(&lock);
+            return 0; // Window full - wait for ACKs
+        }
+
+        offset = t.sendOffset;
+        length = min((size_t)(image.payloadSize - offset), capacity - 1 - sizeof(TallyOtaChunk));
+        t.sendOffset += length;
+        portEXIT_CRITICAL(&lock);
+
+        // Flash read outside the lock
+        TallyOtaChunk chunk;
+        uint8_t* data = &buffer[1 + sizeof(chunk)];
+        if (esp_partition_read(partition, sizeof(TallyOtaImage) + offset, data, length) != ESP_OK) {
+            rewind(link, offset);
+            return 0;
+        }
+        chunk.offset = offset;
+        chunk.crc = tallyCrc32(0, data, length);
+        buffer[0] = TALLY_OTA_DATA;
+        memcpy(&buffer[1], &chunk, sizeof(chunk));
+        chunksSent++;
+        bytesSent += length;
+        return 1 + sizeof(chunk) + length;
+    }
+
+    // The stack refused a chunk - send it again from offset
+    void rewind(int link, uint32_t offset) {
+        if (link < 0 || link >= MaxLinks) return;
+
+        portENTER_CRITICAL(&lock);
+        if (transfers[link].state == OTA_LINK_SENDING && offset < transfers[link].sendOffset) {
+            transfers[link].sendOffset = offset;
+        }
+        portEXIT_CRITICAL(&lock);
+    }
+
+    // Reply written by the tally (BLE task). Returns true when the link's
+    // transfer just finished.
+    bool onReply(int link, const uint8_t* data, size_t length) {
+        if (link < 0 || link >= MaxLinks || length < sizeof(TallyOtaReply)) return false;
+
+        TallyOtaReply reply;
+        memcpy(&reply, data, sizeof(reply));
+        bool finished = false;
+
+        portENTER_CRITICAL(&lock);
+        Transfer& t = transfers[link];
+        t.lastReply = clockMillis();
+        switch (reply.type) {
+            case TALLY_OTA_RESUME:
+                if (t.state == OTA_LINK_OFFERED && reply.value <= image.payloadSize) {
+                    t.state = OTA_LINK_SENDING;
+                    t.sendOffset = reply.value;
+                    t.ackedOffset = reply.value;
+                }
+                break;
+            case TALLY_OTA_ACK:
+                // The tally may be ahead of a rewind - continue from its offset
+                if (reply.value > t.ackedOffset && reply.value <= image.payloadSize) {
+                    t.ackedOffset = reply.value;
+                    if (t.sendOffset < reply.value) {
+                        t.sendOffset = reply.value;
+                    }
+                }
+                break;
+            case TALLY_OTA_NACK:
+                if (t.state == OTA_LINK_SENDING || t.state == OTA_LINK_ENDING) {
+                    t.state = OTA_LINK_SENDING;
+                    t.ackedOffset = reply.value;
+                    t.sendOffset = reply.value;
+                    rewinds++;
+                }
+                break;
+            case TALLY_OTA_REJECT:
+                if (t.state != OTA_LINK_IDLE) {
+                    t.state = (reply.value == TALLY_OTA_REASON_CURRENT) ? OTA_LINK_CURRENT : OTA_LINK_FAILED;
+                    t.lastResult = reply.value;
+                    if (t.state == OTA_LINK_CURRENT) current++; else failed++;
+                    finished = true;
+                }
+                break;
+            case TALLY_OTA_DONE:
+                if (t.state == OTA_LINK_ENDING && reply.value == image.imageCrc) {
+                    t.state = OTA_LINK_DONE;
+                    updated++;
+                    finished = true;
+                }
+                break;
+        }
+        if (finished && active && !transferRunning()) {
+            finishedAt = t.lastReply;
+        }
+        portEXIT_CRITICAL(&lock);
+        return finished;
+    }
+
+    OtaLinkState getLinkState(int link) const { return (OtaLinkState)transfers[link].state; }
+    uint32_t getLinkAcked(int link) const { return transfers[link].ackedOffset; }
+    uint32_t getLinkResult(int link) const { return transfers[link].lastResult; }
+    unsigned long getUpdated() const { return updated; }
+    unsigned long getCurrent() const { return current; }
+    unsigned long getFailed() const { return failed; }
+    unsigned long getRewinds() const { return rewinds; }
+    unsigned long getChunksSent() const { return chunksSent; }
+    unsigned long getBytesSent() const { return bytesSent; }
+
+    // Fleet time: OTA START until the last running transfer finished (0 = still running)
+    unsigned long getFleetTime() const {
+        return finishedAt ? finishedAt - startedAt : 0;
+    }
+    unsigned long getElapsed() const {
+        return active ? clockMillis() - startedAt : 0;
+    }
+
+    static const char* stateName(OtaLinkState state) {
+        switch (state) {
+            case OTA_LINK_IDLE:    return "idle";
+            case OTA_LINK_OFFER:
+            case OTA_LINK_OFFERED: return "offered";
+            case OTA_LINK_SENDING: return "sending";
+            case OTA_LINK_ENDING:  return "verifying";
+            case OTA_LINK_DONE:    return "updated";
+            case OTA_LINK_CURRENT: return "current";
+            case OTA_LINK_FAILED:  return "failed";
+        }
+        return "?";
+    }
+
+private:
+    struct Transfer {
+        uint8_t state;               // OtaLinkState
+        bool ready;                  // Tally registered on this link
+        uint8_t offers;
+        uint32_t sendOffset;         // Next payload byte to send
+        uint32_t ackedOffset;        // Payload bytes the tally confirmed
+        uint32_t lastResult;         // Reject reason
+        unsigned long lastReply;     // Last reply (or offer/rewind) time
+    };
+
+    // Any link still offered or transferring (call with the lock held)
+    bool transferRunning() const {
+        for (int i = 0; i < MaxLinks; i++) {
+            uint8_t s = transfers[i].state;
+            if (s == OTA_LINK_OFFER || s == OTA_LINK_OFFERED ||
+                s == OTA_LINK_SENDING || s == OTA_LINK_ENDING) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void loadImage() {
+        imageValid = false;
+        if (partition == nullptr) return;
+
+        if (esp_partition_read(partition, 0, &image, sizeof(image)) == ESP_OK &&
+            image.magic == TALLY_OTA_IMAGE_MAGIC &&
+            sizeof(image) + image.payloadSize <= partition->size) {
+            imageValid = true;
+        }
+    }
+
+    const esp_partition_t* partition = nullptr;
+    TallyOtaImage image;
+    bool imageValid = false;
+
+    HTTPClient http;
+    bool fetching = false;
+    int fetchSize = 0;
+    int fetched = 0;
+    size_t erased = 0;
+
+    Transfer transfers[MaxLinks];
+    bool active = false;
+    unsigned long startedAt = 0;
+    unsigned long finishedAt = 0;
+    unsigned long updated = 0;
+    unsigned long current = 0;
+    unsigned long failed = 0;
+    unsigned long rewinds = 0;
+    unsigned long chunksSent = 0;
+    unsigned long bytesSent = 0;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif // TALLY_OTA_SENDER_H
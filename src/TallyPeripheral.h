@@ -0,0 +1,97 @@
+/*
+ * Peripheral-Role Tally Link for the ESP32 ATEM Tally System
+ *
+ * Tally side of the central topology (bridge built with BRIDGE_CENTRAL 1):
+ * instead of scanning for the bridge, the tally advertises
+ * TALLY_PERIPHERAL_SERVICE_UUID and waits for the bridge to connect.
+ *
+ * - The registration characteristic holds the tally's TALLY_REG string,
+ *   read by the bridge right after it connects
+ * - The bridge writes frames and containers (same format as notifications)
+ *   to the frame characteristic without response
+ * - Advertising restarts as soon as the bridge drops the link
+ *
+ * Frame and link handlers run on the BLE task - hand work to the loop.
+ */
+
+#ifndef TALLY_PERIPHERAL_H
+#define TALLY_PERIPHERAL_H
+
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLEUtils.h>
+#include "TallyProtocol.h"
+
+typedef void (*TallyFrameHandler)(const uint8_t* data, size_t length);
+typedef void (*TallyLinkHandler)(bool connected);
+
+class TallyPeripheral : public BLEServerCallbacks, public BLECharacteristicCallbacks {
+public:
+    // Create the service and start advertising (call after BLEDevice::init)
+    void begin(const String& registration, TallyFrameHandler frameHandler, TallyLinkHandler linkHandler) {
+        onFrames = frameHandler;
+        onLink = linkHandler;
+
+        pServer = BLEDevice::createServer();
+        pServer->setCallbacks(this);
+        BLEService* service = pServer->createService(TALLY_PERIPHERAL_SERVICE_UUID);
+
+        BLECharacteristic* frames = service->createCharacteristic(
+                                    TALLY_FRAME_UUID,
+                                    BLECharacteristic::PROPERTY_WRITE |
+                                    BLECharacteristic::PROPERTY_WRITE_NR
+                                  );
+        frames->setCallbacks(this);
+
+        pRegistration = service->createCharacteristic(
+                        TALLY_REGISTRATION_UUID,
+                        BLECharacteristic::PROPERTY_READ
+                      );
+        pRegistration->setValue(registration.c_str());
+        service->start();
+
+        BLEAdvertising* advertising = BLEDevice::getAdvertising();
+        advertising->addServiceUUID(TALLY_PERIPHERAL_SERVICE_UUID);
+        advertising->setMinPreferred(0x0);
+        BLEDevice::startAdvertising();
+    }
+
+    bool isConnected() const { return connected; }
+    unsigned long getWrites() const { return writes; }
+
+    void disconnect() {
+        if (connected) {
+            pServer->disconnect(connId);
+        }
+    }
+
+private:
+    void onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param) {
+        connId = param->connect.conn_id;
+        connected = true;
+        onLink(true);
+    }
+
+    void onDisconnect(BLEServer* server, esp_ble_gatts_cb_param_t* param) {
+        connected = false;
+        onLink(false);
+        BLEDevice::startAdvertising();
+    }
+
+    void onWrite(BLECharacteristic* characteristic) {
+        std::string value = characteristic->getValue();
+        writes++;
+        onFrames((const uint8_t*)value.data(), value.length());
+    }
+
+    BLEServer* pServer = nullptr;
+    BLECharacteristic* pRegistration = nullptr;
+    TallyFrameHandler onFrames = nullptr;
+    TallyLinkHandler onLink = nullptr;
+    volatile bool connected = false;
+    uint16_t connId = 0;
+    unsigned long writes = 0;
+};
+
+#endif // TALLY_PERIPHERAL_H
@@ -0,0 +1,140 @@
+/*
+ * Addressable Pixel Output for the ESP32 ATEM Tally System
+ *
+ * Drives a WS2812-style LED strip (camera-top or talent-facing) from the
+ * RMT peripheral, so strips show the same state as the tally's RGB LED.
+ *
+ * - The frame buffer holds one GRB triple per pixel; fill()/setPixel() mark
+ *   it dirty only when a value changes
+ * - show() encodes a dirty frame into RMT items (one per bit, plus a latch)
+ *   and starts the transfer without waiting - the RMT driver refills the
+ *   channel memory from the item buffer in its interrupt
+ * - Unchanged frames are never re-encoded or re-sent, so a solid tally
+ *   state costs nothing after the first frame
+ *
+ * Bit timing is at PIXEL_RMT_CLK_DIV (25 ns ticks); encodePixelBits() is the
+ * whole pulse model and has no hardware dependency.
+ */
+
+#ifndef TALLY_PIXELS_H
+#define TALLY_PIXELS_H
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+#include "TallyProtocol.h"
+
+#define PIXEL_RMT_CLK_DIV 2                   // 80 MHz APB / 2 = 25 ns per tick
+#define PIXEL_T0H_TICKS 16                    // 0 bit high time (0.40 us)
+#define PIXEL_T0L_TICKS 34                    // 0 bit low time (0.85 us)
+#define PIXEL_T1H_TICKS 32                    // 1 bit high time (0.80 us)
+#define PIXEL_T1L_TICKS 18                    // 1 bit low time (0.45 us)
+#define PIXEL_RESET_TICKS 12000               // Latch low time after a frame (300 us, WS2812B needs > 280 us)
+#define PIXEL_TX_TIMEOUT 20                   // Longest wait for the previous frame to leave (ms)
+
+// Encode GRB bytes into RMT items, MSB first, followed by the latch item.
+// items must hold length * 8 + 1 entries. Returns the number of items.
+inline TALLY_IRAM size_t encodePixelBits(const uint8_t* data, size_t length, rmt_item32_t* items) {
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        for (uint8_t mask = 0x80; mask != 0; mask >>= 1) {
+            bool one = (data[i] & mask) != 0;
+            items[count].level0 = 1;
+            items[count].duration0 = one ? PIXEL_T1H_TICKS : PIXEL_T0H_TICKS;
+            items[count].level1 = 0;
+            items[count].duration1 = one ? PIXEL_T1L_TICKS : PIXEL_T0L_TICKS;
+            count++;
+        }
+    }
+
+    // Latch: hold the line low, then end the transfer (duration 0)
+    items[count].level0 = 0;
+    items[count].duration0 = PIXEL_RESET_TICKS;
+    items[count].level1 = 0;
+    items[count].duration1 = 0;
+    return count + 1;
+}
+
+template <uint16_t NumPixels>
+class TallyPixels {
+public:
+    static_assert(NumPixels > 0, "A pixel strip needs at least one pixel");
+
+    TallyPixels() {
+        memset(pixels, 0, sizeof(pixels));
+    }
+
+    // Configure the RMT channel for the strip's data pin (pin < 0 = not fitted)
+    bool begin(int pin, rmt_channel_t rmtChannel) {
+        if (pin < 0) return false;
+
+        rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)pin, rmtChannel);
+        config.clk_div = PIXEL_RMT_CLK_DIV;
+        config.tx_config.idle_output_en = true;
+        config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+        if (rmt_config(&config) != ESP_OK || rmt_driver_install(rmtChannel, 0, 0) != ESP_OK) {
+            return false;
+        }
+
+        channel = rmtChannel;
+        enabled = true;
+        dirty = true;
+        return true;
+    }
+
+    void setPixel(uint16_t index, uint8_t red, uint8_t green, uint8_t blue) {
+        if (index >= NumPixels) return;
+        uint8_t* p = &pixels[index * 3];
+        if (p[0] != green || p[1] != red || p[2] != blue) {
+            p[0] = green;
+            p[1] = red;
+            p[2] = blue;
+            dirty = true;
+        }
+    }
+
+    void fill(uint8_t red, uint8_t green, uint8_t blue) {
+        for (uint16_t i = 0; i < NumPixels; i++) {
+            setPixel(i, red, green, blue);
+        }
+    }
+
+    // Send the frame if it changed since the last one. Only waits when the
+    // previous frame is still on the wire (back-to-back changes, under 1 ms
+    // for short strips).
+    bool show() {
+        if (!enabled) return false;
+        if (!dirty) {
+            framesSkipped++;
+            return false;
+        }
+
+        if (rmt_wait_tx_done(channel, pdMS_TO_TICKS(PIXEL_TX_TIMEOUT)) != ESP_OK) {
+            return false; // Still dirty - sent with the next update
+        }
+        size_t count = encodePixelBits(pixels, sizeof(pixels), items);
+        if (rmt_write_items(channel, items, count, false) != ESP_OK) {
+            return false;
+        }
+
+        dirty = false;
+        framesSent++;
+        return true;
+    }
+
+    bool isEnabled() const { return enabled; }
+    uint16_t getPixelCount() const { return NumPixels; }
+    const uint8_t* getFrame() const { return pixels; }   // GRB, wire order
+    unsigned long getFramesSent() const { return framesSent; }
+    unsigned long getFramesSkipped() const { return framesSkipped; }
+
+private:
+    uint8_t pixels[NumPixels * 3];            // GRB, wire order
+    rmt_item32_t items[NumPixels * 24 + 1];   // Encoded frame (read by the RMT interrupt)
+    rmt_channel_t channel = RMT_CHANNEL_0;
+    bool enabled = false;
+    bool dirty = true;
+    unsigned long framesSent = 0;
+    unsigned long framesSkipped = 0;
+};
+
+#endif // TALLY_PIXELS_H
@@ -0,0 +1,325 @@
+/*
+ * Tally Protocol for the ESP32 ATEM Tally System
+ *
+ * BLE wire format shared by every bridge build and the tally lights.
+ *
+ * - One packed TallyMessage per frame, checksummed
+ * - cameraId 0 is a heartbeat/status frame
+ * - Tally flags follow the ATEM convention: bit 0 = PROGRAM, bit 1 = PREVIEW
+ * - A notification carries either one bare TallyMessage or, once both sides
+ *   have negotiated a larger ATT MTU, a container of several frames:
+ *
+ *     TALLY_BATCH_MARKER, { length, frame[length] } ...
+ *
+ *   The marker can never be a valid cameraId, so bare frames from older
+ *   bridges still decode. Frames with an unknown length are skipped.
+ * - The bridge's snapshot characteristic holds the same container with the
+ *   status frame and every camera, for a tally to read right after it
+ *   subscribes
+ * - The bridge's scan response carries a TallyAdvertisement (manufacturer
+ *   data) with the ATEM status and program/preview bitmaps, so a tally can
+ *   show on-air state from the first advert it hears
+ * - Tally firmware updates use their own OTA characteristic: the bridge
+ *   notifies an offer and CRC-checked chunks, the tally writes replies
+ * - In the central topology (BRIDGE_CENTRAL) the roles swap: tallies
+ *   advertise TALLY_PERIPHERAL_SERVICE_UUID, the bridge connects, reads the
+ *   TALLY_REG string and writes the same frames/containers without response
+ */
+
+#ifndef TALLY_PROTOCOL_H
+#define TALLY_PROTOCOL_H
+
+#include <Arduino.h>
+
+#define TALLY_FLAG_PROGRAM 0x01               // Camera is on PROGRAM (live)
+#define TALLY_FLAG_PREVIEW 0x02               // Camera is on PREVIEW
+
+#define TALLY_BLE_MTU 247                     // ATT MTU requested by bridge and tally (one LL packet with DLE)
+#define TALLY_DEFAULT_MTU 23                  // ATT MTU before negotiation
+#define TALLY_BATCH_MARKER 0xB7               // First byte of a multi-frame container
+
+// Hot path placement: the small leaf helpers every frame passes through
+// (checksum, container pack/unpack, pixel bit encoding) run from IRAM. Task
+// code calling them is suspended during a flash write anyway, so IRAM only
+// buys the leaves freedom from cache misses - it is not spent on callers
+#ifndef TALLY_IRAM
+#define TALLY_IRAM IRAM_ATTR
+#endif
+
+// Bridge service layout (frame, snapshot and OTA characteristics in creation
+// order) - bump it whenever the bridge's service gains, loses or reorders
+// attributes. The bridge advertises it (TallyAdvertisement.gatt, with
+// TALLY_GATT_OTA when the OTA characteristic is built in) and tallies key
+// their cached GATT handles on the advertised value.
+#define TALLY_GATT_LAYOUT 1
+#define TALLY_GATT_OTA 0x80                   // gatt bit: service includes the OTA characteristic
+
+// Central topology: GATT service on the tally
+#define TALLY_PERIPHERAL_SERVICE_UUID "12345678-1234-5678-9abc-123456789abd"
+#define TALLY_FRAME_UUID "87654321-4321-8765-cba9-987654321cbd"          // Bridge writes frames (no response)
+#define TALLY_REGISTRATION_UUID "87654321-4321-8765-cba9-987654321cbe"   // Bridge reads "TALLY_REG:..."
+
+// BLE tally message structure
+typedef struct {
+    uint8_t cameraId;        // Camera number (1-20) or 0 for heartbeat
+    char state[12];          // "PREVIEW", "PROGRAM", "OFF", "STANDBY", "HEARTBEAT", "NO_ATEM"
+    uint32_t timestamp;      // Message timestamp for debugging
+    uint8_t bridgeId;        // Bridge identifier (for multiple bridges)
+    uint8_t bridgeStatus;    // Bridge status: TALLY_BRIDGE_* bits (0 = No ATEM)
+    uint8_t checksum;        // Simple checksum for data integrity
+} __attribute__((packed)) TallyMessage;
+
+// Bridge status bits (TallyMessage.bridgeStatus)
+#define TALLY_BRIDGE_ATEM 0x01                // Tally states are valid
+#define TALLY_BRIDGE_UNCONFIRMED 0x02         // ATEM link lost - last known states, resuming
+
+// Calculate simple checksum for message integrity
+inline TALLY_IRAM uint8_t calculateChecksum(TallyMessage* msg) {
+    uint8_t checksum = 0;
+    checksum ^= msg->cameraId;
+    checksum ^= msg->bridgeId;
+    checksum ^= msg->bridgeStatus;
+    for (int i = 0; i < strlen(msg->state); i++) {
+        checksum ^= msg->state[i];
+    }
+    return checksum;
+}
+
+// Tally side: true if the frame's checksum matches its contents
+inline bool verifyTallyMessage(TallyMessage* msg) {
+    return calculateChecksum(msg) == msg->checksum;
+}
+
+// Parse "TALLY_REG:1:Tally_CAM_1" with optional heartbeat period ":250". The
+// name is cut to nameSize - 1 characters; the period is clamped to
+// [minInterval, defaultInterval], defaultInterval when none is requested.
+inline bool parseTallyRegistration(const char* message, uint8_t& cameraId, char* name, size_t nameSize,
+                                   uint16_t& heartbeatInterval, uint16_t minInterval, uint16_t defaultInterval) {
+    if (strncmp(message, "TALLY_REG:", 10) != 0) return false;
+
+    const char* firstColon = strchr(message + 10, ':');
+    if (firstColon == nullptr) return false;
+    const char* secondColon = strchr(firstColon + 1, ':');
+
+    cameraId = atoi(message + 10);
+    size_t nameLength = secondColon ? (size_t)(secondColon - firstColon - 1) : strlen(firstColon + 1);
+    nameLength = min(nameLength, nameSize - 1);
+    memcpy(name, firstColon + 1, nameLength);
+    name[nameLength] = '\0';
+
+    long requestedInterval = secondColon ? atol(secondColon + 1) : 0;
+    heartbeatInterval = defaultInterval;
+    if (requestedInterval > 0) {
+        heartbeatInterval = (uint16_t)max((long)minInterval, min(requestedInterval, (long)defaultInterval));
+    }
+    return true;
+}
+
+// Most frames that fit one notification at TALLY_BLE_MTU
+#define TALLY_MAX_BATCH_FRAMES ((TALLY_BLE_MTU - 3 - 1) / (1 + sizeof(TallyMessage)))
+
+// Snapshot characteristic: one container with the status frame (cameraId 0)
+// and every camera, read with a long read (GATT attribute limit 600 bytes)
+#define TALLY_SNAPSHOT_MAX_LENGTH 600
+#define TALLY_SNAPSHOT_MAX_FRAMES ((TALLY_SNAPSHOT_MAX_LENGTH - 1) / (1 + sizeof(TallyMessage)))
+
+// A bare frame must fit a notification before the MTU exchange
+static_assert(sizeof(TallyMessage) <= TALLY_DEFAULT_MTU - 3, "TallyMessage must fit the default ATT MTU");
+
+// Container capacity for one notification at this ATT MTU. Below a
+// one-frame container (the default MTU) this is the one-frame container,
+// sent bare from offset 2 - so every link gets frames, one per notification.
+inline size_t tallyNotifyCapacity(uint16_t mtu) {
+    size_t capacity = (mtu > 3) ? mtu - 3 : 0;
+    return max(capacity, 2 + sizeof(TallyMessage));
+}
+
+// Append a frame to a container of at most capacity bytes (starts the
+// container when used is 0). Returns false, leaving it unchanged, if full.
+inline TALLY_IRAM bool packTallyFrame(uint8_t* buffer, size_t& used, size_t capacity, const TallyMessage* msg) {
+    size_t start = (used == 0) ? 1 : used;
+    if (start + 1 + sizeof(TallyMessage) > capacity) return false;
+
+    buffer[0] = TALLY_BATCH_MARKER;
+    buffer[start] = sizeof(TallyMessage);
+    memcpy(&buffer[start + 1], msg, sizeof(TallyMessage));
+    used = start + 1 + sizeof(TallyMessage);
+    return true;
+}
+
+// Split a notification into frames (bare frame or container). Returns the
+// number of frames copied, 0 if the notification is malformed.
+inline TALLY_IRAM int unpackTallyFrames(const uint8_t* data, size_t length, TallyMessage* frames, int maxFrames) {
+    if (length == sizeof(TallyMessage) && data[0] != TALLY_BATCH_MARKER) {
+        memcpy(&frames[0], data, sizeof(TallyMessage));
+        return 1;
+    }
+    if (length < 1 || data[0] != TALLY_BATCH_MARKER) return 0;
+
+    int count = 0;
+    size_t pos = 1;
+    while (pos < length && count < maxFrames) {
+        uint8_t frameLength = data[pos];
+        if (pos + 1 + frameLength > length) break; // Truncated
+        if (frameLength == sizeof(TallyMessage)) {
+            memcpy(&frames[count++], &data[pos + 1], sizeof(TallyMessage));
+        }
+        pos += 1 + frameLength;
+    }
+    return count;
+}
+
+// One notification built from a link's pending frames
+typedef struct {
+    uint8_t buffer[TALLY_BLE_MTU - 3];
+    uint8_t slots[TALLY_MAX_BATCH_FRAMES];   // Frame slots taken, newest first
+    uint32_t seqs[TALLY_MAX_BATCH_FRAMES];   // Their queue order, to requeue on a failed send
+    int count;                               // Frames taken (0 = nothing pending)
+    const uint8_t* data;                     // Bare frame or container in buffer
+    size_t length;
+} TallyNotification;
+
+// Mark a frame slot pending for a link's next notification. An unsent frame
+// for the same slot is superseded (returns true) - the notification carries
+// whatever the slot holds when it is built.
+inline bool queueTallyFrame(uint32_t* queuedSeq, uint8_t slot, uint32_t& queueSeq) {
+    bool superseded = queuedSeq[slot] != 0;
+    queuedSeq[slot] = ++queueSeq;
+    return superseded;
+}
+
+// Take pending frames newest first until one notification of at most
+// capacity bytes (tallyNotifyCapacity()) is full. queuedSeq[slot] is the
+// queue order of the slot's pending frame (0 = none) and is cleared for every
+// frame taken. A lone frame goes out bare (it follows the container's marker
+// and length bytes) - always the case at the default MTU. Returns n.count.
+inline int packTallyNotification(TallyNotification& n, size_t capacity, const TallyMessage* frames,
+                                 uint32_t* queuedSeq, int slotCount) {
+    capacity = min(capacity, sizeof(n.buffer));
+    size_t used = 0;
+    n.count = 0;
+    while (n.count < (int)TALLY_MAX_BATCH_FRAMES) {
+        int newest = -1;
+        for (int slot = 0; slot < slotCount; slot++) {
+            if (queuedSeq[slot] != 0 && (newest < 0 || queuedSeq[slot] > queuedSeq[newest])) {
+                newest = slot;
+            }
+        }
+        if (newest < 0 || !packTallyFrame(n.buffer, used, capacity, &frames[newest])) {
+            break;
+        }
+        n.slots[n.count] = newest;
+        n.seqs[n.count++] = queuedSeq[newest];
+        queuedSeq[newest] = 0;
+    }
+    n.data = (n.count == 1) ? &n.buffer[2] : n.buffer;
+    n.length = (n.count == 1) ? sizeof(TallyMessage) : used;
+    return n.count;
+}
+
+// Advertised tally state (manufacturer-specific data in the scan response)
+#define TALLY_ADV_COMPANY_ID 0xFFFF           // Bluetooth SIG "no company" ID for unregistered use
+#define TALLY_ADV_VERSION 1                   // Advertisement layout version
+#define TALLY_ADV_STATUS_ATEM 0x01            // status bit: bridge is connected to the ATEM
+#define TALLY_ADV_STATUS_UNCONFIRMED 0x02     // status bit: ATEM link lost, last known states
+
+typedef struct {
+    uint16_t companyId;      // TALLY_ADV_COMPANY_ID (little-endian, as on air)
+    uint8_t version;         // TALLY_ADV_VERSION
+    uint8_t status;          // TALLY_ADV_STATUS_* bits
+    uint8_t sequence;        // Incremented whenever the advertised state changes
+    uint32_t program;        // Bit n = camera n+1 shows PROGRAM
+    uint32_t preview;        // Bit n = camera n+1 shows PREVIEW (including standby)
+    uint8_t gatt;            // TALLY_GATT_LAYOUT | TALLY_GATT_OTA (0 = not advertised)
+} __attribute__((packed)) TallyAdvertisement;
+
+// Adverts from bridges before the gatt byte end after preview
+#define TALLY_ADV_MIN_LENGTH (sizeof(TallyAdvertisement) - 1)
+
+// Decode manufacturer data from a bridge advert. Returns false if it is not a
+// tally advertisement of a known version.
+inline bool decodeTallyAdvertisement(const uint8_t* data, size_t length, TallyAdvertisement* adv) {
+    if (length < TALLY_ADV_MIN_LENGTH) return false;
+    memset(adv, 0, sizeof(TallyAdvertisement));
+    memcpy(adv, data, min(length, sizeof(TallyAdvertisement)));
+    return adv->companyId == TALLY_ADV_COMPANY_ID && adv->version == TALLY_ADV_VERSION;
+}
+
+// ===============================================
+// OTA FIRMWARE DISTRIBUTION
+// ===============================================
+//
+// Bridge -> tally (notifications):
+//   TALLY_OTA_OFFER, TallyOtaImage
+//   TALLY_OTA_DATA, TallyOtaChunk, payload[...]
+//   TALLY_OTA_END
+// Tally -> bridge (writes): TallyOtaReply
+//   RESUME(offset) - accept the offer, send the payload from offset
+//   ACK(offset)    - payload received up to offset
+//   NACK(offset)   - chunk missing or corrupt, resend from offset
+//   REJECT(reason) - TALLY_OTA_REASON_*
+//   DONE(imageCrc) - image verified and marked for boot
+//
+// The payload is the firmware image, optionally a delta against the image
+// the tally is running, optionally raw-deflate compressed (delta first).
+// Delta ops: COPY (u8 op, u32 baseOffset, u32 length) copies from the running
+// image, DATA (u8 op, u32 length, bytes) inserts new bytes.
+
+#define TALLY_OTA_IMAGE_MAGIC 0x41544F54      // "TOTA" - image header magic
+#define TALLY_OTA_FLAG_COMPRESSED 0x01        // Payload is raw deflate
+#define TALLY_OTA_FLAG_DELTA 0x02             // (Decompressed) payload is a delta against the base image
+
+#define TALLY_OTA_OFFER 0x01
+#define TALLY_OTA_DATA 0x02
+#define TALLY_OTA_END 0x03
+#define TALLY_OTA_RESUME 0x81
+#define TALLY_OTA_ACK 0x82
+#define TALLY_OTA_NACK 0x83
+#define TALLY_OTA_REJECT 0x84
+#define TALLY_OTA_DONE 0x85
+
+#define TALLY_OTA_REASON_CURRENT 1            // Already running this image
+#define TALLY_OTA_REASON_BASE 2               // Delta does not apply to the running image
+#define TALLY_OTA_REASON_RESOURCES 3          // No update partition or memory
+#define TALLY_OTA_REASON_CORRUPT 4            // Payload does not decode or image CRC mismatch
+
+#define TALLY_OTA_DELTA_COPY 0x01
+#define TALLY_OTA_DELTA_DATA 0x02
+
+// Image header (stored ahead of the payload on the bridge, sent in the offer)
+typedef struct {
+    uint32_t magic;          // TALLY_OTA_IMAGE_MAGIC
+    uint32_t imageCrc;       // CRC32 of the firmware image the tally ends up with
+    uint32_t imageSize;      // Firmware image bytes
+    uint32_t payloadSize;    // Bytes transferred
+    uint32_t baseCrc;        // Delta only: CRC32 of the first baseSize bytes of the running image
+    uint32_t baseSize;
+    uint8_t flags;           // TALLY_OTA_FLAG_*
+} __attribute__((packed)) TallyOtaImage;
+
+typedef struct {
+    uint32_t offset;         // Payload offset of the first data byte
+    uint32_t crc;            // CRC32 of the chunk's data
+} __attribute__((packed)) TallyOtaChunk;
+
+typedef struct {
+    uint8_t type;            // TALLY_OTA_RESUME ... TALLY_OTA_DONE
+    uint32_t value;          // Offset, reason or image CRC
+} __attribute__((packed)) TallyOtaReply;
+
+// Smallest ATT MTU that carries an offer (OTA waits for the MTU exchange)
+#define TALLY_OTA_MIN_MTU (3 + 1 + sizeof(TallyOtaImage))
+
+// CRC32 (IEEE 802.3, reflected) - pass the previous result to continue
+inline uint32_t tallyCrc32(uint32_t crc, const uint8_t* data, size_t length) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+#endif // TALLY_PROTOCOL_H
@@ -0,0 +1,126 @@
+/*
+ * Scan Filter for the ESP32 ATEM Tally System
+ *
+ * Picks the bridge out of scan results on the tally without parsing them. A
+ * busy venue puts hundreds of phones and headsets in range; each of their
+ * adverts should cost a few byte compares, not a parse, a String and a log
+ * line.
+ *
+ * - The tally scans with library parsing off and the controller's duplicate
+ *   filter on, so each advertiser is reported once per scan
+ * - The filter walks the raw advert + scan response payload (AD structures)
+ *   in place: a match is the bridge's 128-bit service UUID or its local name
+ * - Fields of a matching advert (manufacturer data) are read in place too
+ * - Counts adverts seen and adverts processed (matched) for STATUS
+ *
+ * The filter itself allocates nothing. The library still copies every
+ * result it reports (a BLEAdvertisedDevice, kept until clearResults()), and
+ * a match keeps only the bridge's address.
+ *
+ * matches() runs on the BLE task.
+ */
+
+#ifndef TALLY_SCAN_FILTER_H
+#define TALLY_SCAN_FILTER_H
+
+#include <Arduino.h>
+#include <string.h>
+
+// AD structure types (Bluetooth Assigned Numbers)
+#define TALLY_AD_UUID128_INCOMPLETE 0x06
+#define TALLY_AD_UUID128_COMPLETE 0x07
+#define TALLY_AD_NAME_SHORT 0x08
+#define TALLY_AD_NAME_COMPLETE 0x09
+#define TALLY_AD_MANUFACTURER 0xFF
+
+class TallyScanFilter {
+public:
+    // Match on a service UUID ("12345678-1234-...") and/or a local name
+    // (nullptr = not used). Call before the first scan.
+    void begin(const char* serviceUuid, const char* localName) {
+        hasUuid = (serviceUuid != nullptr) && parseUuid128(serviceUuid, uuid);
+        name = localName;
+        nameLength = (localName != nullptr) ? strlen(localName) : 0;
+    }
+
+    // Is this advert the bridge? (scan callback)
+    bool matches(const uint8_t* payload, size_t length) {
+        seen++;
+        if (!isBridge(payload, length)) return false;
+        processed++;
+        return true;
+    }
+
+    // Find an AD structure in a payload. Returns its data (after the type
+    // byte) and sets fieldLength, or nullptr if the payload has none.
+    static const uint8_t* findField(const uint8_t* payload, size_t length, uint8_t type, uint8_t& fieldLength) {
+        size_t pos = 0;
+        while (pos + 1 < length) {
+            uint8_t adLength = payload[pos];
+            if (adLength == 0 || pos + 1 + adLength > length) break; // Padding or truncated
+            if (payload[pos + 1] == type) {
+                fieldLength = adLength - 1;
+                return &payload[pos + 2];
+            }
+            pos += 1 + adLength;
+        }
+        return nullptr;
+    }
+
+    unsigned long getSeen() const { return seen; }
+    unsigned long getProcessed() const { return processed; }
+
+private:
+    bool isBridge(const uint8_t* payload, size_t length) const {
+        uint8_t fieldLength = 0;
+        if (hasUuid) {
+            const uint8_t types[] = { TALLY_AD_UUID128_COMPLETE, TALLY_AD_UUID128_INCOMPLETE };
+            for (uint8_t type : types) {
+                const uint8_t* list = findField(payload, length, type, fieldLength);
+                for (uint8_t i = 0; list != nullptr && i + 16 <= fieldLength; i += 16) {
+                    if (memcmp(&list[i], uuid, 16) == 0) return true;
+                }
+            }
+        }
+        if (nameLength > 0) {
+            const uint8_t types[] = { TALLY_AD_NAME_COMPLETE, TALLY_AD_NAME_SHORT };
+            for (uint8_t type : types) {
+                const uint8_t* field = findField(payload, length, type, fieldLength);
+                if (field != nullptr && fieldLength == nameLength && memcmp(field, name, nameLength) == 0) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // "12345678-1234-5678-9abc-123456789abc" to the little-endian bytes
+    // used on air
+    static bool parseUuid128(const char* text, uint8_t* out) {
+        uint8_t digits = 0;
+        for (const char* c = text; *c != '\0'; c++) {
+            if (*c == '-') continue;
+            int value;
+            if (*c >= '0' && *c <= '9') value = *c - '0';
+            else if (*c >= 'a' && *c <= 'f') value = *c - 'a' + 10;
+            else if (*c >= 'A' && *c <= 'F') value = *c - 'A' + 10;
+            else return false;
+            if (digits >= 32) return false;
+
+            uint8_t index = 15 - digits / 2;
+            out[index] = (digits % 2 == 0) ? (value << 4) : (out[index] | value);
+            digits++;
+        }
+        return digits == 32;
+    }
+
+    bool hasUuid = false;
+    uint8_t uuid[16] = {};
+    const char* name = nullptr;
+    size_t nameLength = 0;
+
+    volatile unsigned long seen = 0;
+    volatile unsigned long processed = 0;
+};
+
+#endif // TALLY_SCAN_FILTER_H
@@ -0,0 +1,185 @@
+/*
+ * Timer Wheel for the ESP32 ATEM Tally System
+ *
+ * Small hashed timer wheel for periodic and one-shot work (heartbeats,
+ * network checks, LED effects, reconnection backoff).
+ *
+ * - Statically allocated: MaxTimers timers, created once in setup()
+ * - O(1) start/stop: a timer is linked into slot (deadline % Slots)
+ * - O(1) expiry per tick: only the slots for elapsed ticks are visited
+ * - msUntilNext() tells the main loop exactly how long it may sleep
+ * - start()/stop() may be called from BLE callbacks; callbacks themselves
+ *   always run on the loop task from advance()
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <Arduino.h>
+#include "TallyClock.h"
+
+typedef void (*TimerCallback)(int arg);
+
+template <uint8_t MaxTimers, uint8_t Slots = 32, uint8_t TickMs = 10>
+class TimerWheel {
+public:
+    TimerWheel() : timerCount(0), lastTick(0), lastTickMs(0) {
+        for (uint8_t s = 0; s < Slots; s++) {
+            slotHead[s] = -1;
+        }
+    }
+
+    // Allocate a timer (call once from setup); returns timer id or -1
+    int8_t create(TimerCallback callback, int arg = 0) {
+        if (timerCount >= MaxTimers) return -1;
+
+        Timer& t = timers[timerCount];
+        t.callback = callback;
+        t.arg = arg;
+        t.periodTicks = 0;
+        t.linked = false;
+        return timerCount++;
+    }
+
+    // (Re)arm a timer to fire after delayMs, then every periodMs if non-zero
+    void start(int8_t id, unsigned long delayMs, unsigned long periodMs = 0) {
+        if (id < 0 || id >= timerCount) return;
+
+        portENTER_CRITICAL(&lock);
+        Timer& t = timers[id];
+        unlink(id);
+        t.deadline = lastTick + (clockMillis() - lastTickMs + delayMs + TickMs - 1) / TickMs;
+        t.periodTicks = (periodMs + TickMs - 1) / TickMs;
+        link(id);
+        portEXIT_CRITICAL(&lock);
+    }
+
+    // Cancel a pending timer
+    void stop(int8_t id) {
+        if (id < 0 || id >= timerCount) return;
+
+        portENTER_CRITICAL(&lock);
+        unlink(id);
+        portEXIT_CRITICAL(&lock);
+    }
+
+    bool isPending(int8_t id) const {
+        return (id >= 0 && id < timerCount && timers[id].linked);
+    }
+
+    // Run every callback that is due (call from loop)
+    void advance() {
+        unsigned long now = clockMillis();
+
+        portENTER_CRITICAL(&lock);
+        uint32_t elapsed = (now - lastTickMs) / TickMs;
+        uint32_t nowTick = lastTick + elapsed;
+
+        // Visit the slot of every elapsed tick (each slot at most once)
+        uint32_t visits = (elapsed + 1 < Slots) ? elapsed + 1 : Slots;
+        for (uint32_t v = 0; v < visits; v++) {
+            uint8_t slot = (lastTick + v) % Slots;
+            int8_t id = slotHead[slot];
+
+            while (id >= 0) {
+                Timer& t = timers[id];
+                if ((int32_t)(t.deadline - nowTick) > 0) {
+                    id = t.next;      // Later round - not due yet
+                    continue;
+                }
+
+                unlink(id);
+                if (t.periodTicks > 0) {
+                    t.deadline += t.periodTicks;
+                    if ((int32_t)(t.deadline - nowTick) <= 0) {
+                        t.deadline = nowTick + t.periodTicks; // Skip missed periods
+                    }
+                    link(id);
+                }
+
+                TimerCallback callback = t.callback;
+                int arg = t.arg;
+                portEXIT_CRITICAL(&lock);
+                callback(arg);
+                portENTER_CRITICAL(&lock);
+
+                id = slotHead[slot]; // Callback may have changed this slot
+            }
+        }
+
+        lastTick = nowTick;
+        lastTickMs += elapsed * TickMs;
+        portEXIT_CRITICAL(&lock);
+    }
+
+    // Milliseconds until the earliest pending timer, capped at maxMs
+    unsigned long msUntilNext(unsigned long maxMs) {
+        unsigned long now = clockMillis();
+        unsigned long result = maxMs;
+
+        portENTER_CRITICAL(&lock);
+        for (uint8_t id = 0; id < timerCount; id++) {
+            if (!timers[id].linked) continue;
+
+            long ticksAhead = (int32_t)(timers[id].deadline - lastTick);
+            long remaining = (long)(lastTickMs - now) + ticksAhead * TickMs;
+            if (remaining <= 0) {
+                result = 0;
+                break;
+            }
+            if ((unsigned long)remaining < result) {
+                result = remaining;
+            }
+        }
+        portEXIT_CRITICAL(&lock);
+
+        return result;
+    }
+
+private:
+    typedef struct {
+        TimerCallback callback;
+        int arg;
+        uint32_t deadline;      // Absolute tick
+        uint32_t periodTicks;   // 0 = one-shot
+        int8_t next;
+        int8_t prev;
+        bool linked;
+    } Timer;
+
+    void link(int8_t id) {
+        Timer& t = timers[id];
+        uint8_t slot = t.deadline % Slots;
+        t.prev = -1;
+        t.next = slotHead[slot];
+        if (t.next >= 0) {
+            timers[t.next].prev = id;
+        }
+        slotHead[slot] = id;
+        t.linked = true;
+    }
+
+    void unlink(int8_t id) {
+        Timer& t = timers[id];
+        if (!t.linked) return;
+
+        if (t.prev >= 0) {
+            timers[t.prev].next = t.next;
+        } else {
+            slotHead[t.deadline % Slots] = t.next;
+        }
+        if (t.next >= 0) {
+            timers[t.next].prev = t.prev;
+        }
+        t.linked = false;
+    }
+
+    Timer timers[MaxTimers];
+    int8_t slotHead[Slots];
+    uint8_t timerCount;
+    uint32_t lastTick;          // Last tick processed by advance()
+    unsigned long lastTickMs;   // clockMillis() at the start of lastTick
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,123 @@
+// Host microbenchmarks for the protocol hot paths in TallyProtocol.h - run
+// with `make -C tests bench`. One JSON line per result, like the bridge's
+// BENCH command, so runs can be compared across changes without a board.
+// Host nanoseconds are not ESP32 cycles: compare host runs with host runs.
+
+#include <chrono>
+#include "TallyProtocol.h"
+
+#define BENCH_ITERATIONS 1000000
+#define BENCH_CAMERAS 20                      // Bridge default MAX_CAMERAS
+#define BENCH_DEVICES 8                       // Bridge default MAX_DEVICES
+#define BENCH_SLOTS (BENCH_CAMERAS + 1)       // Frame cache slots (0 = status frame)
+
+static volatile uint32_t benchSink;
+
+typedef std::chrono::steady_clock BenchClock;
+
+static void printBenchResult(const char* name, int param, uint32_t iterations, BenchClock::time_point start) {
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+    printf("{\"bench\":\"%s\",\"param\":%d,\"iterations\":%lu,\"ns_per_op\":%.1f,\"host\":true}\n",
+           name, param, (unsigned long)iterations, ns / iterations);
+}
+
+static TallyMessage makeFrame(uint8_t cameraId, const char* state) {
+    TallyMessage msg = {};
+    msg.cameraId = cameraId;
+    strncpy(msg.state, state, sizeof(msg.state) - 1);
+    msg.bridgeId = 1;
+    msg.bridgeStatus = TALLY_BRIDGE_ATEM;
+    msg.checksum = calculateChecksum(&msg);
+    return msg;
+}
+
+int main() {
+    const uint32_t n = BENCH_ITERATIONS;
+    BenchClock::time_point start;
+    TallyMessage msg = makeFrame(1, "PROGRAM");
+
+    start = BenchClock::now();
+    for (uint32_t i = 0; i < n; i++) {
+        msg.cameraId = i & 0x0F;
+        benchSink += calculateChecksum(&msg);
+    }
+    printBenchResult("calculateChecksum", 0, n, start);
+
+    // Tally side: the verifyMessage() both tally sketches call
+    msg = makeFrame(1, "PROGRAM");
+    start = BenchClock::now();
+    for (uint32_t i = 0; i < n; i++) {
+        benchSink += verifyTallyMessage(&msg);
+    }
+    printBenchResult("verifyMessage", 0, n, start);
+
+    // Frame cache the bridge notifies from: status frame plus every camera
+    TallyMessage frameCache[BENCH_SLOTS];
+    frameCache[0] = makeFrame(0, "HEARTBEAT");
+    for (int cam = 1; cam < BENCH_SLOTS; cam++) {
+        frameCache[cam] = makeFrame(cam, (cam & 1) ? "PREVIEW" : "OFF");
+    }
+
+    // Multi-camera cut - a full sweep packed into TALLY_BLE_MTU containers
+    uint8_t container[TALLY_BLE_MTU - 3];
+    size_t used = 0;
+    uint32_t sweeps = n / BENCH_CAMERAS;
+    start = BenchClock::now();
+    for (uint32_t i = 0; i < sweeps; i++) {
+        used = 0;
+        for (int cam = 1; cam <= BENCH_CAMERAS; cam++) {
+            if (!packTallyFrame(container, used, sizeof(container), &frameCache[cam])) {
+                benchSink += container[1];
+                used = 0;
+                packTallyFrame(container, used, sizeof(container), &frameCache[cam]);
+            }
+        }
+        benchSink += used;
+    }
+    printBenchResult("packTallyFrames", BENCH_CAMERAS, sweeps, start);
+
+    // Tally side - split a full container back into frames
+    used = 0;
+    while (packTallyFrame(container, used, sizeof(container), &msg)) {}
+    TallyMessage unpacked[TALLY_MAX_BATCH_FRAMES];
+    start = BenchClock::now();
+    for (uint32_t i = 0; i < n; i++) {
+        benchSink += unpackTallyFrames(container, used, unpacked, TALLY_MAX_BATCH_FRAMES);
+    }
+    printBenchResult("unpackTallyFrames", TALLY_MAX_BATCH_FRAMES, n, start);
+
+    // broadcastTallyData fan-out - a cut (two cameras) queued on every link,
+    // then each link's notification packed as flushLink() does
+    uint32_t queuedSeq[BENCH_DEVICES][BENCH_SLOTS] = {};
+    uint32_t queueSeq = 0;
+    TallyNotification note;
+    for (int devices = 1; devices <= BENCH_DEVICES; devices++) {
+        uint32_t cuts = n / devices;
+        start = BenchClock::now();
+        for (uint32_t i = 0; i < cuts; i++) {
+            for (int d = 0; d < devices; d++) {
+                queueTallyFrame(queuedSeq[d], 1, queueSeq);
+                queueTallyFrame(queuedSeq[d], 2, queueSeq);
+            }
+            for (int d = 0; d < devices; d++) {
+                benchSink += packTallyNotification(note, sizeof(note.buffer), frameCache, queuedSeq[d], BENCH_SLOTS);
+            }
+        }
+        printBenchResult("broadcastTallyData", devices, cuts, start);
+    }
+
+    // TALLY_REG parsing (bridge onWrite), with the bridge's heartbeat bounds
+    uint8_t cameraId;
+    char deviceName[32];
+    uint16_t heartbeatInterval;
+    start = BenchClock::now();
+    for (uint32_t i = 0; i < n; i++) {
+        if (parseTallyRegistration("TALLY_REG:1:Tally_CAM_1:250", cameraId, deviceName, sizeof(deviceName),
+                                   heartbeatInterval, 100, 5000)) {
+            benchSink += cameraId + heartbeatInterval;
+        }
+    }
+    printBenchResult("parseRegistration", 0, n, start);
+
+    return 0;
+}
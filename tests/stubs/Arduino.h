@@ -0,0 +1,50 @@
+/*
+ * Host stand-in for the Arduino-ESP32 core - only what the src/ headers
+ * under test use. Critical sections are no-ops (tests are single threaded),
+ * analogRead() returns hostAnalogValue() and esp_random() draws from rand().
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+#define IRAM_ATTR
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef uint32_t TickType_t;
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+typedef struct {
+    int owner;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+inline int& hostAnalogValue() {
+    static int value = 0;
+    return value;
+}
+
+inline void pinMode(int, int) {}
+inline int analogRead(int) { return hostAnalogValue(); }
+inline unsigned long millis() { return 0; }
+inline uint32_t esp_random() { return ((uint32_t)rand() << 16) ^ (uint32_t)rand(); }
+
+#endif // HOST_ARDUINO_H
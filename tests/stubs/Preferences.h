@@ -0,0 +1,62 @@
+/*
+ * Host stand-in for Preferences: an in-memory NVS that counts writes, so a
+ * test can see when values reach flash.
+ */
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) {
+        ns = name;
+        return true;
+    }
+    void end() {}
+
+    size_t putBytes(const char* key, const void* data, size_t length) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        store()[ns + "/" + key].assign(bytes, bytes + length);
+        writes()++;
+        return length;
+    }
+    size_t putUInt(const char* key, uint32_t value) {
+        return putBytes(key, &value, sizeof(value));
+    }
+    bool remove(const char* key) {
+        writes()++;
+        return store().erase(ns + "/" + key) > 0;
+    }
+
+    size_t getBytes(const char* key, void* data, size_t length) {
+        std::map<std::string, std::vector<uint8_t> >::iterator it = store().find(ns + "/" + key);
+        if (it == store().end() || it->second.size() > length) return 0;
+        memcpy(data, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) {
+        uint32_t value;
+        return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+    }
+
+    // Flash writes (puts and removes) since the program started
+    static unsigned long& writes() {
+        static unsigned long count = 0;
+        return count;
+    }
+
+private:
+    static std::map<std::string, std::vector<uint8_t> >& store() {
+        static std::map<std::string, std::vector<uint8_t> > values;
+        return values;
+    }
+
+    std::string ns;
+};
+
+#endif // HOST_PREFERENCES_H
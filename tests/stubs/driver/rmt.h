@@ -0,0 +1,46 @@
+/*
+ * Host stand-in for the ESP-IDF RMT driver: the item layout and the calls
+ * TallyPixels makes. Nothing is sent.
+ */
+
+#ifndef HOST_DRIVER_RMT_H
+#define HOST_DRIVER_RMT_H
+
+#include <Arduino.h>
+
+typedef int gpio_num_t;
+typedef enum { RMT_CHANNEL_0, RMT_CHANNEL_1 } rmt_channel_t;
+typedef enum { RMT_IDLE_LEVEL_LOW, RMT_IDLE_LEVEL_HIGH } rmt_idle_level_t;
+
+typedef struct {
+    union {
+        struct {
+            uint32_t duration0 : 15;
+            uint32_t level0 : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1 : 1;
+        };
+        uint32_t val;
+    };
+} rmt_item32_t;
+
+typedef struct {
+    bool idle_output_en;
+    rmt_idle_level_t idle_level;
+} rmt_tx_config_t;
+
+typedef struct {
+    rmt_channel_t channel;
+    gpio_num_t gpio_num;
+    uint8_t clk_div;
+    rmt_tx_config_t tx_config;
+} rmt_config_t;
+
+#define RMT_DEFAULT_CONFIG_TX(gpio, ch) rmt_config_t{ (ch), (gpio), 80, { false, RMT_IDLE_LEVEL_LOW } }
+
+inline esp_err_t rmt_config(const rmt_config_t*) { return ESP_OK; }
+inline esp_err_t rmt_driver_install(rmt_channel_t, size_t, int) { return ESP_OK; }
+inline esp_err_t rmt_wait_tx_done(rmt_channel_t, TickType_t) { return ESP_OK; }
+inline esp_err_t rmt_write_items(rmt_channel_t, const rmt_item32_t*, int, bool) { return ESP_OK; }
+
+#endif // HOST_DRIVER_RMT_H
@@ -0,0 +1,28 @@
+/*
+ * Minimal host test support: CHECK() reports a failed condition and keeps
+ * going, TEST_RESULT() is the exit code for main().
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            testFailures()++;                                              \
+        }                                                                  \
+    } while (0)
+
+#define TEST_RESULT(name)                                                  \
+    (printf("%s: %s\n", name, testFailures() == 0 ? "passed" : "FAILED"),  \
+     testFailures() == 0 ? 0 : 1)
+
+#endif // HOST_TEST_H
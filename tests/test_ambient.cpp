@@ -0,0 +1,111 @@
+// AmbientBrightness.h: brightness curve, filter, PROGRAM floor and current metering
+
+#include <math.h>
+#include "test.h"
+#include "AmbientBrightness.h"
+
+static bool near(float a, float b) {
+    return fabsf(a - b) < 0.01f;
+}
+
+void testCurve() {
+    CHECK(ambientScale(0) == AMBIENT_MIN_SCALE);
+    CHECK(ambientScale(AMBIENT_DARK) == AMBIENT_MIN_SCALE);
+    CHECK(ambientScale(AMBIENT_BRIGHT) == 255);
+    CHECK(ambientScale(4095) == 255);
+
+    // Linear between the ends: halfway lands halfway (rounded down)
+    uint16_t mid = (AMBIENT_DARK + AMBIENT_BRIGHT) / 2;
+    CHECK(ambientScale(mid) == AMBIENT_MIN_SCALE + (255 - AMBIENT_MIN_SCALE) / 2);
+
+    uint8_t previous = 0;
+    bool rising = true;
+    for (uint16_t level = 0; level <= 4095; level++) {
+        uint8_t scale = ambientScale(level);
+        if (scale < previous) rising = false;
+        previous = scale;
+    }
+    CHECK(rising);
+}
+
+void testFilter() {
+    AmbientBrightness ambient;
+    ambient.begin(-1, 1, 0);
+    CHECK(!ambient.isFitted());
+    CHECK(ambient.getScale() == 255);         // No sensor - full brightness
+
+    ambient.sample(1000);                     // First sample is taken as is
+    CHECK(ambient.getLevel() == 1000);
+    ambient.sample(2000);
+    CHECK(ambient.getLevel() == 1000 + (uint16_t)(1000 * AMBIENT_FILTER));
+
+    // A photo flash in a dark room barely moves the scale
+    AmbientBrightness dark;
+    dark.begin(-1, 1, 0);
+    for (int i = 0; i < 20; i++) dark.sample(100);
+    dark.sample(4095);
+    CHECK(dark.getScale() < ambientScale(4095) / 2);
+    CHECK(dark.getRaw() == 4095);
+}
+
+void testSensorPin() {
+    hostAnalogValue() = 100;
+    AmbientBrightness ambient;
+    CHECK(ambient.begin(34, 1, 0));
+    CHECK(ambient.isFitted());
+    CHECK(ambient.getScale() == AMBIENT_MIN_SCALE);
+
+    hostAnalogValue() = 4095;
+    for (int i = 0; i < 100; i++) ambient.update();
+    CHECK(ambient.getScale() == 255);
+    CHECK(ambient.getSamples() == 101);
+}
+
+void testProgramFloor() {
+    AmbientBrightness ambient;
+    ambient.begin(-1, 1, 0);
+    ambient.sample(0);                        // Dark room
+    CHECK(ambient.apply(255, false) == AMBIENT_MIN_SCALE);
+    CHECK(ambient.apply(255, true) == AMBIENT_PROGRAM_FLOOR);
+    CHECK(ambient.apply(0, true) == 0);
+
+    // The floor never caps a brighter room
+    AmbientBrightness bright;
+    bright.begin(-1, 1, 0);
+    bright.sample(4095);
+    CHECK(bright.apply(255, true) == 255);
+    CHECK(bright.apply(255, false) == 255);
+    CHECK(bright.apply(100, false) == 100);
+}
+
+void testCurrentMetering() {
+    // One LED plus eight pixels, all showing the tally color
+    AmbientBrightness ambient;
+    ambient.begin(-1, 9, 0);
+    CHECK(near(ambient.averageCurrent(0), 0));
+
+    // Full red for 1 s, dimmed to the dark-room scale, then off for 1 s
+    ambient.recordOutput(0, AMBIENT_MIN_SCALE, 255);
+    ambient.recordOutput(1000, 0, 0);
+    float driven = ambient.averageCurrent(2000);
+    float unscaled = ambient.unscaledCurrent(2000);
+    CHECK(near(unscaled, 0.5f * LED_CHANNEL_CURRENT * 9));
+    CHECK(near(driven, 0.5f * AMBIENT_MIN_SCALE / 255.0f * LED_CHANNEL_CURRENT * 9));
+    CHECK(driven < unscaled);
+
+    // Solid white at full scale: three channels at full duty per emitter
+    AmbientBrightness white;
+    white.begin(-1, 1, 5000);
+    white.recordOutput(5000, 765, 765);
+    CHECK(near(white.averageCurrent(6000), 3.0f * LED_CHANNEL_CURRENT));
+    CHECK(near(white.unscaledCurrent(6000), white.averageCurrent(6000)));
+}
+
+int main() {
+    testCurve();
+    testFilter();
+    testSensorPin();
+    testProgramFloor();
+    testCurrentMetering();
+    return TEST_RESULT("test_ambient");
+}
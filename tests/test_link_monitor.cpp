@@ -0,0 +1,92 @@
+// LinkMonitor.h: arming on the heartbeat cadence, liveness from every frame,
+// loss and fallback
+
+#include "test.h"
+#include "LinkMonitor.h"
+
+#define PERIOD 250
+#define MISSES 3
+#define FALLBACK 15000
+
+void testBurstDoesNotArm() {
+    LinkMonitor monitor(PERIOD, MISSES, FALLBACK);
+    monitor.begin(1000);
+
+    // Snapshot status frame and a container's status frame, back to back
+    for (int i = 0; i < 5; i++) {
+        monitor.onHeartbeat(1000);
+    }
+    CHECK(!monitor.isArmed());
+    CHECK(monitor.getTimeout() == FALLBACK);
+}
+
+void testArmsOnCadence() {
+    LinkMonitor monitor(PERIOD, MISSES, FALLBACK);
+    monitor.begin(0);
+    monitor.onHeartbeat(10);                   // Early (snapshot) - ignored
+    monitor.onHeartbeat(260);
+    CHECK(!monitor.isArmed());
+    monitor.onHeartbeat(510);
+    CHECK(monitor.isArmed());
+    CHECK(monitor.getTimeout() == PERIOD * MISSES);
+
+    CHECK(monitor.update(510 + PERIOD * MISSES) == LINK_OK);
+    CHECK(monitor.update(511 + PERIOD * MISSES) == LINK_LOST);
+    CHECK(monitor.update(512 + PERIOD * MISSES + PERIOD) == LINK_DEAD);
+    monitor.onHeartbeat(2000);
+    CHECK(!monitor.isLost());
+    CHECK(monitor.getFalsePositives() == 1);
+}
+
+void testSlowBridgeKeepsFallback() {
+    // Older bridge: heartbeats every 5 s, whatever was requested
+    LinkMonitor monitor(PERIOD, MISSES, FALLBACK);
+    monitor.begin(0);
+    for (unsigned long now = 5000; now <= 60000; now += 5000) {
+        monitor.onHeartbeat(now);
+        CHECK(monitor.update(now + 4999) == LINK_OK);
+    }
+    CHECK(!monitor.isArmed());
+    CHECK(monitor.getLossEvents() == 0);
+}
+
+// Fast cutting: the bridge pushes each heartbeat back a period on every camera
+// frame, so for seconds only camera frames arrive - the link stays up
+void testCameraFramesKeepLinkAlive() {
+    LinkMonitor monitor(PERIOD, MISSES, FALLBACK);
+    monitor.begin(0);
+    monitor.onHeartbeat(250);
+    monitor.onHeartbeat(500);
+    CHECK(monitor.isArmed());
+
+    unsigned long now = 500;
+    unsigned long nextCut = 500 + PERIOD / 2;
+    for (; now <= 20000; now += 5) {
+        if (now >= nextCut) {
+            monitor.onFrame(now);
+            nextCut = now + PERIOD / 2 + (now / 5) % (PERIOD / 2);  // 125-245 ms apart
+        }
+        CHECK(monitor.update(now) == LINK_OK);
+    }
+    CHECK(monitor.getLossEvents() == 0);
+
+    // Cutting stops and the bridge goes quiet: still caught on time
+    unsigned long last = monitor.getLastFrame();
+    CHECK(monitor.update(last + PERIOD * MISSES + 1) == LINK_LOST);
+
+    // Camera frames never arm a fresh connection
+    LinkMonitor fresh(PERIOD, MISSES, FALLBACK);
+    fresh.begin(0);
+    for (unsigned long t = PERIOD; t <= 10 * PERIOD; t += PERIOD) {
+        fresh.onFrame(t);
+    }
+    CHECK(!fresh.isArmed());
+}
+
+int main() {
+    testBurstDoesNotArm();
+    testArmsOnCadence();
+    testSlowBridgeKeepsFallback();
+    testCameraFramesKeepLinkAlive();
+    return TEST_RESULT("test_link_monitor");
+}
@@ -0,0 +1,71 @@
+// TallyPixels.h: WS2812 pulse timing and GRB bit order
+
+#include "test.h"
+#include "TallyPixels.h"
+
+#define TICK_NS 25                            // 80 MHz APB / PIXEL_RMT_CLK_DIV
+
+// Decode one RMT item back into a bit, checking its pulse shape
+static int itemBit(const rmt_item32_t& item) {
+    if (item.level0 != 1 || item.level1 != 0) return -1;
+    if (item.duration0 == PIXEL_T0H_TICKS && item.duration1 == PIXEL_T0L_TICKS) return 0;
+    if (item.duration0 == PIXEL_T1H_TICKS && item.duration1 == PIXEL_T1L_TICKS) return 1;
+    return -1;
+}
+
+void testPulseTiming() {
+    // WS2812B datasheet windows (ns): T0H 400, T1H 800, bit period 1250, +-150
+    CHECK(PIXEL_T0H_TICKS * TICK_NS == 400);
+    CHECK(PIXEL_T0L_TICKS * TICK_NS == 850);
+    CHECK(PIXEL_T1H_TICKS * TICK_NS == 800);
+    CHECK(PIXEL_T1L_TICKS * TICK_NS == 450);
+    CHECK((PIXEL_T0H_TICKS + PIXEL_T0L_TICKS) * TICK_NS == 1250);
+    CHECK((PIXEL_T1H_TICKS + PIXEL_T1L_TICKS) * TICK_NS == 1250);
+    CHECK(PIXEL_RESET_TICKS * TICK_NS > 280000);
+}
+
+void testGrbBitOrder() {
+    // Tally orange (red 0xFF, green 0x80, blue 0x01) in one pixel
+    TallyPixels<1> strip;
+    strip.fill(0xFF, 0x80, 0x01);
+
+    const uint8_t* grb = strip.getFrame();
+    CHECK(grb[0] == 0x80 && grb[1] == 0xFF && grb[2] == 0x01);
+
+    rmt_item32_t items[3 * 8 + 1];
+    size_t count = encodePixelBits(grb, 3, items);
+    CHECK(count == 3 * 8 + 1);
+
+    // MSB first: green, then red, then blue
+    for (int byte = 0; byte < 3; byte++) {
+        for (int bit = 0; bit < 8; bit++) {
+            int expected = (grb[byte] >> (7 - bit)) & 1;
+            CHECK(itemBit(items[byte * 8 + bit]) == expected);
+        }
+    }
+
+    // Latch: low for the reset time, then end of transfer
+    const rmt_item32_t& latch = items[24];
+    CHECK(latch.level0 == 0 && latch.duration0 == PIXEL_RESET_TICKS);
+    CHECK(latch.level1 == 0 && latch.duration1 == 0);
+}
+
+void testUnchangedFrameSkipped() {
+    TallyPixels<4> strip;
+    CHECK(strip.begin(5, RMT_CHANNEL_0));
+    strip.fill(255, 0, 0);
+    CHECK(strip.show());
+    strip.fill(255, 0, 0);
+    CHECK(!strip.show());
+    CHECK(strip.getFramesSent() == 1);
+    CHECK(strip.getFramesSkipped() == 1);
+    strip.setPixel(2, 0, 255, 0);
+    CHECK(strip.show());
+}
+
+int main() {
+    testPulseTiming();
+    testGrbBitOrder();
+    testUnchangedFrameSkipped();
+    return TEST_RESULT("test_pixels");
+}
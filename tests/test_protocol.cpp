@@ -0,0 +1,141 @@
+// TallyProtocol.h: framing at the default and negotiated ATT MTU, TALLY_REG
+// parsing and the bridge advertisement
+
+#include "test.h"
+#include "TallyProtocol.h"
+
+static TallyMessage makeFrame(uint8_t cameraId, const char* state) {
+    TallyMessage msg = {};
+    msg.cameraId = cameraId;
+    strncpy(msg.state, state, sizeof(msg.state) - 1);
+    msg.timestamp = 1234;
+    msg.bridgeId = 1;
+    msg.bridgeStatus = TALLY_BRIDGE_ATEM;
+    msg.checksum = calculateChecksum(&msg);
+    return msg;
+}
+
+// Queue frames the way the bridge's queueFrame() does: slot = cameraId
+static void queueFrames(uint32_t* queuedSeq, const TallyMessage* frames, int count) {
+    static uint32_t seq = 0;
+    for (int i = 0; i < count; i++) {
+        queueTallyFrame(queuedSeq, frames[i].cameraId, seq);
+    }
+}
+
+void testDefaultMtuStillGetsFrames() {
+    TallyMessage cache[3] = { makeFrame(0, "HEARTBEAT"), makeFrame(1, "PROGRAM"), makeFrame(2, "PREVIEW") };
+    uint32_t queuedSeq[3] = {};
+    queueFrames(queuedSeq, cache, 3);
+
+    // One bare frame per notification, newest first, until the queue is empty
+    TallyNotification n;
+    TallyMessage frames[TALLY_MAX_BATCH_FRAMES];
+    for (int expected = 2; expected >= 0; expected--) {
+        CHECK(packTallyNotification(n, tallyNotifyCapacity(TALLY_DEFAULT_MTU), cache, queuedSeq, 3) == 1);
+        CHECK(n.length == sizeof(TallyMessage));
+        CHECK(n.length <= TALLY_DEFAULT_MTU - 3);
+        CHECK(n.slots[0] == expected);
+        CHECK(queuedSeq[expected] == 0);
+        CHECK(unpackTallyFrames(n.data, n.length, frames, TALLY_MAX_BATCH_FRAMES) == 1);
+        CHECK(memcmp(&frames[0], &cache[expected], sizeof(TallyMessage)) == 0);
+    }
+    CHECK(packTallyNotification(n, tallyNotifyCapacity(TALLY_DEFAULT_MTU), cache, queuedSeq, 3) == 0);
+}
+
+void testNegotiatedMtuPacksContainer() {
+    const int slots = TALLY_MAX_BATCH_FRAMES + 2;
+    TallyMessage cache[slots];
+    for (int i = 0; i < slots; i++) {
+        cache[i] = makeFrame(i, (i % 2) ? "PREVIEW" : "OFF");
+    }
+    uint32_t queuedSeq[slots] = {};
+    queueFrames(queuedSeq, cache, slots);
+
+    TallyNotification n;
+    int sent = packTallyNotification(n, tallyNotifyCapacity(TALLY_BLE_MTU), cache, queuedSeq, slots);
+    CHECK(sent == (int)TALLY_MAX_BATCH_FRAMES);
+    CHECK(n.length <= TALLY_BLE_MTU - 3);
+    CHECK(n.data[0] == TALLY_BATCH_MARKER);
+    CHECK(n.slots[0] == slots - 1);            // Newest first
+    CHECK(queuedSeq[0] != 0 && queuedSeq[1] != 0);
+
+    TallyMessage frames[TALLY_MAX_BATCH_FRAMES];
+    CHECK(unpackTallyFrames(n.data, n.length, frames, TALLY_MAX_BATCH_FRAMES) == sent);
+    CHECK(memcmp(&frames[sent - 1], &cache[n.slots[sent - 1]], sizeof(TallyMessage)) == 0);
+
+    // The two oldest follow in the next notification, as a container
+    CHECK(packTallyNotification(n, tallyNotifyCapacity(TALLY_BLE_MTU), cache, queuedSeq, slots) == 2);
+    CHECK(n.data[0] == TALLY_BATCH_MARKER);
+    CHECK(n.slots[0] == 1 && n.slots[1] == 0);
+}
+
+void testCapacity() {
+    CHECK(tallyNotifyCapacity(TALLY_DEFAULT_MTU) == 2 + sizeof(TallyMessage));
+    CHECK(tallyNotifyCapacity(0) == 2 + sizeof(TallyMessage));
+    CHECK(tallyNotifyCapacity(TALLY_BLE_MTU) == TALLY_BLE_MTU - 3);
+}
+
+void testChecksumRoundTrip() {
+    TallyMessage msg = makeFrame(4, "PROGRAM");
+    uint8_t received = msg.checksum;
+    msg.checksum = 0;
+    CHECK(calculateChecksum(&msg) == received);
+    msg.checksum = received;
+    CHECK(verifyTallyMessage(&msg));
+    msg.state[0] = 'X';
+    CHECK(calculateChecksum(&msg) != received);
+    CHECK(!verifyTallyMessage(&msg));
+}
+
+void testRegistration() {
+    uint8_t cameraId;
+    char name[8];
+    uint16_t interval;
+
+    CHECK(parseTallyRegistration("TALLY_REG:3:CAM_3", cameraId, name, sizeof(name), interval, 100, 5000));
+    CHECK(cameraId == 3 && strcmp(name, "CAM_3") == 0 && interval == 5000);
+
+    // Requested heartbeat period is clamped, the name cut to the buffer
+    CHECK(parseTallyRegistration("TALLY_REG:12:Tally_CAM_12:250", cameraId, name, sizeof(name), interval, 100, 5000));
+    CHECK(cameraId == 12 && strcmp(name, "Tally_C") == 0 && interval == 250);
+    CHECK(parseTallyRegistration("TALLY_REG:1:A:20", cameraId, name, sizeof(name), interval, 100, 5000));
+    CHECK(interval == 100);
+    CHECK(parseTallyRegistration("TALLY_REG:1:A:60000", cameraId, name, sizeof(name), interval, 100, 5000));
+    CHECK(interval == 5000);
+
+    CHECK(!parseTallyRegistration("TALLY_REG:1", cameraId, name, sizeof(name), interval, 100, 5000));
+    CHECK(!parseTallyRegistration("TALLY_ACK:1:CAM_1", cameraId, name, sizeof(name), interval, 100, 5000));
+}
+
+// The advertised GATT layout separates bridges with and without OTA, and an
+// advert from a bridge without the field decodes with no layout (no caching)
+static void testAdvertisedGattLayout() {
+    TallyAdvertisement adv = {};
+    adv.companyId = TALLY_ADV_COMPANY_ID;
+    adv.version = TALLY_ADV_VERSION;
+    adv.program = 1;
+    adv.gatt = TALLY_GATT_LAYOUT | TALLY_GATT_OTA;
+
+    TallyAdvertisement decoded;
+    CHECK(decodeTallyAdvertisement((const uint8_t*)&adv, sizeof(adv), &decoded));
+    CHECK(decoded.gatt == (TALLY_GATT_LAYOUT | TALLY_GATT_OTA));
+    CHECK(decoded.gatt != TALLY_GATT_LAYOUT);
+
+    CHECK(decodeTallyAdvertisement((const uint8_t*)&adv, TALLY_ADV_MIN_LENGTH, &decoded));
+    CHECK(decoded.program == 1 && decoded.gatt == 0);
+    CHECK(!decodeTallyAdvertisement((const uint8_t*)&adv, TALLY_ADV_MIN_LENGTH - 1, &decoded));
+
+    // Manufacturer data AD structure (length, type) fits the scan response
+    CHECK(2 + sizeof(TallyAdvertisement) <= 31);
+}
+
+int main() {
+    testDefaultMtuStillGetsFrames();
+    testNegotiatedMtuPacksContainer();
+    testCapacity();
+    testChecksumRoundTrip();
+    testRegistration();
+    testAdvertisedGattLayout();
+    return TEST_RESULT("test_protocol");
+}
@@ -0,0 +1,206 @@
+// Reconnect storm on the virtual clock (TallyClock.h): a room of tallies
+// loses a rebooting bridge and finds it again. Each tally runs its real
+// ReconnectBackoff on a timer wheel, as the tally firmware does: immediate
+// retry, then jittered backoff between scans. Reports time-to-recover
+// percentiles (bridge reboot to tally synced) per room size and outage.
+//
+// The radio is modelled, not measured: the tally's duty-cycled scan window,
+// the bridge's advertising (AdvertisingPolicy.h) that pauses for a loop pass
+// after each connection, one connection per advert event, and a fixed time
+// from connect to the first frame (MTU, cached handles, snapshot read).
+
+#include <vector>
+#include <algorithm>
+#include "test.h"
+#include "TallyClock.h"
+#include "TimerWheel.h"
+#include "ReconnectBackoff.h"
+#include "AdvertisingPolicy.h"
+
+// Tally (ESP32_Tally_Light_BLE_v2)
+#define RECONNECT_INTERVAL 500
+#define MAX_RECONNECT_INTERVAL 8000
+#define SCAN_TIME 5000                        // Per scan (ms)
+#define SCAN_INTERVAL 1349                    // Scan interval and window (ms)
+#define SCAN_WINDOW 449
+#define BLE_SUPERVISION_TIMEOUT 500           // Dead link reported by the controller
+
+// Bridge (ATEMBridgeCore.h)
+#define ADV_FAST_INTERVAL 20
+#define ADV_SLOW_INTERVAL 500
+#define ADV_BURST_WINDOW 30000
+#define ADV_MISSING_WINDOW 300000
+
+// Modelled radio and boot timings
+#define BRIDGE_BOOT_TIME 1500                 // Reset to advertising (BLE is set up before the network)
+#define ADV_RESTART_TIME 10                   // Advertising off after a connection until the next loop pass
+#define CONNECT_TO_SYNC 120                   // Connect, MTU exchange, subscribe by handle, snapshot read
+
+#define MAX_TALLIES 8
+#define TRIALS 100
+#define SIM_LIMIT 120000                      // Give up on a trial after (ms)
+
+enum SimState { SIM_SYNCED, SIM_LINKED, SIM_WAITING, SIM_SCANNING, SIM_CONNECTING, SIM_SYNCING };
+
+struct SimTally {
+    ReconnectBackoff backoff{RECONNECT_INTERVAL, MAX_RECONNECT_INTERVAL};
+    int8_t reconnectTimer;
+    SimState state;
+    unsigned long since;                      // Entered the state (scan start, link up)
+    unsigned long scanPhase;                  // Scan window offset within the interval
+    unsigned long attempts;
+};
+
+TimerWheel<MAX_TALLIES> timers;
+SimTally tallies[MAX_TALLIES];
+AdvertisingPolicy advertisingPolicy(ADV_BURST_WINDOW, ADV_MISSING_WINDOW);
+uint32_t random32 = 12345;
+
+static uint32_t simRandom(uint32_t range) {
+    random32 = random32 * 1103515245 + 12345;
+    return (random32 >> 8) % range;
+}
+
+// Tally: back off before the next scan (immediate after a fresh loss)
+static void scheduleReconnect(SimTally& t) {
+    t.state = SIM_WAITING;
+    timers.start(t.reconnectTimer, t.backoff.nextDelay());
+}
+
+// Tally: reconnect timer - start a scan
+static void attemptReconnect(int index) {
+    SimTally& t = tallies[index];
+    t.attempts++;
+    t.state = SIM_SCANNING;
+    t.since = clockMillis();
+    t.scanPhase = simRandom(SCAN_INTERVAL);
+}
+
+static bool inScanWindow(const SimTally& t, unsigned long now) {
+    return (now - t.since + t.scanPhase) % SCAN_INTERVAL < SCAN_WINDOW;
+}
+
+static unsigned long percentile(std::vector<unsigned long>& samples, int p) {
+    std::sort(samples.begin(), samples.end());
+    return samples[(samples.size() - 1) * p / 100];
+}
+
+// Run TRIALS bridge reboots with `count` tallies; returns the worst recovery
+static unsigned long runStorm(int count, unsigned long bridgeDown, bool& allRecovered) {
+    std::vector<unsigned long> recovery;
+    unsigned long maxAttempts = 0;
+    allRecovered = true;
+
+    for (int trial = 0; trial < TRIALS; trial++) {
+        unsigned long reboot = clockMillis();
+        unsigned long bridgeUp = reboot + bridgeDown;
+        unsigned long nextAdvert = bridgeUp;
+        unsigned long advertPaused = 0;
+        int connected = 0;
+        int synced = 0;
+        bool bridgeStarted = false;
+
+        // Tallies hear the bridge go silent at the supervision timeout, up to
+        // one connection interval apart
+        unsigned long lossAt[MAX_TALLIES];
+        for (int i = 0; i < count; i++) {
+            tallies[i].state = SIM_SYNCED;
+            tallies[i].attempts = 0;
+            tallies[i].backoff.reset();
+            lossAt[i] = reboot + BLE_SUPERVISION_TIMEOUT + simRandom(15);
+        }
+
+        while (synced < count && clockMillis() - reboot < SIM_LIMIT) {
+            unsigned long now = clockMillis();
+            timers.advance();
+
+            for (int i = 0; i < count; i++) {
+                if (tallies[i].state == SIM_SYNCED && now >= lossAt[i]) {
+                    scheduleReconnect(tallies[i]);
+                }
+            }
+
+            // Bridge: advertises from boot, paced by the advertising policy
+            if (!bridgeStarted && now >= bridgeUp) {
+                bridgeStarted = true;
+                advertisingPolicy.begin(now);
+            }
+            bool advertEvent = false;
+            if (bridgeStarted && now >= nextAdvert && now >= advertPaused) {
+                AdvertisingMode mode = advertisingPolicy.select(now, connected < count, connected < count);
+                if (mode != ADV_OFF) {
+                    advertEvent = true;
+                    // advDelay: 0-10 ms pseudo-random per advert event
+                    nextAdvert = now + (mode == ADV_FAST ? ADV_FAST_INTERVAL : ADV_SLOW_INTERVAL) + simRandom(11);
+                }
+            }
+
+            // One connection request is answered per advert event
+            bool accepted = false;
+            for (int i = 0; i < count; i++) {
+                SimTally& t = tallies[i];
+                if (t.state == SIM_SCANNING) {
+                    if (advertEvent && inScanWindow(t, now)) {
+                        t.state = SIM_CONNECTING;
+                    } else if (now - t.since >= SCAN_TIME) {
+                        scheduleReconnect(t);   // Bridge not found in this scan
+                    }
+                }
+                if (t.state == SIM_CONNECTING && advertEvent && !accepted) {
+                    accepted = true;
+                    connected++;
+                    t.state = SIM_SYNCING;
+                    t.since = now;
+                    advertPaused = now + ADV_RESTART_TIME;
+                } else if (t.state == SIM_SYNCING && now - t.since >= CONNECT_TO_SYNC) {
+                    t.state = SIM_LINKED;
+                    t.backoff.reset();          // recordSync()
+                    recovery.push_back(now - reboot);
+                    maxAttempts = max(maxAttempts, t.attempts);
+                    synced++;
+                }
+            }
+
+            VirtualClock::advance(1);
+        }
+        if (synced < count) allRecovered = false;
+
+        // Let the timers drain before the next reboot
+        VirtualClock::advance(MAX_RECONNECT_INTERVAL);
+        timers.advance();
+        for (int i = 0; i < count; i++) {
+            timers.stop(tallies[i].reconnectTimer);
+        }
+    }
+
+    printf("  room of %d, bridge down %5lu ms: recover p50 %5lu, p90 %5lu, p99 %5lu, max %5lu ms"
+           " (%lu scans max)\n",
+           count, bridgeDown, percentile(recovery, 50), percentile(recovery, 90),
+           percentile(recovery, 99), percentile(recovery, 100), maxAttempts);
+    return percentile(recovery, 100);
+}
+
+void testReconnectStorm() {
+    for (int i = 0; i < MAX_TALLIES; i++) {
+        tallies[i].reconnectTimer = timers.create(attemptReconnect, i);
+    }
+
+    const int rooms[] = { 1, 4, MAX_TALLIES };
+    const unsigned long outages[] = { BRIDGE_BOOT_TIME, 10000, 30000 };
+    for (unsigned long down : outages) {
+        for (int count : rooms) {
+            bool allRecovered;
+            unsigned long worst = runStorm(count, down, allRecovered);
+
+            // Every tally comes back, at most one capped backoff plus a scan
+            // after the bridge does
+            CHECK(allRecovered);
+            CHECK(worst <= down + MAX_RECONNECT_INTERVAL + SCAN_TIME + CONNECT_TO_SYNC * count);
+        }
+    }
+}
+
+int main() {
+    testReconnectStorm();
+    return TEST_RESULT("test_reconnect_sim");
+}
@@ -0,0 +1,88 @@
+// TallyScanFilter.h: the bridge's adverts, as Arduino-ESP32 2.x sends them,
+// still identify the bridge to both tallies
+
+#include "test.h"
+#include "TallyScanFilter.h"
+#include "TallyProtocol.h"
+
+#define BRIDGE_NAME "ATEM_Bridge_BLE"
+#define BRIDGE_UUID "12345678-1234-5678-9abc-123456789abc"
+
+// Primary advert: BLEAdvertising::start() with a scan response enabled sends
+// the flags and the service UUID list, but not the device name
+static size_t primaryAdvert(uint8_t* out) {
+    static const uint8_t uuid[16] = {  // BRIDGE_UUID, little-endian on air
+        0xbc, 0x9a, 0x78, 0x56, 0x34, 0x12, 0xbc, 0x9a,
+        0x78, 0x56, 0x34, 0x12, 0x78, 0x56, 0x34, 0x12
+    };
+    size_t pos = 0;
+    out[pos++] = 2;
+    out[pos++] = 0x01;                  // Flags
+    out[pos++] = 0x06;
+    out[pos++] = 17;
+    out[pos++] = TALLY_AD_UUID128_COMPLETE;
+    memcpy(&out[pos], uuid, 16);
+    return pos + 16;
+}
+
+// Scan response: the manufacturer data the bridge's publishAdvertisement() sets
+static size_t scanResponse(uint8_t* out) {
+    TallyAdvertisement adv = {};
+    adv.companyId = TALLY_ADV_COMPANY_ID;
+    adv.version = TALLY_ADV_VERSION;
+    adv.status = TALLY_ADV_STATUS_ATEM;
+    adv.program = 1;
+    out[0] = 1 + sizeof(adv);
+    out[1] = TALLY_AD_MANUFACTURER;
+    memcpy(&out[2], &adv, sizeof(adv));
+    return 2 + sizeof(adv);
+}
+
+void testBridgeAdvertMatches() {
+    uint8_t payload[62];
+    size_t primary = primaryAdvert(payload);
+    size_t response = scanResponse(&payload[primary]);
+    CHECK(primary <= 31);
+    CHECK(response <= 31);
+
+    // The name cannot join the manufacturer data in the scan response
+    CHECK(response + 2 + strlen(BRIDGE_NAME) > 31);
+
+    // Both tallies match on the service UUID
+    TallyScanFilter cppTally;
+    cppTally.begin(BRIDGE_UUID, nullptr);
+    CHECK(cppTally.matches(payload, primary + response));
+
+    TallyScanFilter inoTally;
+    inoTally.begin(BRIDGE_UUID, BRIDGE_NAME);
+    CHECK(inoTally.matches(payload, primary + response));
+    CHECK(inoTally.matches(payload, primary));   // Scan response not received yet
+
+    // A name-only filter would never see the bridge
+    TallyScanFilter nameOnly;
+    nameOnly.begin(nullptr, BRIDGE_NAME);
+    CHECK(!nameOnly.matches(payload, primary + response));
+
+    // The advertised state is still read in place
+    uint8_t length = 0;
+    const uint8_t* data = TallyScanFilter::findField(payload, primary + response, TALLY_AD_MANUFACTURER, length);
+    TallyAdvertisement adv;
+    CHECK(data != nullptr && decodeTallyAdvertisement(data, length, &adv));
+    CHECK(adv.program == 1);
+}
+
+void testStrangerRejected() {
+    uint8_t payload[31];
+    size_t length = primaryAdvert(payload);
+    payload[length - 1] ^= 0xff;              // Another service
+    TallyScanFilter filter;
+    filter.begin(BRIDGE_UUID, BRIDGE_NAME);
+    CHECK(!filter.matches(payload, length));
+    CHECK(filter.getSeen() == 1 && filter.getProcessed() == 0);
+}
+
+int main() {
+    testBridgeAdvertMatches();
+    testStrangerRejected();
+    return TEST_RESULT("test_scan_filter");
+}
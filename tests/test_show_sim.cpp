@@ -0,0 +1,313 @@
+// Twelve-hour show on the virtual clock (TallyClock.h). The bridge side
+// keeps the encoded frame cache and per-link queue the way ATEMBridgeCore
+// does: cuts and heartbeats are queued with queueTallyFrame(), every frame
+// pushes the tally's heartbeat back one period (deferHeartbeat()), and each
+// flush packs notifications with packTallyNotification(). The tally side
+// unpacks and verifies them with the protocol helpers and feeds LinkMonitor
+// through onMessage(), as processTallyMessage() does.
+//
+// Radio dropouts, switcher outages and fast-cutting bursts are scripted.
+// Checks that the tally shows the bridge's state, how fast loss is caught,
+// that there are no false losses or silent gaps longer than a heartbeat
+// period, and that NVS writes only land between cuts.
+
+#include "test.h"
+#include "TallyClock.h"
+#include "TallyProtocol.h"
+#include "TimerWheel.h"
+#include "LinkMonitor.h"
+#include "AtemHealth.h"
+#include "PersistQueue.h"
+
+#define SHOW_LENGTH (12UL * 3600 * 1000)
+#define CAMERAS 8
+#define FRAME_SLOTS (CAMERAS + 1)             // Slot 0 = status frame (heartbeat)
+#define TALLY_CAMERA 1                        // The simulated tally's camera
+#define HEARTBEAT_PERIOD 250                  // Requested by the tally (LINK_LOSS_TIMEOUT / 3)
+#define HEARTBEAT_MISS_LIMIT 3
+#define HEARTBEAT_TIMEOUT 15000
+#define LINK_CHECK_INTERVAL 50
+#define TALLY_CHECK_INTERVAL 25
+#define ATEM_DEGRADED_TIMEOUT 400
+#define ATEM_DEAD_TIMEOUT 800
+#define LOOP_IDLE_TIMEOUT 1000
+#define TIMER_TICK 10                         // TimerWheel resolution (ms)
+
+struct Window {
+    unsigned long start;
+    unsigned long length;
+};
+
+// Radio dropouts (tally out of range, each longer than the loss window plus
+// grace), switcher outages and fast-cutting bursts, from show start
+static const Window radioDropouts[] = {
+    { 1 * 3600000UL, 2000 }, { 3 * 3600000UL, 2000 }, { 5 * 3600000UL + 123, 2000 },
+    { 7 * 3600000UL, 1200 }, { 9 * 3600000UL, 5000 }, { 11 * 3600000UL + 7, 2000 },
+};
+static const Window atemOutages[] = {
+    { 2 * 3600000UL, 3000 }, { 6 * 3600000UL + 11, 1500 }, { 10 * 3600000UL, 10000 },
+};
+static const Window cuttingBursts[] = {
+    { 30 * 60000UL, 20000 }, { 4 * 3600000UL, 60000 }, { 8 * 3600000UL + 500, 30000 },
+};
+#define RADIO_DROPOUTS (sizeof(radioDropouts) / sizeof(radioDropouts[0]))
+#define ATEM_OUTAGES (sizeof(atemOutages) / sizeof(atemOutages[0]))
+#define CUTTING_BURSTS (sizeof(cuttingBursts) / sizeof(cuttingBursts[0]))
+#define BURST_CUT_INTERVAL 100                // Faster than the heartbeat period
+
+static bool inWindow(const Window* windows, size_t count, unsigned long t) {
+    for (size_t i = 0; i < count; i++) {
+        if (t >= windows[i].start && t < windows[i].start + windows[i].length) return true;
+    }
+    return false;
+}
+
+TimerWheel<4> timers;
+int8_t heartbeatTimer, tallyCheckTimer, linkCheckTimer, cutTimer;
+
+// Bridge: encoded frame cache and the tally link's pending slots
+TallyMessage frameCache[FRAME_SLOTS];
+uint32_t queuedSeq[FRAME_SLOTS] = {};
+uint32_t queueSeq = 0;
+uint8_t programCamera = 2;
+
+// Tally
+LinkMonitor linkMonitor(HEARTBEAT_PERIOD, HEARTBEAT_MISS_LIMIT, HEARTBEAT_TIMEOUT);
+char tallyState[sizeof(frameCache[0].state)] = "";
+bool needsSync = false;                       // Reconnected - waiting for the bridge's full state
+
+AtemHealth atemHealth(ATEM_DEGRADED_TIMEOUT, ATEM_DEAD_TIMEOUT);
+PersistQueue persist;
+
+unsigned long showStart = 0;
+unsigned long heartbeatsSent = 0;
+unsigned long framesDelivered = 0;
+unsigned long notificationsSent = 0;
+unsigned long badFrames = 0;
+unsigned long lastFrameHeard = 0;
+unsigned long worstSilence = 0;               // Longest gap between frames on an up link
+unsigned long worstLossDetection = 0;
+unsigned long reconnects = 0;
+unsigned long lastAtemPacket = 0;
+unsigned long worstDeadDetection = 0;
+unsigned long cuts = 0;
+unsigned long burstCuts = 0;
+unsigned long lastCut = 0;
+uint32_t random32 = 12345;
+
+static unsigned long showTime() {
+    return clockMillis() - showStart;
+}
+
+static bool radioUp() {
+    return !inWindow(radioDropouts, RADIO_DROPOUTS, showTime());
+}
+
+// Bridge: rebuild a cache slot (encodeTallyMessage())
+static void encodeFrame(uint8_t slot, const char* state) {
+    TallyMessage& msg = frameCache[slot];
+    msg.cameraId = slot;
+    strncpy(msg.state, state, sizeof(msg.state) - 1);
+    msg.timestamp = clockMillis();
+    msg.bridgeId = 1;
+    msg.bridgeStatus = TALLY_BRIDGE_ATEM;
+    msg.checksum = calculateChecksum(&msg);
+}
+
+// Bridge: queue a slot on the link; any frame pushes the heartbeat back
+// (broadcastTallyData() + deferHeartbeat())
+static void broadcast(uint8_t slot) {
+    queueTallyFrame(queuedSeq, slot, queueSeq);
+    timers.start(heartbeatTimer, HEARTBEAT_PERIOD, HEARTBEAT_PERIOD);
+}
+
+// Tally: one notification from the bridge (notify callback + processTallyMessage())
+static void receiveNotification(const uint8_t* data, size_t length) {
+    TallyMessage frames[TALLY_MAX_BATCH_FRAMES];
+    int count = unpackTallyFrames(data, length, frames, TALLY_MAX_BATCH_FRAMES);
+    unsigned long now = clockMillis();
+    for (int i = 0; i < count; i++) {
+        if (!verifyTallyMessage(&frames[i])) {
+            badFrames++;
+            continue;
+        }
+        if (!needsSync) {
+            worstSilence = max(worstSilence, now - lastFrameHeard);
+        }
+        lastFrameHeard = now;
+        framesDelivered++;
+        linkMonitor.onMessage(frames[i].cameraId, now);
+        if (frames[i].cameraId == TALLY_CAMERA) {
+            strncpy(tallyState, frames[i].state, sizeof(tallyState) - 1);
+        }
+    }
+}
+
+// Bridge: send the link's queued frames newest first (flushLink()); lost
+// while the radio is out
+static void flushLink() {
+    TallyNotification n;
+    while (packTallyNotification(n, tallyNotifyCapacity(TALLY_BLE_MTU), frameCache, queuedSeq, FRAME_SLOTS) > 0) {
+        notificationsSent++;
+        if (radioUp()) {
+            receiveNotification(n.data, n.length);
+        }
+    }
+}
+
+// Bridge: per-tally heartbeat timer (sendHeartbeatSignal())
+void sendHeartbeat(int) {
+    heartbeatsSent++;
+    frameCache[0].timestamp = clockMillis();
+    queueTallyFrame(queuedSeq, 0, queueSeq);
+}
+
+// Bridge: ATEM poll - the switcher talks every poll unless it is out
+void checkTally(int) {
+    unsigned long now = clockMillis();
+    if (!inWindow(atemOutages, ATEM_OUTAGES, showTime())) {
+        lastAtemPacket = now;
+        atemHealth.onPacket(now);
+    }
+    AtemHealthStatus previous = atemHealth.getStatus();
+    if (atemHealth.update(now) == ATEM_DEAD && previous != ATEM_DEAD) {
+        worstDeadDetection = max(worstDeadDetection, now - lastAtemPacket);
+    }
+}
+
+// Tally: link check; a dead link reconnects, stores the bridge's GATT
+// handles again (written behind) and starts monitoring afresh
+void checkLink(int) {
+    unsigned long now = clockMillis();
+    bool wasLost = linkMonitor.isLost();
+    LinkStatus status = linkMonitor.update(now);
+    if (status != LINK_OK && !wasLost) {
+        worstLossDetection = max(worstLossDetection, now - lastFrameHeard);
+    }
+    if (status == LINK_DEAD) {
+        reconnects++;
+        uint8_t handles[16] = { (uint8_t)reconnects };
+        persist.putBytes("tallygatt", "handles", handles, sizeof(handles));
+        linkMonitor.begin(now);
+        needsSync = true;
+    }
+}
+
+// Switcher cut to a random camera: the old program camera and the new one
+// change. Next cut 0.3 - 20 s later, or every BURST_CUT_INTERVAL in a burst.
+void cut(int) {
+    uint8_t next = 1 + (random32 >> 8) % CAMERAS;
+    if (next != programCamera) {
+        encodeFrame(programCamera, "PREVIEW");
+        broadcast(programCamera);
+        encodeFrame(next, "PROGRAM");
+        broadcast(next);
+        programCamera = next;
+    }
+    cuts++;
+    lastCut = clockMillis();
+    if (cuts % 50 == 0) {
+        persist.putUInt("tallyota", "imageCrc", cuts);   // Setting changes mid-show
+    }
+    random32 = random32 * 1103515245 + 12345;
+    if (inWindow(cuttingBursts, CUTTING_BURSTS, showTime())) {
+        burstCuts++;
+        timers.start(cutTimer, BURST_CUT_INTERVAL);
+    } else {
+        timers.start(cutTimer, 300 + (random32 >> 8) % 19700);
+    }
+}
+
+void testTwelveHourShow() {
+    showStart = clockMillis();
+    linkMonitor.begin(showStart);
+    atemHealth.begin(showStart);
+    lastFrameHeard = showStart;
+
+    heartbeatTimer = timers.create(sendHeartbeat);
+    tallyCheckTimer = timers.create(checkTally);
+    linkCheckTimer = timers.create(checkLink);
+    cutTimer = timers.create(cut);
+
+    // Tally connects: the bridge queues its status and every camera
+    encodeFrame(0, "HEARTBEAT");
+    for (uint8_t cam = 1; cam <= CAMERAS; cam++) {
+        encodeFrame(cam, cam == programCamera ? "PROGRAM" : "OFF");
+    }
+    for (uint8_t slot = 0; slot < FRAME_SLOTS; slot++) {
+        broadcast(slot);
+    }
+    timers.start(tallyCheckTimer, TALLY_CHECK_INTERVAL, TALLY_CHECK_INTERVAL);
+    timers.start(linkCheckTimer, LINK_CHECK_INTERVAL, LINK_CHECK_INTERVAL);
+    timers.start(cutTimer, 1000);
+
+    unsigned long writesBefore = Preferences::writes();
+    unsigned long misplacedWrites = 0;
+    unsigned long staleTally = 0;
+    unsigned long loopPasses = 0;
+
+    // One pass of both loops: run due work, flush the link, resync after a
+    // reconnect, flush settings between cuts, sleep until the next deadline
+    while (showTime() < SHOW_LENGTH) {
+        loopPasses++;
+        unsigned long writes = Preferences::writes();
+        timers.advance();
+
+        if (needsSync && radioUp()) {
+            needsSync = false;
+            lastFrameHeard = clockMillis();
+            for (uint8_t slot = 0; slot < FRAME_SLOTS; slot++) {
+                broadcast(slot);
+            }
+        }
+        flushLink();
+        if (radioUp() && !needsSync && strcmp(tallyState, frameCache[TALLY_CAMERA].state) != 0) {
+            staleTally++;
+        }
+
+        persist.service(clockMillis(), lastCut);
+        if (clockMillis() - lastCut < PERSIST_IDLE_WINDOW) {
+            misplacedWrites += Preferences::writes() - writes;
+        }
+
+        VirtualClock::advance(timers.msUntilNext(LOOP_IDLE_TIMEOUT));
+    }
+    persist.flush();
+
+    printf("  12 h show: %lu loop passes, %lu cuts (%lu in bursts), %lu heartbeats, "
+           "%lu frames in %lu notifications, %lu reconnects, %lu NVS writes\n",
+           loopPasses, cuts, burstCuts, heartbeatsSent, framesDelivered, notificationsSent,
+           reconnects, Preferences::writes() - writesBefore);
+
+    // Frames: every one verifies and the tally always shows the bridge's state
+    CHECK(badFrames == 0);
+    CHECK(staleTally == 0);
+    CHECK(burstCuts > 0);
+
+    // Heartbeats are pushed back by camera frames, never starved: the link is
+    // never silent for longer than a period (plus the timer tick)
+    CHECK(heartbeatsSent < SHOW_LENGTH / HEARTBEAT_PERIOD);
+    CHECK(worstSilence <= HEARTBEAT_PERIOD + TIMER_TICK);
+
+    // Link monitor: every dropout is caught in time, nothing else is - not
+    // even during fast cutting, when camera frames are the only traffic
+    CHECK(linkMonitor.isArmed());
+    CHECK(reconnects == RADIO_DROPOUTS);
+    CHECK(worstLossDetection <= HEARTBEAT_PERIOD * HEARTBEAT_MISS_LIMIT + LINK_CHECK_INTERVAL);
+    CHECK(linkMonitor.getFalsePositives() == 0);
+
+    // ATEM health: every outage is declared dead within the window and recovers
+    CHECK(atemHealth.getDeadEvents() == ATEM_OUTAGES);
+    CHECK(atemHealth.getRecoveries() == ATEM_OUTAGES);
+    CHECK(worstDeadDetection <= ATEM_DEAD_TIMEOUT + TALLY_CHECK_INTERVAL);
+
+    // Write-behind: settings were written, never during a burst of cuts
+    CHECK(persist.getWrites() > 0);
+    CHECK(persist.pendingCount() == 0);
+    CHECK(misplacedWrites == 0);
+}
+
+int main() {
+    testTwelveHourShow();
+    return TEST_RESULT("test_show_sim");
+}
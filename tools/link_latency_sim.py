@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+Compare tally delivery latency for the two bridge topologies.
+
+    link_latency_sim.py
+    link_latency_sim.py --links 4 8 12 --seconds 120
+
+Peripheral bridge (default): every tally is a central that picked its own
+connection interval (7.5-15ms) and anchor. The bridge has one radio, so when
+two links' connection events overlap only one is served and the other event
+is missed - a frame waiting on that link slips to the next event.
+
+Central bridge (BRIDGE_CENTRAL): the bridge opens every link at the same
+CENTRAL_CONN_INTERVAL and the controller spaces the anchors across the
+interval, so events never overlap while they fit.
+
+A tally change is raised at a random time and counts as delivered at the
+first served connection event of the link. The model ignores retransmissions
+and packet loss; it shows scheduling cost only.
+
+Everything here is modelled, not measured: no bridge or tally code runs and
+the event timing is not taken from radio captures. Quote its output as a
+model estimate.
+"""
+
+import argparse
+import random
+
+EVENT_US = 1250          # Radio time one connection event holds (one packet each way plus IFS)
+UNIT_US = 1250           # Connection interval unit
+
+
+def peripheral_links(count, rng):
+    links = []
+    for _ in range(count):
+        interval = rng.randint(6, 12) * UNIT_US
+        links.append((interval, rng.randrange(interval)))
+    return links
+
+
+def central_links(count, interval_units):
+    interval = interval_units * UNIT_US
+    spacing = max(interval // max(count, 1), EVENT_US)
+    return [(interval, (i * spacing) % interval) for i in range(count)]
+
+
+def served_events(links, duration_us):
+    """Per link, sorted times of the events the bridge radio actually served."""
+    events = []
+    for index, (interval, anchor) in enumerate(links):
+        t = anchor
+        while t < duration_us:
+            events.append((t, index))
+            t += interval
+    events.sort()
+
+    served = [[] for _ in links]
+    missed = 0
+    busy_until = -1
+    for t, index in events:
+        if t < busy_until:
+            missed += 1
+            continue
+        served[index].append(t)
+        busy_until = t + EVENT_US
+    return served, missed, len(events)
+
+
+def latencies(served, duration_us, samples, rng):
+    result = []
+    for _ in range(samples):
+        index = rng.randrange(len(served))
+        times = served[index]
+        raised = rng.randrange(duration_us // 2)
+        # Binary search for the first served event after the change
+        lo, hi = 0, len(times)
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if times[mid] < raised:
+                lo = mid + 1
+            else:
+                hi = mid
+        if lo < len(times):
+            result.append((times[lo] - raised) / 1000.0)
+    return sorted(result)
+
+
+def summarize(name, links, duration_us, samples, rng):
+    served, missed, total = served_events(links, duration_us)
+    values = latencies(served, duration_us, samples, rng)
+    mean = sum(values) / len(values)
+    p99 = values[int(len(values) * 0.99)]
+    print("  %-10s mean %5.2f ms  p99 %6.2f ms  max %6.2f ms  missed events %5.1f%%" % (
+        name, mean, p99, values[-1], 100.0 * missed / total))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Tally link latency by bridge topology")
+    parser.add_argument("--links", type=int, nargs="+", default=[4, 8, 12], help="tally counts to model")
+    parser.add_argument("--seconds", type=int, default=60, help="simulated time per run")
+    parser.add_argument("--interval", type=int, default=12, help="CENTRAL_CONN_INTERVAL (1.25ms units)")
+    parser.add_argument("--samples", type=int, default=20000, help="tally changes per run")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    duration_us = args.seconds * 1000000
+    print("Modelled connection-event scheduling latency (not measured on hardware)")
+    for count in args.links:
+        print("%d links:" % count)
+        summarize("peripheral", peripheral_links(count, rng), duration_us, args.samples, rng)
+        summarize("central", central_links(count, args.interval), duration_us, args.samples, rng)
+
+
+if __name__ == "__main__":
+    main()
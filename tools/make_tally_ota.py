@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""
+Build a tally firmware image for the bridge's OTA FETCH command.
+
+    make_tally_ota.py firmware.bin tally_ota.bin
+    make_tally_ota.py firmware.bin tally_ota.bin --base previous.bin
+
+The output is a TallyOtaImage header (see src/TallyProtocol.h) followed by
+the payload. The payload is raw deflate unless --no-compress is given; with
+--base it is a delta against the image the tallies are running (COPY/DATA
+ops), which is usually a fraction of the full image for small changes.
+
+Serve the file over HTTP and run "OTA FETCH http://host/tally_ota.bin" on the
+bridge, then "OTA START".
+"""
+
+import argparse
+import struct
+import zlib
+
+IMAGE_MAGIC = 0x41544F54
+FLAG_COMPRESSED = 0x01
+FLAG_DELTA = 0x02
+DELTA_COPY = 0x01
+DELTA_DATA = 0x02
+
+BLOCK = 32           # Match granularity for the delta index
+MIN_COPY = 64        # Shorter matches are cheaper as DATA
+
+
+def make_delta(base, image):
+    """Greedy COPY/DATA ops rebuilding image from base."""
+    index = {}
+    for offset in range(0, len(base) - BLOCK + 1, 4):
+        index.setdefault(base[offset:offset + BLOCK], offset)
+
+    ops = bytearray()
+    literal = bytearray()
+
+    def flush_literal():
+        if literal:
+            ops.extend(struct.pack("<BI", DELTA_DATA, len(literal)))
+            ops.extend(literal)
+            literal.clear()
+
+    pos = 0
+    while pos < len(image):
+        start = index.get(image[pos:pos + BLOCK])
+        length = 0
+        if start is not None:
+            while (pos + length < len(image) and start + length < len(base)
+                   and image[pos + length] == base[start + length]):
+                length += 1
+        if length >= MIN_COPY:
+            flush_literal()
+            ops.extend(struct.pack("<BII", DELTA_COPY, start, length))
+            pos += length
+        else:
+            literal.append(image[pos])
+            pos += 1
+    flush_literal()
+    return bytes(ops)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build a tally OTA image")
+    parser.add_argument("firmware", help="tally firmware .bin")
+    parser.add_argument("output", help="image file for OTA FETCH")
+    parser.add_argument("--base", help="firmware .bin the tallies are running (delta image)")
+    parser.add_argument("--no-compress", action="store_true", help="store the payload uncompressed")
+    args = parser.parse_args()
+
+    with open(args.firmware, "rb") as f:
+        image = f.read()
+
+    flags = 0
+    base_crc = base_size = 0
+    payload = image
+    if args.base:
+        with open(args.base, "rb") as f:
+            base = f.read()
+        payload = make_delta(base, image)
+        base_crc = zlib.crc32(base) & 0xFFFFFFFF
+        base_size = len(base)
+        flags |= FLAG_DELTA
+    if not args.no_compress:
+        deflate = zlib.compressobj(9, zlib.DEFLATED, -15)
+        payload = deflate.compress(payload) + deflate.flush()
+        flags |= FLAG_COMPRESSED
+
+    header = struct.pack("<IIIIIIB", IMAGE_MAGIC, zlib.crc32(image) & 0xFFFFFFFF, len(image),
+                         len(payload), base_crc, base_size, flags)
+    with open(args.output, "wb") as f:
+        f.write(header)
+        f.write(payload)
+
+    print("%s: %d byte image, %d byte payload (%.0f%%)%s%s" % (
+        args.output, len(image), len(payload), 100.0 * len(payload) / max(len(image), 1),
+        ", delta" if flags & FLAG_DELTA else "", ", compressed" if flags & FLAG_COMPRESSED else ""))
+
+
+if __name__ == "__main__":
+    main()